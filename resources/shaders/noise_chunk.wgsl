@@ -0,0 +1,319 @@
+// Height field chunks generated on the GPU, see NoiseCompute.
+// A port of the Noise value and cubic kernels, plain or FBM. The lattice hashes are integer exact and every float
+// operation follows the order of noise.h, so the heights match Noise::eval bit for bit unless the compiler fuses
+// multiply-adds (see Noise::BatchTolerance). Divisions are done on the CPU, WGSL doesn't round them correctly.
+
+struct NoiseParams {
+    origin: vec2f, // World position of the first bordered sample
+    detailCenter: vec2f,
+    seed: u32,
+    hash: u32, // Noise::Hash
+    noiseFunction: u32, // Noise::Function
+    interpolation: u32, // Noise::Interpolation
+    fractal: u32, // Noise::Fractal
+    octaves: u32,
+    frequency: f32,
+    lacunarity: f32,
+    gain: f32,
+    weightedStrength: f32,
+    amplitude: f32,
+    firstAmplitude: f32, // lerp(0.4, 1, 1 / octaves)
+    detailBase: f32, // Noise::octaveDetailLine
+    detailSlope: f32,
+    cullsOctaves: u32,
+    borderedSize: u32, // Samples per side, one past the mesh on every side for the normals
+};
+
+@group(0) @binding(0) var<uniform> params: NoiseParams;
+@group(0) @binding(1) var<storage, read_write> heights: array<f32>; // borderedSize^2
+@group(0) @binding(2) var<storage, read_write> vertices: array<u32>; // Vertex or CompactVertex layout
+
+const PrimeX: u32 = 501125321u;
+const PrimeY: u32 = 1136930381u;
+const PrimeZ: u32 = 1720413743u;
+const PrimeW: u32 = 0x27d4eb2du;
+
+const HashPrimeXor: u32 = 0u;
+const HashPcg: u32 = 1u;
+const HashXxHash: u32 = 2u;
+const HashShiftAdd: u32 = 3u;
+
+const FunctionValueCubic: u32 = 1u;
+const InterpolationSmoothstep: u32 = 2u;
+const InterpolationSmootherstep: u32 = 3u;
+const FractalFBM: u32 = 1u;
+
+const OctaveMean: f32 = 0.5;
+const VertexWords: u32 = 9u;
+const CompactVertexWords: u32 = 2u;
+
+
+// Hashes, see noise_hash.h
+// ----------------------------
+
+fn combine(seed: u32, xPrimed: u32, yPrimed: u32) -> u32 {
+    return ((seed + PrimeZ) ^ (xPrimed + PrimeY)) ^ (yPrimed + PrimeX);
+}
+
+fn pcgPermute(v: u32) -> u32 {
+    let state = v * 747796405u + 2891336453u;
+    let word = ((state >> 13u) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+fn xxHashMix(x: u32) -> u32 {
+    var h = x;
+    h = h ^ (h >> 15u);
+    h = h * 0x85ebca77u;
+    h = h ^ (h >> 13u);
+    h = h * 0xc2b2ae3du;
+    return h ^ (h >> 16u);
+}
+
+fn shiftAddMix(x: u32) -> u32 {
+    var h = x;
+    h = (h ^ 0xffffffffu) + (h << 15u);
+    h = h ^ (h >> 12u);
+    h = h + (h << 2u);
+    h = h ^ (h >> 4u);
+    h = (h + (h << 3u)) + (h << 11u);
+    return h ^ (h >> 16u);
+}
+
+fn hashInt(xPrimed: u32, yPrimed: u32) -> u32 {
+    switch params.hash {
+        case HashPcg: {
+            return pcgPermute(yPrimed + pcgPermute(xPrimed + params.seed));
+        }
+        case HashXxHash: {
+            return xxHashMix(combine(params.seed, xPrimed, yPrimed));
+        }
+        case HashShiftAdd: {
+            return shiftAddMix(combine(params.seed, xPrimed, yPrimed));
+        }
+        default: {
+            return combine(params.seed, xPrimed, yPrimed) * PrimeW;
+        }
+    }
+}
+
+// The low 31 bits over 2147483647.0f, which rounds to 2^31, so only the integer conversion rounds.
+// WGSL leaves the rounding of that conversion open, it is rounded to nearest even here like on the CPU.
+fn hashFloat(xPrimed: u32, yPrimed: u32) -> f32 {
+    let v = hashInt(xPrimed, yPrimed) & 0x7fffffffu;
+    if (v < 0x1000000u) {
+        return f32(v) * (1.0 / 2147483648.0);
+    }
+    let shift = firstLeadingBit(v) - 23u;
+    var mantissa = v >> shift;
+    let rest = v - (mantissa << shift);
+    let halfway = 1u << (shift - 1u);
+    if (rest > halfway || (rest == halfway && (mantissa & 1u) == 1u)) {
+        mantissa += 1u;
+    }
+    return f32(mantissa) * bitcast<f32>((96u + shift) << 23u); // 2^(shift - 31)
+}
+
+
+// Interpolation
+// ----------------------------
+
+fn lerp(a: f32, b: f32, t: f32) -> f32 {
+    return a + t * (b - a);
+}
+
+fn cubicLerp(a: f32, b: f32, c: f32, d: f32, t: f32) -> f32 {
+    let p = (d - c) - (a - b);
+    let q = (a - b) - p;
+    let r = c - a;
+    return clamp((p * t * t * t) + (q * t * t) + (r * t) + b, 0.0, 1.0);
+}
+
+// Lattice coordinate times a hash prime, wrapping like Noise::primed
+fn primed(cell: f32, prime: u32) -> u32 {
+    return bitcast<u32>(i32(cell)) * prime;
+}
+
+
+// Kernels
+// ----------------------------
+
+fn evalLinear(p: vec2f) -> f32 {
+    let cell = floor(p);
+    let x0 = primed(cell.x, PrimeX);
+    let y0 = primed(cell.y, PrimeY);
+    let x1 = x0 + PrimeX;
+    let y1 = y0 + PrimeY;
+
+    let c00 = hashFloat(x0, y0);
+    let c10 = hashFloat(x1, y0);
+    let c01 = hashFloat(x0, y1);
+    let c11 = hashFloat(x1, y1);
+
+    var t = p - cell;
+    if (params.interpolation == InterpolationSmoothstep) {
+        t = t * t * (3.0 - 2.0 * t);
+    }
+    else if (params.interpolation == InterpolationSmootherstep) {
+        t = t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+    }
+
+    let top = lerp(c00, c10, t.x);
+    let bot = lerp(c01, c11, t.x);
+    return lerp(top, bot, t.y);
+}
+
+fn cubicRow(x1: u32, y: u32, t: f32) -> f32 {
+    let x0 = x1 - PrimeX;
+    let x2 = x1 + PrimeX;
+    let x3 = x2 + PrimeX;
+    return cubicLerp(hashFloat(x0, y), hashFloat(x1, y), hashFloat(x2, y), hashFloat(x3, y), t);
+}
+
+fn evalCubic(p: vec2f) -> f32 {
+    let cell = floor(p);
+    let t = p - cell;
+    let x1 = primed(cell.x, PrimeX);
+    let y1 = primed(cell.y, PrimeY);
+    let y0 = y1 - PrimeY;
+    let y2 = y1 + PrimeY;
+    let y3 = y2 + PrimeY;
+
+    let r0 = cubicRow(x1, y0, t.x);
+    let r1 = cubicRow(x1, y1, t.x);
+    let r2 = cubicRow(x1, y2, t.x);
+    let r3 = cubicRow(x1, y3, t.x);
+    return cubicLerp(r0, r1, r2, r3, t.y);
+}
+
+fn evalFunction(p: vec2f) -> f32 {
+    if (params.noiseFunction == FunctionValueCubic) {
+        return evalCubic(p);
+    }
+    return evalLinear(p);
+}
+
+// Noise::octaveDetail, any value of at least octaves keeps every octave
+fn octaveDetail(p: vec2f) -> f32 {
+    let d = p - params.detailCenter;
+    let distanceSquared = dot(d, d);
+    if (params.cullsOctaves == 0u || distanceSquared <= 0.0) {
+        return f32(params.octaves);
+    }
+    return params.detailBase - params.detailSlope * log2(distanceSquared);
+}
+
+// Noise::sumOctaves for FBM
+fn evalFBm(p: vec2f, detail: f32) -> f32 {
+    var amp = params.firstAmplitude;
+    var freq = 1.0;
+    var sum = 0.0;
+
+    for (var i = 0u; i < params.octaves; i++) {
+        var noise = OctaveMean;
+        let fade = clamp(detail - f32(i), 0.0, 1.0);
+        if (fade > 0.0) {
+            noise = evalFunction(p * freq);
+            if (fade < 1.0) {
+                noise = lerp(OctaveMean, noise, fade);
+            }
+        }
+        sum += amp * noise;
+
+        amp *= lerp(1.0, noise * 0.5, params.weightedStrength);
+        amp *= params.gain;
+        freq *= params.lacunarity;
+    }
+
+    return clamp(sum, 0.0, 1.0);
+}
+
+fn sampleNoise(p: vec2f) -> f32 {
+    var out: f32;
+    if (params.fractal == FractalFBM) {
+        out = evalFBm(p * params.frequency, octaveDetail(p));
+    }
+    else {
+        out = evalFunction(p * params.frequency);
+    }
+    return out * params.amplitude;
+}
+
+
+// Entry points
+// ----------------------------
+
+// One height per bordered sample
+@compute @workgroup_size(8, 8)
+fn heights_main(@builtin(global_invocation_id) id: vec3u) {
+    let size = params.borderedSize;
+    if (id.x >= size || id.y >= size) {
+        return;
+    }
+    heights[id.y * size + id.x] = sampleNoise(params.origin + vec2f(f32(id.x), f32(id.y)));
+}
+
+// Like the bordered Mesh constructor: the normal from the four neighbouring heights of bordered sample i
+fn gridNormal(i: u32) -> vec3f {
+    let size = params.borderedSize;
+    let left = heights[i - 1u];
+    let right = heights[i + 1u];
+    let up = heights[i + size];
+    let down = heights[i - size];
+    return normalize(vec3f(left - right, 2.0, down - up));
+}
+
+// One vertex per mesh sample
+@compute @workgroup_size(8, 8)
+fn vertices_main(@builtin(global_invocation_id) id: vec3u) {
+    let size = params.borderedSize;
+    let meshSize = size - 2u;
+    if (id.x >= meshSize || id.y >= meshSize) {
+        return;
+    }
+
+    let i = (id.y + 1u) * size + id.x + 1u;
+    let normal = gridNormal(i);
+
+    let r = f32(id.x) / f32(meshSize);
+    let g = f32(id.y) / f32(meshSize);
+    let b = (1.0 - g) * (1.0 - r);
+
+    let v = (id.y * meshSize + id.x) * VertexWords;
+    vertices[v + 0u] = bitcast<u32>(f32(id.x));
+    vertices[v + 1u] = bitcast<u32>(heights[i]);
+    vertices[v + 2u] = bitcast<u32>(f32(id.y));
+    vertices[v + 3u] = bitcast<u32>(normal.x);
+    vertices[v + 4u] = bitcast<u32>(normal.y);
+    vertices[v + 5u] = bitcast<u32>(normal.z);
+    vertices[v + 6u] = bitcast<u32>(r);
+    vertices[v + 7u] = bitcast<u32>(g);
+    vertices[v + 8u] = bitcast<u32>(b);
+}
+
+// CompactVertex::pack: octahedral normal around +y, the lower hemisphere folded over the diagonals
+fn octahedral(normal: vec3f) -> vec2f {
+    let n = normal / (abs(normal.x) + abs(normal.y) + abs(normal.z));
+    let p = n.xz;
+    if (n.y >= 0.0) {
+        return p;
+    }
+    return (1.0 - abs(p.yx)) * select(vec2f(-1.0), vec2f(1.0), p >= vec2f(0.0));
+}
+
+// One CompactVertex per mesh sample, the color is derived by the vertex shader
+@compute @workgroup_size(8, 8)
+fn compact_vertices_main(@builtin(global_invocation_id) id: vec3u) {
+    let size = params.borderedSize;
+    let meshSize = size - 2u;
+    if (id.x >= meshSize || id.y >= meshSize) {
+        return;
+    }
+
+    let i = (id.y + 1u) * size + id.x + 1u;
+    let encoded = octahedral(gridNormal(i));
+
+    let v = (id.y * meshSize + id.x) * CompactVertexWords;
+    vertices[v + 0u] = id.x | (id.y << 16u);
+    vertices[v + 1u] = (pack2x16float(vec2f(heights[i], 0.0)) & 0xffffu) | (pack4x8snorm(vec4f(0.0, 0.0, encoded)) & 0xffff0000u);
+}
@@ -12,6 +12,12 @@ struct VertexInput {
     @location(2) color: vec3f,
 }
 
+// CompactVertex, see types.h
+struct CompactVertexInput {
+    @location(0) grid: vec2u, // Local column and row
+    @location(1) packed: u32, // Half float height in the low bits, snorm octahedral normal in the high bits
+}
+
 
 // Number of Components forwarded to fragment shader is three float components.
 // Pos is handled automatically, but color is not because the location is a number value.
@@ -30,6 +36,8 @@ struct ShaderUniforms {
     viewMatrix: mat4x4f,
     modelMatrix: mat4x4f,
     color: vec4f,
+    lightPosition: vec4f,
+    grid: vec4f, // x: vertices per side of the mesh
 };
 
 // Instead of the simple uTime variable, our uniform variable is a struct
@@ -37,21 +45,23 @@ struct ShaderUniforms {
 
 
 
-@vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
+// Lit vertex of a chunk
+fn shade(in: VertexInput) -> VertexOutput {
 	var out: VertexOutput;
-	out.position = uShaderUniforms.projectionMatrix * uShaderUniforms.viewMatrix * uShaderUniforms.modelMatrix * vec4f(in.position.xyz,  1.0);
+	// Vertex positions are relative to the chunk, the model matrix moves them relative to the render origin
+	var position = uShaderUniforms.modelMatrix * vec4f(in.position.xyz,  1.0);
+	out.position = uShaderUniforms.projectionMatrix * uShaderUniforms.viewMatrix * position;
 //	out.color = in.color * (in.position.y * 0.1f);
     var norm = in.normal * 0.5 + 0.5;
 
-    var lightPos = vec3f(50.0, 30.0, 0.0);
+    var lightPos = uShaderUniforms.lightPosition.xyz;
 
     var ambientStrength = 0.3f;
 
     var ambient = ambientStrength * in.color;
 //    var ambient = ambientStrength * in.normal;
 
-    var lightDir = normalize(lightPos - in.position.xyz);
+    var lightDir = normalize(lightPos - position.xyz);
     var diff = max(dot(in.normal, lightDir), 0.0);
 
     var diffuse = diff * in.color;
@@ -64,6 +74,33 @@ fn vs_main(in: VertexInput) -> VertexOutput {
 	return out;
 }
 
+// Inverse of the octahedral encoding around +y in CompactVertex::pack
+fn octahedralNormal(e: vec2f) -> vec3f {
+    var n = vec3f(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    let t = max(-n.y, 0.0);
+    n.x += select(t, -t, n.x >= 0.0);
+    n.z += select(t, -t, n.z >= 0.0);
+    return normalize(n);
+}
+
+@vertex
+fn vs_main(in: VertexInput) -> VertexOutput {
+	return shade(in);
+}
+
+// Height field chunks with compact vertices, the color is the one the Mesh constructors store in Vertex
+@vertex
+fn vs_compact(in: CompactVertexInput) -> VertexOutput {
+	let grid = vec2f(in.grid);
+	let rg = grid / uShaderUniforms.grid.x;
+
+	var vertex: VertexInput;
+	vertex.position = vec3f(grid.x, unpack2x16float(in.packed).x, grid.y);
+	vertex.normal = octahedralNormal(unpack4x8snorm(in.packed).zw);
+	vertex.color = vec3f(rg, (1.0 - rg.y) * (1.0 - rg.x));
+	return shade(vertex);
+}
+
 @fragment
 fn fs_main(in: VertexOutput) -> @location(0) vec4f {
 
@@ -12,6 +12,7 @@
 
 std::unique_ptr<wgpu::Device> Application::device = nullptr;
 std::unique_ptr<wgpu::Queue> Application::queue = nullptr;
+wgpu::Limits Application::limits{};
 
 wgpu::TextureFormat Application::swapChainFormat = wgpu::TextureFormat::BGRA8Unorm;
 wgpu::TextureFormat Application::depthTextureFormat = wgpu::TextureFormat::Depth24Plus;
@@ -270,30 +271,21 @@ void Application::initWindowAndDevice() {
 	std::cout << "Requesting device..." << std::endl;
 
 	// Set required limits for the device.
+	// Everything the adapter supports, the chunk size is then only bounded by the buffer sizes of the hardware,
+	// see Terrain::checkChunkSize
 	wgpu::RequiredLimits requiredLimits = wgpu::Default; // Don't forget to set to default first!
-	requiredLimits.limits.maxVertexAttributes = 3; // Imgui uses 3
-	requiredLimits.limits.maxVertexBuffers = 8;
-	// Maximum size of a buffer is 6 vertices of 2 float each
-	requiredLimits.limits.maxBufferSize = 150000 * sizeof(float);
-	// Maximum stride between 2 consecutive vertices in the vertex buffer
-	requiredLimits.limits.maxVertexBufferArrayStride = sizeof(Vertex); // Needs to be 5 for imgui
-
-	// Must be set even if we do not use storage or uniform buffers for now
-	requiredLimits.limits.minStorageBufferOffsetAlignment = supportedLimits.limits.minStorageBufferOffsetAlignment;
-	requiredLimits.limits.minUniformBufferOffsetAlignment = supportedLimits.limits.minUniformBufferOffsetAlignment;
-	requiredLimits.limits.maxInterStageShaderComponents = 6; // 6 used by imgui, 3 by us
-	requiredLimits.limits.maxBindGroups = 4; // Required to be at least 2 for ImGui
-
-	requiredLimits.limits.maxUniformBuffersPerShaderStage = 1;
-	requiredLimits.limits.maxUniformBufferBindingSize = 16 * 4 * sizeof(float);
-
-
-	// Allow textures up to 2K
-	requiredLimits.limits.maxTextureDimension1D = 2048;
-	requiredLimits.limits.maxTextureDimension2D = 2048;
-	requiredLimits.limits.maxTextureArrayLayers = 1;
-	requiredLimits.limits.maxSampledTexturesPerShaderStage = 1;
-	requiredLimits.limits.maxSamplersPerShaderStage = 1;
+	requiredLimits.limits = supportedLimits.limits;
+
+	// What the renderer can't run without
+	const wgpu::Limits &supported = supportedLimits.limits;
+	if (supported.maxVertexAttributes < 3 // Imgui uses 3
+			|| supported.maxVertexBufferArrayStride < sizeof(Vertex)
+			|| supported.maxInterStageShaderComponents < 6 // 6 used by imgui, 3 by us
+			|| supported.maxBindGroups < 2 // Required to be at least 2 for ImGui
+			|| supported.maxStorageBuffersPerShaderStage < 2 // Heights and vertices of the noise compute pass
+			|| supported.maxUniformBufferBindingSize < sizeof(ShaderUniforms)) {
+		throw std::runtime_error("The adapter doesn't support the limits the renderer needs!");
+	}
 
 
 
@@ -318,6 +310,8 @@ void Application::initWindowAndDevice() {
 
 	Application::device->getLimits(&supportedLimits);
 	std::cout << "device.maxVertexAttributes: " << supportedLimits.limits.maxVertexAttributes << std::endl;
+	std::cout << "device.maxBufferSize: " << supportedLimits.limits.maxBufferSize << std::endl;
+	limits = supportedLimits.limits;
 
 
 	// Set swapChain format by querying the surface
@@ -615,10 +609,10 @@ void Application::updateGui(wgpu::RenderPassEncoder renderPass) {
 
 	bool updateTerrain = false;
 
-	const char* items[] = { "Linear", "SmoothStep", "Smoother", "Cubic" };
+	const char* items[] = { "Linear", "SmoothStep", "Smoother", "Cubic", "Perlin", "Simplex", "Cellular" };
 
 	static int noiseFunction = 0;
-	if (ImGui::Combo("Function", &noiseFunction, items, 4)) {
+	if (ImGui::Combo("Function", &noiseFunction, items, 7)) {
 		std::cout << "Changing Function" << std::endl;
 		switch (noiseFunction) {
 		case 0:
@@ -640,19 +634,60 @@ void Application::updateGui(wgpu::RenderPassEncoder renderPass) {
 			std::cout << "Cubic" << std::endl;
 			noiseDesc.function = Noise::Function::ValueCubic;
 			break;
+		case 4:
+			std::cout << "Perlin" << std::endl;
+			noiseDesc.function = Noise::Function::Perlin;
+			break;
+		case 5:
+			std::cout << "Simplex" << std::endl;
+			noiseDesc.function = Noise::Function::Simplex;
+			break;
+		case 6:
+			std::cout << "Cellular" << std::endl;
+			noiseDesc.function = Noise::Function::Cellular;
+			break;
 		}
 		updateTerrain = true;
 	}
 
+	if (noiseDesc.function == Noise::Function::Cellular) {
+		const char* distances[] = { "Euclidean", "Euclidean Squared", "Manhattan" };
+		int cellularDistance = noiseDesc.cellularDistance;
+		if (ImGui::Combo("Distance", &cellularDistance, distances, 3)) {
+			noiseDesc.cellularDistance = static_cast<Noise::CellularDistance>(cellularDistance);
+			updateTerrain = true;
+		}
 
-	static bool fbm = false;
-	if (ImGui::Checkbox("FBM", &fbm)) {
-		if (fbm) {
-			noiseDesc.fractal = Noise::Fractal::FBM;
+		const char* returns[] = { "F1", "F2", "F2 - F1" };
+		int cellularReturn = noiseDesc.cellularReturn;
+		if (ImGui::Combo("Return", &cellularReturn, returns, 3)) {
+			noiseDesc.cellularReturn = static_cast<Noise::CellularReturn>(cellularReturn);
+			updateTerrain = true;
 		}
-		else {
-			noiseDesc.fractal = Noise::Fractal::None;
+	}
+
+
+	const char* fractals[] = { "None", "FBM", "Ridged", "Turbulence", "Domain Warp" };
+	int fractal = noiseDesc.fractal;
+	if (ImGui::Combo("Fractal", &fractal, fractals, 5)) {
+		noiseDesc.fractal = static_cast<Noise::Fractal>(fractal);
+		updateTerrain = true;
+	}
+
+	if (noiseDesc.fractal == Noise::Fractal::DomainWarp) {
+		if (ImGui::SliderFloat("Warp Frequency", &noiseDesc.warpFrequency, 0.1f, 2.0f)) {
+			updateTerrain = true;
 		}
+
+		if (ImGui::SliderFloat("Warp Amplitude", &noiseDesc.warpAmplitude, 0.0f, 32.0f)) {
+			updateTerrain = true;
+		}
+	}
+
+	const char* hashes[] = { "Prime XOR", "PCG", "xxHash", "Shift Add", "Permutation Table" };
+	int hash = noiseDesc.hash;
+	if (ImGui::Combo("Hash", &hash, hashes, 5)) {
+		noiseDesc.hash = static_cast<Noise::Hash>(hash);
 		updateTerrain = true;
 	}
 
@@ -680,11 +715,74 @@ void Application::updateGui(wgpu::RenderPassEncoder renderPass) {
 		updateTerrain = true;
 	}
 
+	if (ImGui::SliderFloat("Octave Tolerance", &noiseDesc.octaveTolerance, 0.0f, 0.01f, "%.4f")) {
+		updateTerrain = true;
+	}
+
+	// Octave culling with distance to the center chunk, 0 keeps every octave everywhere
+	float featureSizeFalloff = world->terrain->getFeatureSizeFalloff();
+	if (ImGui::SliderFloat("Feature Size Falloff", &featureSizeFalloff, 0.0f, 0.02f, "%.5f")) {
+		world->terrain->setFeatureSizeFalloff(featureSizeFalloff);
+	}
+
+	bool octaveLayerCache = world->terrain->isOctaveLayerCache();
+	if (ImGui::Checkbox("Octave Layer Cache", &octaveLayerCache)) {
+		world->terrain->setOctaveLayerCache(octaveLayerCache);
+	}
+
 	bool wireFrame = world->terrain->isWireFrame();
 	if (ImGui::Checkbox("WireFrame", &wireFrame)) {            // Edit bools storing our window open/close state
 		world->terrain->setWireFrame(wireFrame);
 	}
 
+	// Value and cubic noise height fields from the compute shader instead of the CPU
+	bool gpuGeneration = world->terrain->isGpuGeneration();
+	if (ImGui::Checkbox("GPU Generation", &gpuGeneration)) {
+		world->terrain->setGpuGeneration(gpuGeneration);
+	}
+
+	// 8 byte height field vertices instead of 36
+	bool compactVertices = world->terrain->isCompactVertices();
+	if (ImGui::Checkbox("Compact Vertices", &compactVertices)) {
+		world->terrain->setCompactVertices(compactVertices);
+	}
+
+	// What the chunks keep on the CPU after the upload
+	const char* residencies[] = { "Full", "GPU Only", "GPU + Height Field" };
+	int residency = static_cast<int>(world->terrain->getResidency());
+	if (ImGui::Combo("Mesh Residency", &residency, residencies, 3)) {
+		world->terrain->setResidency(static_cast<Terrain::Residency>(residency));
+	}
+
+	// 3D density chunks with overhangs and caves instead of height fields
+	static DensityChunk::Settings densitySettings;
+	bool density = world->terrain->isDensity();
+	bool updateDensity = ImGui::Checkbox("Caves (3D Density)", &density);
+	if (density) {
+		updateDensity |= ImGui::SliderFloat("Ground Height", &densitySettings.groundHeight, -32.0f, 32.0f);
+		updateDensity |= ImGui::SliderFloat("Height Gradient", &densitySettings.heightGradient, 0.05f, 2.0f);
+	}
+	if (updateDensity) {
+		world->terrain->setDensity(density ? std::optional(densitySettings) : std::nullopt);
+	}
+
+	// Height field chunks cut out of a tileable FFT height map instead of the noise above, any noise edit goes back
+	static SpectralNoise::Descriptor spectralDesc;
+	bool spectral = world->terrain->isSpectral();
+	bool updateSpectral = ImGui::Checkbox("Spectral Tile", &spectral);
+	if (spectral) {
+		updateSpectral |= ImGui::SliderFloat("Spectral Exponent", &spectralDesc.spectralExponent, 1.0f, 4.0f);
+	}
+	if (updateSpectral) {
+		if (spectral) {
+			spectralDesc.amplitude = noiseDesc.amplitude;
+			world->terrain->setNoise(SpectralNoise(spectralDesc));
+		}
+		else {
+			world->terrain->setNoise(noiseDesc);
+		}
+	}
+
     if (updateTerrain) {
         world->terrain->setNoise(noiseDesc);
     }
@@ -726,22 +824,22 @@ void Application::onKey([[maybe_unused]] Input::Key key,[[maybe_unused]] Input::
 	// Move the camera using W A S D
 	if (key == Input::Key::W) {
 		if (buttonAction == Input::Action::Repeat || buttonAction == Input::Action::Press) {
-			world->camera.center += glm::vec3{0.0f, 0.0f, 1.0f};
+			world->camera.center += glm::dvec3{0.0, 0.0, 1.0};
 		}
 	}
 	if (key == Input::Key::S) {
 		if (buttonAction == Input::Action::Press || buttonAction == Input::Action::Repeat) {
-			world->camera.center += glm::vec3{0.0f, 0.0f, -1.0f};
+			world->camera.center += glm::dvec3{0.0, 0.0, -1.0};
 		}
 	}
 	if (key == Input::Key::A) {
 		if (buttonAction == Input::Action::Press || buttonAction == Input::Action::Repeat) {
-			world->camera.center += glm::vec3{-1.0f, 0.0f, 0.0f};
+			world->camera.center += glm::dvec3{-1.0, 0.0, 0.0};
 		}
 	}
 	if (key == Input::Key::D) {
 		if (buttonAction == Input::Action::Press || buttonAction == Input::Action::Repeat) {
-			world->camera.center += glm::vec3{1.0f, 0.0f, 0.0f};
+			world->camera.center += glm::dvec3{1.0, 0.0, 0.0};
 		}
 	}
 	updateViewMatrix();
@@ -787,6 +885,9 @@ void Application::onScroll(glm::vec2 scrollOffset, [[maybe_unused]] glm::vec2 mo
 }
 
 void Application::updateViewMatrix() {
+	if (world->camera.rebase()) {
+		world->terrain->setRenderOrigin(world->camera.origin);
+	}
 	world->terrain->uniforms.viewMatrix = world->camera.updateViewMatrix();
 
 //	Application::queue->writeBuffer(
@@ -805,4 +906,14 @@ void Application::updateViewMatrix() {
 		);
 	}
 
+	for (auto& [key, chunk] : world->terrain->densityChunks) {
+		chunk.mesh.uniforms.viewMatrix = world->terrain->uniforms.viewMatrix;
+		Application::queue->writeBuffer(
+				chunk.mesh.uniformBuffer,
+				offsetof(ShaderUniforms, viewMatrix),
+				&chunk.mesh.uniforms.viewMatrix,
+				sizeof(ShaderUniforms::viewMatrix)
+		);
+	}
+
 }
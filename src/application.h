@@ -23,6 +23,7 @@ public:
 
 	static std::unique_ptr<wgpu::Device> device;
 	static std::unique_ptr<wgpu::Queue> queue;
+	static wgpu::Limits limits; // Of the device, everything the adapter supports
 
 	static wgpu::TextureFormat swapChainFormat;
 	static wgpu::TextureFormat depthTextureFormat;
@@ -10,7 +10,16 @@ glm::mat4 Camera::updateViewMatrix() {
 	float cosTheta = cos(rotation.y);
 	float sinTheta = sin(rotation.y);
 
-	position = glm::vec3(sinTheta * sinPhi,  cosTheta, sinTheta * cosPhi) * std::exp(-zoom);
+	position = glm::dvec3(glm::vec3(sinTheta * sinPhi,  cosTheta, sinTheta * cosPhi) * std::exp(-zoom));
 	position += center;
-	return glm::lookAt(position, center, glm::vec3(0, 1, 0));
+	return glm::lookAt(relative(position), relative(center), glm::vec3(0, 1, 0));
+}
+
+bool Camera::rebase() {
+	glm::dvec3 offset = center - origin;
+	if (glm::dot(offset, offset) < RebaseDistance * RebaseDistance) {
+		return false;
+	}
+	origin = glm::floor(center);
+	return true;
 }
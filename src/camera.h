@@ -23,20 +23,35 @@ class Camera {
 public:
 	Camera();
 
+	// Distance the camera center moves from the render origin before the origin is rebased onto it
+	static constexpr double RebaseDistance = 1024.0;
+
+	// View matrix relative to origin, so only small offsets reach the GPU at any distance
 	glm::mat4 updateViewMatrix();
 
+	// Moves origin onto the center once it is RebaseDistance away, true when it moved
+	bool rebase();
+
+	// Offset of a world position from origin, small near the camera
+	glm::vec3 relative(glm::dvec3 worldPosition) const {
+		return glm::vec3(worldPosition - origin);
+	}
+
 
 	// in radians
 	glm::vec2 rotation = glm::vec2(0.0f, glm::radians(45.0f));
 
 	DragState dragState;
 
-	glm::vec3 position{};
+	glm::dvec3 position{};
 
 	// Zoom is the position of the camera along its local forward axis, affected by scroll
 	float zoom = 0.0f;
 
-	glm::vec3 center{};
+	glm::dvec3 center{};
+
+	// World position the view and the chunk model matrices are relative to
+	glm::dvec3 origin{};
 private:
 
 };
@@ -1 +1,1040 @@
 #include "noise.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+namespace {
+
+	// Lattice index times a hash prime, wrapping like the scalar path
+	int primed(int v, int prime) {
+		return static_cast<int>(static_cast<uint32_t>(v) * static_cast<uint32_t>(prime));
+	}
+
+	// Hash count consecutive lattice points of row y, starting at x0
+	template<class H>
+	void hashLatticeRow(const NoiseHash::ScalarKey &key, int y, int x0, int count, float *out) {
+		int yPrimed = primed(y, Noise::PrimeY);
+		for (int k = 0; k < count; k++) {
+			out[k] = NoiseHash::hashFloat<H>(key, primed(x0 + k, Noise::PrimeX), yPrimed);
+		}
+	}
+
+	template<Noise::Interpolation I>
+	glm::vec2 interpolateDerivative(glm::vec2 t) {
+		if constexpr (I == Noise::Interpolation::Smoothstep) {
+			return Noise::smoothStepDerivative(t);
+		}
+		else if constexpr (I == Noise::Interpolation::Smootherstep) {
+			return Noise::smootherStepDerivative(t);
+		}
+		else {
+			return glm::vec2(1.0f);
+		}
+	}
+
+	template<Noise::Interpolation I>
+	glm::vec2 interpolate(glm::vec2 t) {
+		if constexpr (I == Noise::Interpolation::Smoothstep) {
+			return Noise::smoothStep(t);
+		}
+		else if constexpr (I == Noise::Interpolation::Smootherstep) {
+			return Noise::smootherStep(t);
+		}
+		else {
+			return t;
+		}
+	}
+
+	// Small ring of x-interpolated lattice rows keyed by lattice y.
+	// Rows are built on first use, so walking a grid top to bottom builds every lattice row once.
+	class LatticeRows {
+	public:
+		LatticeRows(int slots, int width) : slots(slots), width(width), keys(slots, INT_MIN), rows(slots * width) {}
+
+		template<class Build>
+		const float *get(int y, Build &&build) {
+			int slot = ((y % slots) + slots) % slots;
+			float *row = &rows[slot * width];
+			if (keys[slot] != y) {
+				build(y, row);
+				keys[slot] = y;
+			}
+			return row;
+		}
+
+	private:
+		int slots;
+		int width;
+		std::vector<int> keys;
+		std::vector<float> rows;
+	};
+
+	// Lattice cell and position inside the cell for every column
+	struct LatticeColumns {
+		std::vector<int> cell;
+		std::vector<float> frac;
+		int minCell = INT_MAX;
+		int maxCell = INT_MIN;
+
+		LatticeColumns(const float *xs, int width) : cell(width), frac(width) {
+			for (int col = 0; col < width; col++) {
+				cell[col] = int(glm::floor(xs[col]));
+				frac[col] = glm::fract(xs[col]);
+				minCell = std::min(minCell, cell[col]);
+				maxCell = std::max(maxCell, cell[col]);
+			}
+		}
+	};
+
+	template<class H, Noise::Interpolation I>
+	void latticeLinear(const NoiseHash::ScalarKey &key, const float *xs, int width, const float *ys, int height, float *out) {
+		LatticeColumns columns(xs, width);
+		std::vector<float> weights(width);
+		for (int col = 0; col < width; col++) {
+			weights[col] = interpolate<I>(glm::vec2(columns.frac[col])).x;
+		}
+
+		int span = columns.maxCell - columns.minCell + 2;
+		std::vector<float> hashes(span);
+
+		// Row y interpolated along x, the "top"/"bot" values of evalLinear
+		auto build = [&](int y, float *row) {
+			hashLatticeRow<H>(key, y, columns.minCell, span, hashes.data());
+			for (int col = 0; col < width; col++) {
+				int k = columns.cell[col] - columns.minCell;
+				row[col] = Noise::lerp(hashes[k], hashes[k + 1], weights[col]);
+			}
+		};
+
+		LatticeRows rows(2, width);
+		for (int row = 0; row < height; row++) {
+			int cell = int(glm::floor(ys[row]));
+			float weight = interpolate<I>(glm::vec2(glm::fract(ys[row]))).y;
+
+			const float *top = rows.get(cell, build);
+			const float *bot = rows.get(cell + 1, build);
+
+			float *dst = out + static_cast<size_t>(row) * width;
+			for (int col = 0; col < width; col++) {
+				dst[col] = Noise::lerp(top[col], bot[col], weight);
+			}
+		}
+	}
+
+	template<class H>
+	void latticeCubic(const NoiseHash::ScalarKey &key, const float *xs, int width, const float *ys, int height, float *out) {
+		LatticeColumns columns(xs, width);
+
+		// One lattice point before the first cell to two after the last
+		int span = columns.maxCell - columns.minCell + 4;
+		std::vector<float> hashes(span);
+
+		// Row y interpolated along x, the r0..r3 values of evalCubic
+		auto build = [&](int y, float *row) {
+			hashLatticeRow<H>(key, y, columns.minCell - 1, span, hashes.data());
+			for (int col = 0; col < width; col++) {
+				int k = columns.cell[col] - columns.minCell;
+				row[col] = Noise::cubicLerp(hashes[k], hashes[k + 1], hashes[k + 2], hashes[k + 3], columns.frac[col]);
+			}
+		};
+
+		LatticeRows rows(4, width);
+		for (int row = 0; row < height; row++) {
+			int cell = int(glm::floor(ys[row]));
+			float yFrac = glm::fract(ys[row]);
+
+			const float *r0 = rows.get(cell - 1, build);
+			const float *r1 = rows.get(cell, build);
+			const float *r2 = rows.get(cell + 1, build);
+			const float *r3 = rows.get(cell + 2, build);
+
+			float *dst = out + static_cast<size_t>(row) * width;
+			for (int col = 0; col < width; col++) {
+				dst[col] = Noise::cubicLerp(r0[col], r1[col], r2[col], r3[col], yFrac);
+			}
+		}
+	}
+
+	// latticeLinear with the derivatives of Noise::evalLinearDerivative. Rows keep the x derivative next to the value.
+	template<class H, Noise::Interpolation I>
+	void latticeLinearDerivative(const NoiseHash::ScalarKey &key, const float *xs, int width, const float *ys, int height, float *out, float *outDx, float *outDy) {
+		LatticeColumns columns(xs, width);
+		std::vector<float> weights(width);
+		std::vector<float> slopes(width);
+		for (int col = 0; col < width; col++) {
+			weights[col] = interpolate<I>(glm::vec2(columns.frac[col])).x;
+			slopes[col] = interpolateDerivative<I>(glm::vec2(columns.frac[col])).x;
+		}
+
+		int span = columns.maxCell - columns.minCell + 2;
+		std::vector<float> hashes(span);
+
+		auto build = [&](int y, float *row) {
+			hashLatticeRow<H>(key, y, columns.minCell, span, hashes.data());
+			for (int col = 0; col < width; col++) {
+				int k = columns.cell[col] - columns.minCell;
+				row[col] = Noise::lerp(hashes[k], hashes[k + 1], weights[col]);
+				row[width + col] = hashes[k + 1] - hashes[k];
+			}
+		};
+
+		LatticeRows rows(2, width * 2);
+		for (int row = 0; row < height; row++) {
+			int cell = int(glm::floor(ys[row]));
+			glm::vec2 frac(glm::fract(ys[row]));
+			float weight = interpolate<I>(frac).y;
+			float slope = interpolateDerivative<I>(frac).y;
+
+			const float *top = rows.get(cell, build);
+			const float *bot = rows.get(cell + 1, build);
+
+			size_t offset = static_cast<size_t>(row) * width;
+			for (int col = 0; col < width; col++) {
+				out[offset + col] = Noise::lerp(top[col], bot[col], weight);
+				outDx[offset + col] = Noise::lerp(top[width + col], bot[width + col], weight) * slopes[col];
+				outDy[offset + col] = (bot[col] - top[col]) * slope;
+			}
+		}
+	}
+
+	// latticeCubic with the derivatives of Noise::evalCubicDerivative. Rows keep the x derivative next to the value.
+	template<class H>
+	void latticeCubicDerivative(const NoiseHash::ScalarKey &key, const float *xs, int width, const float *ys, int height, float *out, float *outDx, float *outDy) {
+		LatticeColumns columns(xs, width);
+
+		int span = columns.maxCell - columns.minCell + 4;
+		std::vector<float> hashes(span);
+
+		auto build = [&](int y, float *row) {
+			hashLatticeRow<H>(key, y, columns.minCell - 1, span, hashes.data());
+			for (int col = 0; col < width; col++) {
+				int k = columns.cell[col] - columns.minCell;
+				glm::vec2 v = Noise::cubicLerpWithDerivative(hashes[k], hashes[k + 1], hashes[k + 2], hashes[k + 3], columns.frac[col]);
+				row[col] = v.x;
+				row[width + col] = v.y;
+			}
+		};
+
+		LatticeRows rows(4, width * 2);
+		for (int row = 0; row < height; row++) {
+			int cell = int(glm::floor(ys[row]));
+			float yFrac = glm::fract(ys[row]);
+			glm::vec4 w = Noise::cubicLerpWeights(yFrac);
+
+			const float *r0 = rows.get(cell - 1, build);
+			const float *r1 = rows.get(cell, build);
+			const float *r2 = rows.get(cell + 1, build);
+			const float *r3 = rows.get(cell + 2, build);
+
+			size_t offset = static_cast<size_t>(row) * width;
+			for (int col = 0; col < width; col++) {
+				glm::vec2 v = Noise::cubicLerpWithDerivative(r0[col], r1[col], r2[col], r3[col], yFrac);
+				bool inside = v.x > 0.0f && v.x < 1.0f;
+				out[offset + col] = v.x;
+				outDx[offset + col] = inside ? w.x * r0[width + col] + w.y * r1[width + col] + w.z * r2[width + col] + w.w * r3[width + col] : 0.0f;
+				outDy[offset + col] = v.y;
+			}
+		}
+	}
+
+	// Lattice walking derivative path, only where Noise::resolveDerivative has an analytic kernel
+	template<class H>
+	Noise::LatticeDerivativeFn resolveLatticeDerivative(const Noise::Descriptor &descriptor) {
+		if (descriptor.fractal != Noise::Fractal::None && descriptor.fractal != Noise::Fractal::FBM) {
+			return nullptr;
+		}
+
+		switch (descriptor.function) {
+			case Noise::Function::Value:
+				switch (descriptor.interpolation) {
+					case Noise::Interpolation::Smoothstep:
+						return &latticeLinearDerivative<H, Noise::Interpolation::Smoothstep>;
+					case Noise::Interpolation::Smootherstep:
+						return &latticeLinearDerivative<H, Noise::Interpolation::Smootherstep>;
+					default:
+						return &latticeLinearDerivative<H, Noise::Interpolation::Linear>;
+				}
+			case Noise::Function::ValueCubic:
+				return &latticeCubicDerivative<H>;
+			default:
+				return nullptr;
+		}
+	}
+
+	// Catmull-Rom weights of the four taps around [b, c] at t
+	glm::vec4 catmullRomWeights(float t) {
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return {
+			0.5f * (-t3 + 2.0f * t2 - t),
+			0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f),
+			0.5f * (-3.0f * t3 + 4.0f * t2 + t),
+			0.5f * (t3 - t2)
+		};
+	}
+
+	// Largest Catmull-Rom upsampling error of one raw octave sampled every c lattice cells, coefficient * c^order.
+	// Measured over the [0, 1] output of each function. Kinks (linear interpolation, cubic clamping, cell borders)
+	// keep the error first order, the smoothest functions reach third order.
+	struct UpsamplingError {
+		int order;
+		float coefficient;
+	};
+
+	UpsamplingError upsamplingError(const Noise::Descriptor &descriptor) {
+		switch (descriptor.function) {
+			case Noise::Function::Value:
+				switch (descriptor.interpolation) {
+					case Noise::Interpolation::Smoothstep:
+						return {2, 0.6f};
+					case Noise::Interpolation::Smootherstep:
+						return {3, 1.4f};
+					default:
+						return {1, 0.45f};
+				}
+			case Noise::Function::ValueCubic:
+				return {1, 0.4f};
+			case Noise::Function::Perlin:
+				return {3, 1.6f};
+			case Noise::Function::Simplex:
+				return {3, 10.0f};
+			default:
+				return {1, 0.55f};
+		}
+	}
+
+	// Mirrors Noise::resolveSample for the functions that have a lattice walking path
+	template<class H>
+	Noise::LatticeFn resolveLattice(const Noise::Descriptor &descriptor) {
+		// Domain warped samples no longer line up with the lattice rows
+		if (descriptor.fractal == Noise::Fractal::DomainWarp) {
+			return nullptr;
+		}
+
+		switch (descriptor.function) {
+			case Noise::Function::ValueCubic:
+				return &latticeCubic<H>;
+			case Noise::Function::Perlin:
+			case Noise::Function::Simplex:
+			case Noise::Function::Cellular:
+				return nullptr;
+			default:
+				switch (descriptor.interpolation) {
+					case Noise::Interpolation::Smoothstep:
+						return &latticeLinear<H, Noise::Interpolation::Smoothstep>;
+					case Noise::Interpolation::Smootherstep:
+						return &latticeLinear<H, Noise::Interpolation::Smootherstep>;
+					default:
+						return &latticeLinear<H, Noise::Interpolation::Linear>;
+				}
+		}
+	}
+}
+
+void Noise::setDescriptor(Descriptor descriptor) {
+	desc = descriptor;
+
+	params.function = desc.function;
+	params.interpolation = desc.interpolation;
+	params.fractal = desc.fractal;
+	params.seed = desc.seed;
+	params.frequency = desc.frequency;
+	params.lacunarity = desc.lacunarity;
+	params.weightedStrength = desc.weightedStrength;
+	params.gain = desc.gain;
+	params.octaves = desc.octaves;
+	params.amplitude = desc.amplitude;
+	params.cellularDistance = desc.cellularDistance;
+	params.cellularReturn = desc.cellularReturn;
+	params.warpFrequency = desc.warpFrequency;
+	params.warpAmplitude = desc.warpAmplitude;
+	params.hash = desc.hash;
+
+	// The permutation tables only depend on the seed
+	if (desc.hash != Hash::Permutation) {
+		permutationTable.reset();
+	}
+	else if (!permutationTable || permutationTable->seed != desc.seed) {
+		permutationTable = std::make_shared<const NoiseHash::PermutationTable>(desc.seed);
+	}
+	hashKey = {static_cast<uint32_t>(desc.seed), permutationTable.get()};
+	params.table = permutationTable.get();
+
+	octaveParams = params;
+	octaveParams.fractal = NoiseSimd::FractalNone;
+	octaveParams.frequency = 1.0f;
+	octaveParams.amplitude = 1.0f;
+
+	prewarpedParams = params;
+
+	if (cullsOctaves()) {
+		float octaveScale = 1.0f / std::log2(desc.lacunarity);
+		detailBase = -std::log2(glm::abs(desc.frequency) * desc.featureSizeFalloff) * octaveScale;
+		detailSlope = 0.5f * octaveScale;
+	}
+	prewarpedParams.fractal = NoiseSimd::FractalFBM;
+
+	warpParams = octaveParams;
+	warpParams.fractal = NoiseSimd::FractalFBM;
+
+	// Detect the instruction set once per process
+	static const NoiseSimd::Level level = NoiseSimd::detectLevel();
+
+	NoiseHash::dispatch(desc.hash, [&]<class H>() {
+		sampleFn = resolveSample<Domain::Plane, H>(desc);
+		sampleFn3 = resolveSample<Domain::Volume, H>(desc);
+		sampleLargeFn = resolveSample<Domain::LargePlane, H>(desc);
+		derivativeFn = resolveDerivative<H>(desc);
+		latticeDerivativeFn = resolveLatticeDerivative<H>(desc);
+		latticeFn = resolveLattice<H>(desc);
+	});
+	pointsFn = NoiseSimd::pointsFn(level, params);
+	octavePointsFn = NoiseSimd::pointsFn(level, octaveParams);
+	prewarpedPointsFn = NoiseSimd::pointsFn(level, prewarpedParams);
+	warpPointsFn = NoiseSimd::pointsFn(level, warpParams);
+	points3Fn = NoiseSimd::points3Fn(level, params);
+}
+
+void Noise::fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height) const {
+	assert(out.size() >= static_cast<size_t>(width) * height);
+
+	std::vector<float> xs(width);
+	std::vector<float> ys(height);
+	for (int col = 0; col < width; col++) {
+		xs[col] = origin.x + step.x * col;
+	}
+	for (int row = 0; row < height; row++) {
+		ys[row] = origin.y + step.y * row;
+	}
+
+	// Distance between samples in lattice cells for the first octave
+	float spacing = glm::max(glm::abs(step.x), glm::abs(step.y)) * glm::abs(desc.frequency);
+
+	// Octaves faded within the grid or sampled on subgrids need the layered path even without a lattice walking kernel
+	GridDetail detail = gridDetail(xs, ys);
+	bool layered = detail.lowest < float(desc.octaves) || (desc.octaves > 0 && octaveStrides(glm::abs(desc.gain), spacing, width, height)[0] > 1);
+
+	if ((latticeFn && spacing <= 1.0f) || layered) {
+		fillLattice(out, std::move(xs), std::move(ys), spacing, detail);
+	}
+	else {
+		fillPoints(out, xs, ys, pointsFn, params);
+	}
+}
+
+void Noise::fillGrid(std::span<float> out, glm::vec3 origin, glm::vec3 step, int width, int height, int depth) const {
+	assert(out.size() >= static_cast<size_t>(width) * height * depth);
+
+	// One row of points at a time, x varies and y, z are splatted like in fillPoints
+	std::vector<float> xs(width);
+	std::vector<float> rowYs(width);
+	std::vector<float> rowZs(width);
+	for (int col = 0; col < width; col++) {
+		xs[col] = origin.x + step.x * col;
+	}
+
+	float *dst = out.data();
+	for (int layer = 0; layer < depth; layer++) {
+		std::fill(rowZs.begin(), rowZs.end(), origin.z + step.z * layer);
+		for (int row = 0; row < height; row++) {
+			std::fill(rowYs.begin(), rowYs.end(), origin.y + step.y * row);
+			points3Fn(params, xs.data(), rowYs.data(), rowZs.data(), dst, width);
+			dst += width;
+		}
+	}
+}
+
+void Noise::fillGrid(std::span<float> out, glm::i64vec2 origin, glm::vec2 offset, glm::vec2 step, int width, int height) const {
+	assert(out.size() >= static_cast<size_t>(width) * height);
+
+	for (int row = 0; row < height; row++) {
+		for (int col = 0; col < width; col++) {
+			out[row * width + col] = sampleLargeFn(*this, origin, offset + step * glm::vec2(col, row));
+		}
+	}
+}
+
+Noise::LatticeAxis Noise::latticeAxis(int64_t a, float scaleA, int64_t b, float scaleB) {
+	assert(std::abs(a) < (MaxOrigin << FixedBits) && std::abs(b) < (MaxOrigin << FixedBits));
+
+	// Both scales as 24-bit integer mantissas over a shared power of two
+	int exponentA = 0;
+	int exponentB = 0;
+	double mantissaA = std::frexp(double(scaleA), &exponentA);
+	double mantissaB = std::frexp(double(scaleB), &exponentB);
+	int exponent = scaleB != 0.0f ? std::min(exponentA, exponentB) : exponentA;
+	assert(scaleB == 0.0f || std::abs(exponentA - exponentB) < 4);
+	int64_t ma = static_cast<int64_t>(std::ldexp(mantissaA, 24)) * (int64_t(1) << (exponentA - exponent));
+	int64_t mb = scaleB != 0.0f ? static_cast<int64_t>(std::ldexp(mantissaB, 24)) * (int64_t(1) << (exponentB - exponent)) : 0;
+
+	// a * ma + b * mb as hi * 2^32 + lo, multiplied in 32-bit halves so nothing overflows
+	int64_t hi = (a >> 32) * ma + (b >> 32) * mb;
+	int64_t lo = (a & 0xffffffff) * ma + (b & 0xffffffff) * mb;
+	hi += lo >> 32;
+	lo &= 0xffffffff;
+
+	// The sum has this many fraction bits, split off the cell above them
+	int bits = FixedBits + 24 - exponent;
+	assert(bits > 0 && bits < 95);
+
+	LatticeAxis axis{};
+	double t;
+	if (bits >= 32) {
+		int shift = bits - 32;
+		axis.cell = hi >> shift;
+		int64_t rest = hi - axis.cell * (int64_t(1) << shift);
+		t = std::ldexp(double(rest), -shift) + std::ldexp(double(lo), -bits);
+	}
+	else {
+		axis.cell = hi * (int64_t(1) << (32 - bits)) + (lo >> bits);
+		t = std::ldexp(double(lo & ((int64_t(1) << bits) - 1)), -bits);
+	}
+
+	// Offsets just below 1 round up to it as floats, they belong to the next cell
+	axis.t = float(t);
+	if (axis.t >= 1.0f) {
+		axis.cell++;
+		axis.t = 0.0f;
+	}
+	return axis;
+}
+
+void Noise::fillGridWithDerivative(std::span<glm::vec3> out, glm::vec2 origin, glm::vec2 step, int width, int height) const {
+	assert(out.size() >= static_cast<size_t>(width) * height);
+
+	if (!latticeDerivativeFn) {
+		for (int row = 0; row < height; row++) {
+			for (int col = 0; col < width; col++) {
+				out[row * width + col] = evalWithDerivative(origin + step * glm::vec2(col, row));
+			}
+		}
+		return;
+	}
+
+	// The derivative chain needs every octave at once, so this is the layered fill with throwaway layers
+	OctaveLayers layers;
+	updateOctaveLayers(layers, origin, step, width, height, true);
+	sumOctaveLayers(out, layers);
+}
+
+void Noise::fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height, OctaveLayers &layers) const {
+	assert(out.size() >= static_cast<size_t>(width) * height);
+
+	if (desc.fractal == Fractal::DomainWarp) {
+		layers = {};
+		fillGrid(out, origin, step, width, height);
+		return;
+	}
+
+	updateOctaveLayers(layers, origin, step, width, height, false);
+	sumOctaveLayers(out, layers);
+}
+
+void Noise::fillGridWithDerivative(std::span<glm::vec3> out, glm::vec2 origin, glm::vec2 step, int width, int height, OctaveLayers &layers) const {
+	assert(out.size() >= static_cast<size_t>(width) * height);
+
+	if (!derivativeFn) {
+		layers = {};
+		fillGridWithDerivative(out, origin, step, width, height);
+		return;
+	}
+
+	updateOctaveLayers(layers, origin, step, width, height, true);
+	sumOctaveLayers(out, layers);
+}
+
+void Noise::updateOctaveLayers(OctaveLayers &layers, glm::vec2 origin, glm::vec2 step, int width, int height, bool derivatives) const {
+	LayerSettings settings = layerSettings();
+	if (layers.layers > 0 && layers.settings == settings && layers.origin == origin && layers.step == step &&
+			layers.width == width && layers.height == height && layers.gradients.empty() != derivatives) {
+		return;
+	}
+
+	size_t count = static_cast<size_t>(width) * height;
+	layers = {};
+	layers.settings = settings;
+	layers.origin = origin;
+	layers.step = step;
+	layers.width = width;
+	layers.height = height;
+	layers.layers = isOctaveFractal(desc.fractal) ? desc.octaves : 1;
+	layers.values.resize(layers.layers * count);
+	if (derivatives) {
+		layers.gradients.resize(layers.layers * count);
+	}
+
+	std::vector<float> xs(width);
+	std::vector<float> ys(height);
+	for (int col = 0; col < width; col++) {
+		xs[col] = origin.x + step.x * col;
+	}
+	for (int row = 0; row < height; row++) {
+		ys[row] = origin.y + step.y * row;
+	}
+	GridDetail detail = gridDetail(xs, ys);
+
+	// Same scaling as eval()
+	for (float &x : xs) x *= desc.frequency;
+	for (float &y : ys) y *= desc.frequency;
+
+	float spacing = glm::max(glm::abs(step.x), glm::abs(step.y)) * glm::abs(desc.frequency);
+
+	// Raw octaves as fillLattice and fillGridWithDerivative evaluate them, left unweighted
+	std::vector<float> octaveXs(width);
+	std::vector<float> octaveYs(height);
+	std::vector<float> dx(derivatives ? count : 0);
+	std::vector<float> dy(derivatives ? count : 0);
+	float freq = 1.0f;
+
+	// Layers outlive gain edits, so the strides assume the octave weights don't fall off
+	std::vector<int> strides = derivatives ? std::vector<int>(layers.layers, 1) : octaveStrides(1.0f, spacing, width, height);
+
+	for (int i = 0; i < layers.layers; i++) {
+		for (int col = 0; col < width; col++) octaveXs[col] = xs[col] * freq;
+		for (int row = 0; row < height; row++) octaveYs[row] = ys[row] * freq;
+
+		std::span<float> layer(layers.values.data() + i * count, count);
+		glm::vec2 *gradient = derivatives ? layers.gradients.data() + i * count : nullptr;
+		bool lattice = spacing * freq <= 1.0f;
+
+		if (detail.culled(i)) {
+			std::fill(layer.begin(), layer.end(), OctaveMean); // Gradients stay zero
+		}
+		else if (derivatives && lattice) {
+			latticeDerivativeFn(hashKey, octaveXs.data(), width, octaveYs.data(), height, layer.data(), dx.data(), dy.data());
+			for (size_t k = 0; k < count; k++) {
+				gradient[k] = {dx[k], dy[k]};
+			}
+		}
+		else if (derivatives) {
+			for (int row = 0; row < height; row++) {
+				for (int col = 0; col < width; col++) {
+					glm::vec3 v = evalOctaveDerivative({octaveXs[col], octaveYs[row]});
+					layer[row * width + col] = v.x;
+					gradient[row * width + col] = {v.y, v.z};
+				}
+			}
+		}
+		else {
+			fillOctave(layer, octaveXs, octaveYs, spacing * freq, strides[i]);
+		}
+
+		if (!detail.culled(i)) {
+			shapeOctave(layer);
+			fadeOctave(layer, gradient, detail, i);
+		}
+
+		freq *= desc.lacunarity;
+	}
+}
+
+void Noise::sumOctaveLayers(std::span<float> out, const OctaveLayers &layers) const {
+	size_t count = static_cast<size_t>(layers.width) * layers.height;
+
+	if (!isOctaveFractal(desc.fractal)) {
+		for (size_t k = 0; k < count; k++) {
+			out[k] = layers.values[k] * desc.amplitude;
+		}
+		return;
+	}
+
+	// Weighting of evalFBm, one layer at a time like fillLattice
+	std::vector<float> amp(count, lerp(0.4f, 1.0f, 1.0f / desc.octaves));
+	std::vector<float> sum(count, 0.0f);
+	for (int i = 0; i < layers.layers; i++) {
+		const float *layer = layers.values.data() + i * count;
+		for (size_t k = 0; k < count; k++) {
+			sum[k] += amp[k] * layer[k];
+			amp[k] *= lerp(1.0f, (layer[k] * 0.5f), desc.weightedStrength);
+			amp[k] *= desc.gain;
+		}
+	}
+
+	for (size_t k = 0; k < count; k++) {
+		out[k] = glm::clamp(sum[k], 0.0f, 1.0f) * desc.amplitude;
+	}
+}
+
+void Noise::sumOctaveLayers(std::span<glm::vec3> out, const OctaveLayers &layers) const {
+	size_t count = static_cast<size_t>(layers.width) * layers.height;
+	float scale = desc.frequency * desc.amplitude; // Lattice to world units
+
+	if (!isOctaveFractal(desc.fractal)) {
+		for (size_t k = 0; k < count; k++) {
+			glm::vec2 d = layers.gradients[k];
+			out[k] = {layers.values[k] * desc.amplitude, d.x * scale, d.y * scale};
+		}
+		return;
+	}
+
+	// Weighting and derivative chain of evalFBmDerivative
+	for (size_t k = 0; k < count; k++) {
+		float amp = lerp(0.4f, 1.0f, 1.0f / desc.octaves);
+		glm::vec2 dAmp(0.0f);
+		float sum = 0.0f;
+		glm::vec2 dSum(0.0f);
+		float freq = 1.0f;
+
+		for (int i = 0; i < layers.layers; i++) {
+			float noise = layers.values[i * count + k];
+			glm::vec2 dNoise = layers.gradients[i * count + k] * freq;
+			sum += amp * noise;
+			dSum += dAmp * noise + dNoise * amp;
+
+			float weight = lerp(1.0f, (noise * 0.5f), desc.weightedStrength);
+			glm::vec2 dWeight = dNoise * (0.5f * desc.weightedStrength);
+			dAmp = (dAmp * weight + dWeight * amp) * desc.gain;
+			amp *= weight;
+			amp *= desc.gain;
+
+			freq *= desc.lacunarity;
+		}
+
+		glm::vec2 d = (sum <= 0.0f || sum >= 1.0f) ? glm::vec2(0.0f) : dSum;
+		out[k] = {glm::clamp(sum, 0.0f, 1.0f) * desc.amplitude, d.x * scale, d.y * scale};
+	}
+}
+
+void Noise::fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height, const WarpField &warp) const {
+	if (desc.fractal != Fractal::DomainWarp || warp.offsets.empty()) {
+		fillGrid(out, origin, step, width, height);
+		return;
+	}
+	assert(out.size() >= static_cast<size_t>(width) * height);
+
+	// Field cell and interpolation weight of every grid column and row, same as WarpField::sample
+	std::vector<int> fieldCols(width);
+	std::vector<float> weightXs(width);
+	for (int col = 0; col < width; col++) {
+		float u = (origin.x + step.x * col - warp.origin.x) / warp.step.x;
+		fieldCols[col] = glm::clamp(int(glm::floor(u)), 0, warp.width - 2);
+		weightXs[col] = glm::clamp(u - fieldCols[col], 0.0f, 1.0f);
+	}
+
+	// Upsample one row at a time, first along y into a row of field columns, then along x.
+	// Warped coordinates are no longer separable, evaluate them as a flat list of points.
+	size_t count = static_cast<size_t>(width) * height;
+	std::vector<float> xs(count);
+	std::vector<float> ys(count);
+	std::vector<glm::vec2> rowOffsets(warp.width);
+	for (int row = 0; row < height; row++) {
+		float y = origin.y + step.y * row;
+		float v = (y - warp.origin.y) / warp.step.y;
+		int fieldRow = glm::clamp(int(glm::floor(v)), 0, warp.height - 2);
+		float weightY = glm::clamp(v - fieldRow, 0.0f, 1.0f);
+
+		const glm::vec2 *bottom = &warp.offsets[fieldRow * warp.width];
+		const glm::vec2 *top = bottom + warp.width;
+		for (int c = 0; c < warp.width; c++) {
+			rowOffsets[c] = glm::mix(bottom[c], top[c], weightY);
+		}
+
+		for (int col = 0; col < width; col++) {
+			int c = fieldCols[col];
+			glm::vec2 offset = glm::mix(rowOffsets[c], rowOffsets[c + 1], weightXs[col]);
+			xs[row * width + col] = origin.x + step.x * col + offset.x;
+			ys[row * width + col] = y + offset.y;
+		}
+	}
+
+	prewarpedPointsFn(prewarpedParams, xs.data(), ys.data(), out.data(), count);
+}
+
+void Noise::updateWarpField(WarpField &field, glm::vec2 origin, glm::vec2 size, float cellSize) const {
+	if (desc.fractal != Fractal::DomainWarp) {
+		field = WarpField{};
+		return;
+	}
+
+	WarpSettings settings = warpSettings();
+	if (!field.offsets.empty() && field.settings == settings && field.origin == origin && field.size == size && field.cellSize == cellSize) {
+		return;
+	}
+
+	field.origin = origin;
+	field.size = size;
+	field.cellSize = cellSize;
+	field.settings = settings;
+
+	// At least one cell per axis, spread evenly over the area
+	field.width = glm::max(int(glm::ceil(size.x / cellSize)), 1) + 1;
+	field.height = glm::max(int(glm::ceil(size.y / cellSize)), 1) + 1;
+	field.step = size / glm::vec2(field.width - 1, field.height - 1);
+
+	// Same lookups as evalWarp
+	float warpScale = desc.frequency * desc.warpFrequency;
+	std::vector<float> xs(field.width);
+	std::vector<float> ys(field.height);
+	for (int col = 0; col < field.width; col++) {
+		xs[col] = (origin.x + field.step.x * col) * warpScale;
+	}
+	for (int row = 0; row < field.height; row++) {
+		ys[row] = (origin.y + field.step.y * row) * warpScale;
+	}
+
+	size_t count = static_cast<size_t>(field.width) * field.height;
+	std::vector<float> warpX(count);
+	std::vector<float> warpY(count);
+	fillPoints(warpX, xs, ys, warpPointsFn, warpParams);
+	for (float &x : xs) x += WarpOffsetX;
+	for (float &y : ys) y += WarpOffsetY;
+	fillPoints(warpY, xs, ys, warpPointsFn, warpParams);
+
+	field.offsets.resize(count);
+	for (size_t k = 0; k < count; k++) {
+		field.offsets[k] = glm::vec2(warpX[k] * 2.0f - 1.0f, warpY[k] * 2.0f - 1.0f) * desc.warpAmplitude;
+	}
+}
+
+glm::vec2 Noise::WarpField::sample(glm::vec2 p) const {
+	glm::vec2 u = (p - origin) / step;
+	int col = glm::clamp(int(glm::floor(u.x)), 0, width - 2);
+	int row = glm::clamp(int(glm::floor(u.y)), 0, height - 2);
+	glm::vec2 t = glm::clamp(u - glm::vec2(col, row), 0.0f, 1.0f);
+
+	const glm::vec2 *bottom = &offsets[row * width + col];
+	const glm::vec2 *top = bottom + width;
+	return glm::mix(glm::mix(bottom[0], bottom[1], t.x), glm::mix(top[0], top[1], t.x), t.y);
+}
+
+void Noise::shapeOctave(std::span<float> layer) const {
+	switch (desc.fractal) {
+		case Fractal::Ridged:
+			for (float &v : layer) v = octaveShape<Fractal::Ridged>(v);
+			break;
+		case Fractal::Turbulence:
+			for (float &v : layer) v = octaveShape<Fractal::Turbulence>(v);
+			break;
+		default:
+			break;
+	}
+}
+
+void Noise::fillPoints(std::span<float> out, const std::vector<float> &xs, const std::vector<float> &ys, NoiseSimd::PointsFn fn, const NoiseSimd::Params &fnParams) const {
+	int width = static_cast<int>(xs.size());
+	std::vector<float> rowYs(width);
+	for (size_t row = 0; row < ys.size(); row++) {
+		std::fill(rowYs.begin(), rowYs.end(), ys[row]);
+		fn(fnParams, xs.data(), rowYs.data(), out.data() + row * width, width);
+	}
+}
+
+void Noise::fillLattice(std::span<float> out, std::vector<float> xs, std::vector<float> ys, float spacing, const GridDetail &detail) const {
+	int width = static_cast<int>(xs.size());
+	int height = static_cast<int>(ys.size());
+	size_t count = static_cast<size_t>(width) * height;
+
+	// Same scaling as eval()
+	for (float &x : xs) x *= desc.frequency;
+	for (float &y : ys) y *= desc.frequency;
+
+	if (!isOctaveFractal(desc.fractal)) {
+		latticeFn(hashKey, xs.data(), width, ys.data(), height, out.data());
+		for (size_t i = 0; i < count; i++) {
+			out[i] *= desc.amplitude;
+		}
+		return;
+	}
+
+	// One octave layer at a time, shaped and accumulated with the same weighting as evalFBm.
+	// Octaves that end up sparser than the lattice use the SIMD kernel instead.
+	std::vector<float> layer(count);
+	std::vector<float> amp(count, lerp(0.4f, 1.0f, 1.0f / desc.octaves));
+	std::vector<float> sum(count, 0.0f);
+	std::vector<float> octaveXs(width);
+	std::vector<float> octaveYs(height);
+	float freq = 1.0f;
+
+	// Weights only shrink from one octave to the next, by at most the gain
+	std::vector<int> strides = octaveStrides(glm::abs(desc.gain), spacing, width, height);
+
+	for (int i = 0; i < desc.octaves; i++) {
+		for (int col = 0; col < width; col++) octaveXs[col] = xs[col] * freq;
+		for (int row = 0; row < height; row++) octaveYs[row] = ys[row] * freq;
+
+		if (detail.culled(i)) {
+			std::fill(layer.begin(), layer.end(), OctaveMean);
+		}
+		else {
+			fillOctave(layer, octaveXs, octaveYs, spacing * freq, strides[i]);
+			shapeOctave(layer);
+			fadeOctave(layer, nullptr, detail, i);
+		}
+
+		for (size_t k = 0; k < count; k++) {
+			sum[k] += amp[k] * layer[k];
+			amp[k] *= lerp(1.0f, (layer[k] * 0.5f), desc.weightedStrength);
+			amp[k] *= desc.gain;
+		}
+
+		freq *= desc.lacunarity;
+	}
+
+	for (size_t k = 0; k < count; k++) {
+		out[k] = glm::clamp(sum[k], 0.0f, 1.0f) * desc.amplitude;
+	}
+}
+
+std::vector<int> Noise::octaveStrides(float falloff, float spacing, int width, int height) const {
+	// One stride even without octaves, the single layer of the other fractals takes the first
+	std::vector<int> strides(glm::max(desc.octaves, 1), 1);
+	if (desc.octaveTolerance <= 0.0f || spacing <= 0.0f || !isOctaveFractal(desc.fractal)) {
+		return strides;
+	}
+
+	// Ridged and turbulence double the error when folding the octave
+	float fold = desc.fractal == Fractal::FBM ? 1.0f : 2.0f;
+	UpsamplingError error = upsamplingError(desc);
+
+	auto stride = [&](int octave, float tolerance) {
+		float weight = lerp(0.4f, 1.0f, 1.0f / desc.octaves) * glm::pow(falloff, float(octave)) * fold;
+		float octaveSpacing = spacing * glm::pow(glm::abs(desc.lacunarity), float(octave));
+		float cellSpacing = glm::pow(tolerance / (weight * error.coefficient), 1.0f / error.order); // Coarsest spacing in lattice cells
+
+		// Lattice walking already evaluates every lattice point once and interpolates it like the octave does
+		if (latticeFn && octaveSpacing <= 1.0f) {
+			return 1;
+		}
+
+		int s = 1;
+		while (s * 2 * octaveSpacing <= cellSpacing && s * 2 < glm::max(width, height)) {
+			s *= 2;
+		}
+		return s;
+	};
+
+	// Octaves too fine to coarsen even with the whole tolerance don't take a share of it
+	int coarse = 0;
+	for (int i = 0; i < desc.octaves; i++) {
+		coarse += stride(i, desc.octaveTolerance) > 1 ? 1 : 0;
+	}
+	if (coarse == 0) {
+		return strides;
+	}
+
+	for (int i = 0; i < desc.octaves; i++) {
+		strides[i] = stride(i, desc.octaveTolerance / coarse);
+	}
+	return strides;
+}
+
+Noise::GridDetail Noise::gridDetail(const std::vector<float> &xs, const std::vector<float> &ys) const {
+	GridDetail detail;
+	if (!cullsOctaves() || xs.empty() || ys.empty()) {
+		return detail;
+	}
+
+	// Detail falls with the distance to the center: highest at the nearest grid point, lowest at the farthest corner
+	auto [minX, maxX] = std::minmax_element(xs.begin(), xs.end());
+	auto [minY, maxY] = std::minmax_element(ys.begin(), ys.end());
+	glm::vec2 nearest = glm::clamp(desc.detailCenter, glm::vec2(*minX, *minY), glm::vec2(*maxX, *maxY));
+	glm::vec2 farthest(
+			desc.detailCenter.x - *minX > *maxX - desc.detailCenter.x ? *minX : *maxX,
+			desc.detailCenter.y - *minY > *maxY - desc.detailCenter.y ? *minY : *maxY);
+	detail.highest = octaveDetail(nearest);
+	detail.lowest = octaveDetail(farthest);
+
+	// Octaves below lowest - 1 are whole everywhere, only the ones above need the per sample fade
+	if (detail.lowest < float(desc.octaves)) {
+		// Same distance and detail as octaveDetail, with the squared offsets shared along rows and columns
+		std::vector<float> dxs(xs.size());
+		for (size_t col = 0; col < xs.size(); col++) {
+			float dx = xs[col] - desc.detailCenter.x;
+			dxs[col] = dx * dx;
+		}
+
+		detail.samples.resize(xs.size() * ys.size());
+		for (size_t row = 0; row < ys.size(); row++) {
+			float dy = ys[row] - desc.detailCenter.y;
+			float dySquared = dy * dy;
+			for (size_t col = 0; col < xs.size(); col++) {
+				float distanceSquared = dxs[col] + dySquared;
+				detail.samples[row * xs.size() + col] = distanceSquared > 0.0f
+						? detailBase - detailSlope * std::log2(distanceSquared)
+						: std::numeric_limits<float>::infinity();
+			}
+		}
+	}
+	return detail;
+}
+
+void Noise::fadeOctave(std::span<float> layer, glm::vec2 *gradients, const GridDetail &detail, int octave) const {
+	if (detail.lowest >= float(octave + 1)) {
+		return;
+	}
+
+	for (size_t k = 0; k < detail.samples.size(); k++) {
+		float fade = glm::clamp(detail.samples[k] - float(octave), 0.0f, 1.0f);
+		if (fade < 1.0f) {
+			layer[k] = lerp(OctaveMean, layer[k], fade);
+			if (gradients) {
+				gradients[k] = gradients[k] * fade;
+			}
+		}
+	}
+}
+
+void Noise::fillOctave(std::span<float> layer, const std::vector<float> &xs, const std::vector<float> &ys, float spacing, int stride) const {
+	int width = static_cast<int>(xs.size());
+	int height = static_cast<int>(ys.size());
+
+	if (stride == 1) {
+		if (latticeFn && spacing <= 1.0f) {
+			latticeFn(hashKey, xs.data(), width, ys.data(), height, layer.data());
+		}
+		else {
+			fillPoints(layer, xs, ys, octavePointsFn, octaveParams);
+		}
+		return;
+	}
+
+	// Subgrid with one extra sample before the grid and the last point's three taps after it, the last point can sit
+	// exactly on a subgrid sample and still reads the taps past it (with a weight of zero)
+	int coarseWidth = (width - 1) / stride + 4;
+	int coarseHeight = (height - 1) / stride + 4;
+	float dx = width > 1 ? (xs[width - 1] - xs[0]) / (width - 1) : 0.0f;
+	float dy = height > 1 ? (ys[height - 1] - ys[0]) / (height - 1) : 0.0f;
+
+	std::vector<float> coarseXs(coarseWidth);
+	std::vector<float> coarseYs(coarseHeight);
+	for (int col = 0; col < coarseWidth; col++) {
+		coarseXs[col] = xs[0] + dx * float((col - 1) * stride);
+	}
+	for (int row = 0; row < coarseHeight; row++) {
+		coarseYs[row] = ys[0] + dy * float((row - 1) * stride);
+	}
+
+	std::vector<float> coarse(static_cast<size_t>(coarseWidth) * coarseHeight);
+	fillOctave(coarse, coarseXs, coarseYs, spacing * stride, 1);
+
+	// The stride positions repeat, so their tap weights are computed once
+	std::vector<glm::vec4> weights(stride);
+	for (int i = 0; i < stride; i++) {
+		weights[i] = catmullRomWeights(float(i) / float(stride));
+	}
+
+	// Upsample along x for every coarse row, then along y
+	std::vector<float> rows(static_cast<size_t>(coarseHeight) * width);
+	for (int row = 0; row < coarseHeight; row++) {
+		const float *in = &coarse[row * coarseWidth];
+		float *up = &rows[row * width];
+		for (int col = 0; col < width; col++) {
+			const float *taps = in + col / stride;
+			glm::vec4 w = weights[col % stride];
+			up[col] = w.x * taps[0] + w.y * taps[1] + w.z * taps[2] + w.w * taps[3];
+		}
+	}
+
+	for (int row = 0; row < height; row++) {
+		const float *r0 = &rows[(row / stride) * width];
+		const float *r1 = r0 + width;
+		const float *r2 = r1 + width;
+		const float *r3 = r2 + width;
+		glm::vec4 w = weights[row % stride];
+		float *out = &layer[row * width];
+		for (int col = 0; col < width; col++) {
+			out[col] = w.x * r0[col] + w.y * r1[col] + w.z * r2[col] + w.w * r3[col];
+		}
+	}
+}
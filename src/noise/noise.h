@@ -5,9 +5,18 @@
 #include <glm/gtc/matrix_transform.hpp>
 // Include glm constants
 #include <glm/gtc/constants.hpp>
-#include <stb_image_write.h>
+#include <glm/ext/vector_int2_sized.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <type_traits>
 #include <vector>
+#include <span>
+#include "noise_simd.h"
+#include "noise_hash.h"
 
 
 class Noise {
@@ -33,7 +42,30 @@ public:
 		FBM,
 		Ridged,
 		Turbulence,
-		DomainWarp,
+		DomainWarp, // FBM sampled at coordinates offset by a secondary noise
+	};
+
+	// Distance metric between a sample and the cellular feature points
+	enum CellularDistance {
+		Euclidean,
+		EuclideanSquared,
+		Manhattan
+	};
+
+	// Which feature point distances cellular noise returns
+	enum CellularReturn {
+		F1, // Nearest
+		F2, // Second nearest
+		F2MinusF1 // Cell borders
+	};
+
+	// Lattice hash policy of every kernel, see noise_hash.h
+	enum Hash {
+		PrimeXor, // The original XOR and multiply
+		Pcg,
+		XxHash,
+		ShiftAdd, // Multiply free, for integer SIMD without a fast 32-bit multiply
+		Permutation // Seeded lookup tables instead of multiplies, repeats every 256 lattice cells
 	};
 
 	static constexpr Function DefaultFunction = Function::Value;
@@ -45,6 +77,40 @@ public:
 	static constexpr float DefaultWeightedStrength = 0.0f;
 	static constexpr float DefaultGain = 0.5f;
 	static constexpr int DefaultOctaves = 3;
+	static constexpr CellularDistance DefaultCellularDistance = CellularDistance::Euclidean;
+	static constexpr CellularReturn DefaultCellularReturn = CellularReturn::F1;
+	static constexpr Hash DefaultHash = Hash::PrimeXor;
+	static constexpr float DefaultWarpFrequency = 0.5f;
+	static constexpr float DefaultWarpAmplitude = 8.0f;
+	static constexpr float DefaultWarpCellSize = 2.0f;
+	static constexpr float DefaultOctaveTolerance = 0.0f;
+	static constexpr float DefaultFeatureSizeFalloff = 0.0f;
+
+	// Value standing in for octaves culled below the feature size
+	static constexpr float OctaveMean = 0.5f;
+
+	// Scale the raw gradient noise sums to roughly [-1, 1] before mapping to [0, 1] like value noise
+	static constexpr float PerlinScale = 1.25f;
+	static constexpr float SimplexScale = 85.0f;
+
+	// Simplex skew factors (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6
+	static constexpr float SimplexF2 = 0.36602540378f;
+	static constexpr float SimplexG2 = 0.21132486540f;
+
+	// The 3D lattice: scales of the raw gradient noise sums and the simplex skew factors 1 / 3 and 1 / 6
+	static constexpr float PerlinScale3 = 1.0f;
+	static constexpr float SimplexScale3 = 76.0f;
+	static constexpr float SimplexF3 = 1.0f / 3.0f;
+	static constexpr float SimplexG3 = 1.0f / 6.0f;
+
+	// Cellular distances start out beyond any reachable feature point, the result is scaled by CellularScale to [0, 1]
+	static constexpr float CellularMaxDistance = 1e10f;
+	static constexpr float CellularScale = 0.75f;
+
+	// Shifts the y warp lookup away from the x warp lookup so the two offsets are uncorrelated
+	static constexpr float WarpOffsetX = 5.2f;
+	static constexpr float WarpOffsetY = 1.3f;
+	static constexpr float WarpOffsetZ = 3.7f;
 
 	struct Descriptor {
 		Function function = DefaultFunction;
@@ -57,19 +123,102 @@ public:
 		float gain = DefaultGain;
 		int octaves = DefaultOctaves;
 		float amplitude = 1.0f;
+		CellularDistance cellularDistance = DefaultCellularDistance;
+		CellularReturn cellularReturn = DefaultCellularReturn;
+		float warpFrequency = DefaultWarpFrequency; // Domain warp noise frequency relative to frequency
+		float warpAmplitude = DefaultWarpAmplitude; // Largest domain warp offset in world units
+		float octaveTolerance = DefaultOctaveTolerance; // Largest fillGrid error relative to amplitude from sampling octaves on coarser grids, 0 samples every octave everywhere
+		glm::vec2 detailCenter{}; // Point the octave culling measures distances from, in world units
+		float featureSizeFalloff = DefaultFeatureSizeFalloff; // Smallest kept wavelength per world unit of distance to detailCenter, 0 keeps every octave
+		Hash hash = DefaultHash;
+
+		bool operator==(const Descriptor &) const = default;
 	};
 
+	// Descriptor members the domain warp offsets depend on
+	struct WarpSettings {
+		Function function = DefaultFunction;
+		Interpolation interpolation = DefaultInterpolation;
+		CellularDistance cellularDistance = DefaultCellularDistance;
+		CellularReturn cellularReturn = DefaultCellularReturn;
+		int seed = DefaultSeed;
+		float frequency = DefaultFrequency;
+		float warpFrequency = DefaultWarpFrequency;
+		float warpAmplitude = DefaultWarpAmplitude;
+		Hash hash = DefaultHash;
+		// The warp offsets are FBM of the descriptor's octaves
+		int octaves = DefaultOctaves;
+		float lacunarity = DefaultLacunarity;
+		float gain = DefaultGain;
+		float weightedStrength = DefaultWeightedStrength;
+
+		bool operator==(const WarpSettings &) const = default;
+	};
+
+	// Domain warp offsets sampled on a coarse grid, built by updateWarpField and upsampled by fillGrid
+	struct WarpField {
+		glm::vec2 origin{};
+		glm::vec2 size{};
+		float cellSize = 0.0f;
+		WarpSettings settings{};
+
+		glm::vec2 step{};
+		int width = 0;
+		int height = 0;
+		std::vector<glm::vec2> offsets; // Row-major, offsets[row * width + col]
+
+		// Bilinearly interpolated offset at p, clamped to the field
+		glm::vec2 sample(glm::vec2 p) const;
+	};
 
+	// Descriptor members the raw octave values depend on, everything but the octave weighting and amplitude
+	struct LayerSettings {
+		Function function = DefaultFunction;
+		Interpolation interpolation = DefaultInterpolation;
+		Fractal fractal = DefaultFractal;
+		CellularDistance cellularDistance = DefaultCellularDistance;
+		CellularReturn cellularReturn = DefaultCellularReturn;
+		int seed = DefaultSeed;
+		float frequency = DefaultFrequency;
+		float lacunarity = DefaultLacunarity;
+		int octaves = DefaultOctaves;
+		float octaveTolerance = DefaultOctaveTolerance;
+		glm::vec2 detailCenter{};
+		float featureSizeFalloff = DefaultFeatureSizeFalloff;
+		Hash hash = DefaultHash;
+
+		bool operator==(const LayerSettings &) const = default;
+	};
+
+	// Unweighted octave values of a grid, kept by fillGrid so gain, weightedStrength and amplitude edits only re-sum them.
+	// Octave fractals keep one shaped layer per octave, the other fractals a single layer.
+	struct OctaveLayers {
+		LayerSettings settings{};
+		glm::vec2 origin{};
+		glm::vec2 step{};
+		int width = 0;
+		int height = 0;
+
+		int layers = 0;
+		std::vector<float> values; // values[layer * width * height + row * width + col]
+		std::vector<glm::vec2> gradients; // Same layout in lattice units of each octave, empty unless built with derivatives
+	};
+
+
+	// Read only, use setDescriptor to change it so the evaluation kernels are resolved again.
 	Descriptor desc;
 
 	Noise() {
-		this->desc = Descriptor{};
+		setDescriptor(Descriptor{});
 	}
 
 	explicit Noise(Descriptor descriptor) {
-		this->desc = descriptor;
+		setDescriptor(descriptor);
 	}
 
+	// Sets the descriptor and resolves the specialized scalar and batch kernels for it
+	void setDescriptor(Descriptor descriptor);
+
 
 	// Hashing
 	// ----------------------------
@@ -80,26 +229,35 @@ public:
 	static const int PrimeZ = 1720413743;
 	static const int PrimeW = 0x27d4eb2d; // 668265261
 
+	// The default PrimeXor hash: the seed and primed coordinates combined with XOR, times PrimeW.
+	// The kernels take the hash policy of desc.hash, see noise_hash.h.
 	static int hashPrimedInt(int seed, int xPrimed, int yPrimed) {
-
-		// Combine seed and primes using XOR.
-		// XOR is reversible, commutative, associative, and mixes bit values well.
-		int hash = (seed+PrimeZ) ^ (xPrimed+PrimeY) ^ (yPrimed+PrimeX);
-		hash *= PrimeW;
-		return hash;
+		return NoiseHash::hashInt<NoiseHash::PrimeXor>(seed, xPrimed, yPrimed);
 	}
 
 
 	// Get a hashed float in range [0, 1]
-	static float hashPrimedFloat(int seed, int xPrimed, int yPrimed)
-	{
-		int h = hashPrimedInt(seed, xPrimed, yPrimed);
-		// Make positive and scale to [0, 1]
-		h &= 0x7fffffff; // Ensure hash is positive integer
-		return h / 2147483647.0f; // Max 31bit unsigned integer
+	static float hashPrimedFloat(int seed, int xPrimed, int yPrimed) {
+		return NoiseHash::hashFloat<NoiseHash::PrimeXor>(seed, xPrimed, yPrimed);
+	}
 
+	// Dot product of the offset (x, y) with one of 8 gradients picked from the top hash bits
+	// (the best mixed ones after the multiply): (+-1, +-0.5) and (+-0.5, +-1).
+	static float gradientDot(int hash, float x, float y) {
+		int h = (hash >> 28) & 7;
+		float u = (h & 4) ? y : x;
+		float v = (h & 4) ? x : y;
+		return ((h & 1) ? -u : u) + ((h & 2) ? -v : v) * 0.5f;
 	}
 
+	// Dot product of the offset (x, y, z) with one of the 12 cube edge gradients picked from the top hash bits,
+	// 4 of them twice to fill 16 slots
+	static float gradientDot(int hash, float x, float y, float z) {
+		int h = (hash >> 28) & 15;
+		float u = (h & 8) ? y : x;
+		float v = (h & 12) == 0 ? y : ((h & 13) == 12 ? x : z);
+		return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+	}
 
 
 	// Interpolation
@@ -133,79 +291,385 @@ public:
 		return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
 	}
 
+	static glm::vec3 smoothStep(const glm::vec3 &t) {
+		return t * t * (3.0f - 2.0f * t);
+	}
+
+	static glm::vec3 smootherStep(const glm::vec3 &t) {
+		return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+	}
+
+	// Derivatives of the interpolation curves with respect to t
+	static glm::vec2 smoothStepDerivative(const glm::vec2 &t) {
+		return 6.0f * t * (1.0f - t);
+	}
+
+	static glm::vec2 smootherStepDerivative(const glm::vec2 &t) {
+		return 30.0f * t * t * (t * (t - 2.0f) + 1.0f);
+	}
+
+	// cubicLerp and its derivative with respect to t, which is zero where cubicLerp clamps
+	static glm::vec2 cubicLerpWithDerivative(const float &a, const float &b, const float &c, const float &d, const float &t) {
+		float p = (d - c) - (a - b);
+		float q = (a - b) - p;
+		float r = c - a;
+		float s = b;
+		float v = (p * t * t * t) + (q * t * t) + (r * t) + s;
+		float dv = (v <= 0.0f || v >= 1.0f) ? 0.0f : 3.0f * p * t * t + 2.0f * q * t + r;
+		return {glm::clamp(v, 0.0f, 1.0f), dv};
+	}
+
+	// Weights of a, b, c and d in cubicLerp at t, before clamping
+	static glm::vec4 cubicLerpWeights(float t) {
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return {-t3 + 2.0f * t2 - t, t3 - 2.0f * t2 + 1.0f, -t3 + t2 + t, t3 - t2};
+	}
+
 	// Given an integer point on a grid, hash the point.
 	static float evalGrid(int seed, glm::ivec2 p) {
 		return evalGrid(seed, p.x, p.y);
 	}
 
 	static float evalGrid(int seed, int x, int y) {
-		return hashPrimedFloat(seed, (x ^ PrimeX) * PrimeX, (y ^ PrimeY) * PrimeY);
+		return hashPrimedFloat(seed, primed(x ^ PrimeX, PrimeX), primed(y ^ PrimeY, PrimeY));
 	}
 
 
-	// Given a float point, evaluate the value noise using the surrounding 3x3 grid of integer points.
-	float eval(glm::vec2 p) {
+	// Given a float point, evaluate the noise described by desc.
+	// Dispatches straight to the kernel specialized for desc, so no function/fractal switches run per sample.
+	float eval(glm::vec2 p) const {
+		return sampleFn(*this, p);
+	}
 
-		float out = 0.0f;
+	// Step of the central differences evalWithDerivative falls back to, in world units
+	static constexpr float DerivativeStep = 0.01f;
+
+	/**
+	 * Evaluates the noise and its gradient in one pass.
+	 * Value and cubic noise, on their own or with FBM, are differentiated analytically, the others fall back to
+	 * central differences of eval.
+	 *
+	 * @return (eval(p), d/dx, d/dy) with the gradient in world units
+	 */
+	glm::vec3 evalWithDerivative(glm::vec2 p) const {
+		if (derivativeFn) {
+			return derivativeFn(*this, p);
+		}
+		float dx = (eval({p.x + DerivativeStep, p.y}) - eval({p.x - DerivativeStep, p.y})) / (2.0f * DerivativeStep);
+		float dy = (eval({p.x, p.y + DerivativeStep}) - eval({p.x, p.y - DerivativeStep})) / (2.0f * DerivativeStep);
+		return {eval(p), dx, dy};
+	}
 
-		p = p * desc.frequency;
+	// True when evalWithDerivative differentiates desc analytically
+	bool hasAnalyticDerivative() const {
+		return derivativeFn != nullptr;
+	}
 
-		switch(desc.fractal) {
-			case Fractal::None:
-				switch (desc.function) {
-					case Function::Value:
-						out = evalLinear(p);
-						break;
-					case Function::ValueCubic:
-						out = evalCubic(p);
-						break;
-					default:
-						out = evalLinear(p);
-						break;
-				}
-				break;
-			case Fractal::FBM:
-				out = evalFBm(p);
-				break;
-			default:
-				out = evalLinear(p);
-				break;
+
+	// Domain warp settings of desc
+	WarpSettings warpSettings() const {
+		return {desc.function, desc.interpolation, desc.cellularDistance, desc.cellularReturn, desc.seed, desc.frequency, desc.warpFrequency, desc.warpAmplitude, desc.hash,
+				desc.octaves, desc.lacunarity, desc.gain, desc.weightedStrength};
+	}
+
+	// Octave layer settings of desc
+	LayerSettings layerSettings() const {
+		return {desc.function, desc.interpolation, desc.fractal, desc.cellularDistance, desc.cellularReturn, desc.seed, desc.frequency, desc.lacunarity, desc.octaves, desc.octaveTolerance,
+				desc.detailCenter, desc.featureSizeFalloff, desc.hash};
+	}
+
+	// True when octaves below the feature size are culled, octave fractals only
+	bool cullsOctaves() const {
+		return desc.featureSizeFalloff > 0.0f && desc.lacunarity > 1.0f && isOctaveFractal(desc.fractal);
+	}
+
+	/**
+	 * Octaves worth of detail at p: octave i is kept whole below detail - 1, fades to OctaveMean up to detail and
+	 * is culled from there. The smallest kept wavelength grows with the distance to desc.detailCenter, so the
+	 * culling is continuous across chunks and over time. Infinite without culling.
+	 */
+	float octaveDetail(glm::vec2 p) const {
+		if (!cullsOctaves()) {
+			return std::numeric_limits<float>::infinity();
+		}
+		glm::vec2 d = p - desc.detailCenter;
+		return octaveDetailAt(glm::dot(d, d));
+	}
+
+	// octaveDetail at the squared distance to desc.detailCenter
+	float octaveDetailAt(float distanceSquared) const {
+		if (distanceSquared <= 0.0f) {
+			return std::numeric_limits<float>::infinity();
+		}
+
+		// Octave i has a wavelength of 1 / (frequency * lacunarity^i), solved for the feature size at p
+		return detailBase - detailSlope * std::log2(distanceSquared);
+	}
+
+	// detailBase and detailSlope of octaveDetailAt, for kernels ported outside this class
+	glm::vec2 octaveDetailLine() const {
+		return {detailBase, detailSlope};
+	}
+
+	// Fractals that sum octaves of the function, each octave reshaped by octaveShape
+	static constexpr bool isOctaveFractal(Fractal fractal) {
+		return fractal == Fractal::FBM || fractal == Fractal::Ridged || fractal == Fractal::Turbulence;
+	}
+
+	// Turbulence folds the noise around its midpoint into billows, ridged flips those into sharp crests.
+	template<Fractal R>
+	static float octaveShape(float noise) {
+		if constexpr (R == Fractal::Turbulence) {
+			return glm::abs(noise * 2.0f - 1.0f);
+		}
+		else if constexpr (R == Fractal::Ridged) {
+			return 1.0f - glm::abs(noise * 2.0f - 1.0f);
+		}
+		else {
+			return noise;
 		}
+	}
+
+
+	// Batch Evaluation
+	// ----------------------------
+
+	// Maximum absolute difference between fillGrid and eval, relative to desc.amplitude.
+	// Vector kernels follow the scalar operation order, but compilers may fuse multiply-adds on some targets.
+	static constexpr float BatchTolerance = 1e-5f;
+
+	/**
+	 * Evaluates the noise over a regular grid.
+	 *
+	 * Value and cubic noise sampled at least once per lattice cell walk the lattice row by row, hashing every
+	 * lattice point and interpolating every lattice row once per grid. Sparser grids and the remaining
+	 * functions use the best SIMD kernel for the running CPU.
+	 *
+	 * With desc.octaveTolerance set, octave fractals sample each octave without a lattice walking path on the
+	 * coarsest power of two subgrid that keeps its Catmull-Rom upsampling within the tolerance, so low octaves
+	 * are only evaluated every few samples. The result then differs from eval by up to octaveTolerance * amplitude.
+	 *
+	 * With octave culling, octaves culled over the whole grid are not evaluated at all.
+	 *
+	 * @param out Row-major output of at least width * height values, out[row * width + col] == eval(origin + step * (col, row))
+	 * @param origin Position of the first sample
+	 * @param step Distance between neighbouring samples along x and y
+	 * @param width Number of samples per row
+	 * @param height Number of rows
+	 */
+	void fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height) const;
+
+	/**
+	 * Builds the domain warp offsets covering [origin, origin + size] on a grid of about cellSize spacing.
+	 * Leaves the field untouched when it already covers that area with the current warp settings, and
+	 * empties it when desc is not domain warped.
+	 */
+	void updateWarpField(WarpField &field, glm::vec2 origin, glm::vec2 size, float cellSize = DefaultWarpCellSize) const;
+
+	/**
+	 * fillGrid for domain warped noise reading the warp offsets from a field built by updateWarpField instead of
+	 * evaluating the warp noise at every sample. The result approximates eval, up to the bilinear upsampling
+	 * of the offsets. Without domain warping, or with an empty field, this is the plain fillGrid.
+	 */
+	void fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height, const WarpField &warp) const;
+
+	/**
+	 * fillGrid with the gradient of every sample, out[row * width + col] == evalWithDerivative(origin + step * (col, row)).
+	 * Walks the lattice rows like fillGrid when the derivative is analytic, the heights match fillGrid exactly.
+	 */
+	void fillGridWithDerivative(std::span<glm::vec3> out, glm::vec2 origin, glm::vec2 step, int width, int height) const;
+
+	/**
+	 * fillGrid keeping the unweighted octave values in layers. When layers already hold this grid with the current
+	 * layer settings, only the octave weighting is redone: no hashing or interpolation. The result matches the
+	 * plain fillGrid, up to BatchTolerance where that takes a SIMD kernel.
+	 * Domain warped noise is not layered, it takes the plain fillGrid and empties layers.
+	 */
+	void fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height, OctaveLayers &layers) const;
+
+	// fillGridWithDerivative keeping the octave values and their gradients in layers, see the layered fillGrid
+	void fillGridWithDerivative(std::span<glm::vec3> out, glm::vec2 origin, glm::vec2 step, int width, int height, OctaveLayers &layers) const;
+
+
+
+	// Large Coordinates
+	// ----------------------------
 
-		return out * desc.amplitude;
+	// The large coordinate path keeps positions in fixed point with FixedBits fraction bits, up to MaxOrigin world units
+	static constexpr int FixedBits = 16;
+	static constexpr int64_t MaxOrigin = int64_t(1) << 46;
+
+	// World coordinates up to this far from the origin take the float path without visible precision loss
+	static constexpr float FloatPathRange = 32768.0f;
+
+	// True when a grid starting at origin is past FloatPathRange and should take the large coordinate path
+	static bool needsLargeCoordinates(glm::i64vec2 origin) {
+		return std::max(std::abs(origin.x), std::abs(origin.y)) > static_cast<int64_t>(FloatPathRange);
+	}
+
+	/**
+	 * Evaluates the noise at origin + offset for worlds past float precision, a chunk corner and a sample inside the
+	 * chunk for example. The position is kept exactly in fixed point and each octave splits position * frequency into
+	 * its integer lattice cell and the float offset inside it, so lattice indices never round or overflow. Any two
+	 * splits of the same fixed point position give bit-identical results at any distance from the origin. Simplex noise
+	 * skews the fixed point position itself, so its cells are exact too.
+	 *
+	 * Near the origin this matches eval up to float rounding, not bit for bit. The path is scalar and has no analytic
+	 * derivative or octave layers.
+	 */
+	float eval(glm::i64vec2 origin, glm::vec2 offset) const {
+		return sampleLargeFn(*this, origin, offset);
 	}
 
+	/**
+	 * Large coordinate eval over a regular grid.
+	 * @param out Row-major output of at least width * height values, out[row * width + col] == eval(origin, offset + step * (col, row))
+	 */
+	void fillGrid(std::span<float> out, glm::i64vec2 origin, glm::vec2 offset, glm::vec2 step, int width, int height) const;
+
+
+	// 3D Evaluation
+	// ----------------------------
+
+	/**
+	 * Evaluates the noise described by desc at a 3D point, for density fields. Every function and fractal has a 3D
+	 * kernel: hashes take z * PrimeZ as well, Perlin noise picks from the 12 cube edge gradients and simplex noise
+	 * works on the tetrahedral lattice. The octave culling only applies in 2D.
+	 */
+	float eval(glm::vec3 p) const {
+		return sampleFn3(*this, p);
+	}
+
+	/**
+	 * Evaluates the noise over a regular 3D grid on the best SIMD kernel for the running CPU.
+	 * @param out Output of at least width * height * depth values, out[(layer * height + row) * width + col] == eval(origin + step * (col, row, layer))
+	 */
+	void fillGrid(std::span<float> out, glm::vec3 origin, glm::vec3 step, int width, int height, int depth) const;
+
+	// Evaluates one octave over the separable grid (xs[col], ys[row]), coordinates already scaled by the frequency
+	using LatticeFn = void (*)(const NoiseHash::ScalarKey &key, const float *xs, int width, const float *ys, int height, float *out);
+
+	// LatticeFn that also writes the derivatives along x and y, in lattice units
+	using LatticeDerivativeFn = void (*)(const NoiseHash::ScalarKey &key, const float *xs, int width, const float *ys, int height, float *out, float *outDx, float *outDy);
+
 
 
 private:
 
+	using SampleFn = float (*)(const Noise &noise, glm::vec2 p);
+	using SampleFn3 = float (*)(const Noise &noise, glm::vec3 p);
+	using SampleLargeFn = float (*)(const Noise &noise, glm::i64vec2 origin, glm::vec2 offset);
+	using DerivativeFn = glm::vec3 (*)(const Noise &noise, glm::vec2 p);
+
+	// Resolved from desc by setDescriptor
+	SampleFn sampleFn = nullptr;
+	DerivativeFn derivativeFn = nullptr; // nullptr when there is no analytic derivative
+	LatticeDerivativeFn latticeDerivativeFn = nullptr;
+	NoiseSimd::Params params{};
+	NoiseSimd::PointsFn pointsFn = nullptr;
+	LatticeFn latticeFn = nullptr; // nullptr when the function has no lattice walking path
+	NoiseSimd::Params octaveParams{}; // Single octave, unit frequency and amplitude
+	NoiseSimd::PointsFn octavePointsFn = nullptr;
+	NoiseSimd::Params prewarpedParams{}; // Domain warp with the warp already applied to the coordinates
+	NoiseSimd::PointsFn prewarpedPointsFn = nullptr;
+	NoiseSimd::Params warpParams{}; // FBM lookups of the domain warp, coordinates already scaled by the warp frequency
+	NoiseSimd::PointsFn warpPointsFn = nullptr;
+	SampleFn3 sampleFn3 = nullptr;
+	SampleLargeFn sampleLargeFn = nullptr;
+	NoiseSimd::Points3Fn points3Fn = nullptr;
+	float detailBase = 0.0f; // octaveDetail = detailBase - detailSlope * log2(distance^2)
+	float detailSlope = 0.0f;
+	NoiseHash::ScalarKey hashKey{}; // desc.seed and the tables of the Permutation hash
+	std::shared_ptr<const NoiseHash::PermutationTable> permutationTable; // Rebuilt only when the seed changes, shared by copies
+
+	// Range of octaveDetail over a grid, with the detail of every sample when some octave fades within it
+	struct GridDetail {
+		float lowest = std::numeric_limits<float>::infinity();
+		float highest = std::numeric_limits<float>::infinity();
+		std::vector<float> samples;
+
+		bool culled(int octave) const {
+			return highest <= float(octave);
+		}
+	};
 
-	float evalLinear(glm::vec2 p) {
-		int x0 = int(glm::floor(p.x)) * PrimeX;
-		int y0 = int(glm::floor(p.y)) * PrimeY;
+	void fillPoints(std::span<float> out, const std::vector<float> &xs, const std::vector<float> &ys, NoiseSimd::PointsFn fn, const NoiseSimd::Params &fnParams) const;
+	void fillLattice(std::span<float> out, std::vector<float> xs, std::vector<float> ys, float spacing, const GridDetail &detail) const;
+	void shapeOctave(std::span<float> layer) const; // octaveShape for desc.fractal over a whole layer
 
-		int x1 = x0 + PrimeX;
-		int y1 = y0 + PrimeY;
+	/**
+	 * Subgrid stride of every octave under desc.octaveTolerance, 1 to sample an octave everywhere.
+	 * The tolerance is shared between the octaves that can be sampled more coarsely at all.
+	 * @param falloff Bound on the weight ratio between consecutive octaves
+	 * @param spacing Distance between samples in lattice cells of the first octave
+	 */
+	std::vector<int> octaveStrides(float falloff, float spacing, int width, int height) const;
 
-		float c00 = hashPrimedFloat(desc.seed, x0, y0);
-		float c10 = hashPrimedFloat(desc.seed, x1, y0);
-		float c01 = hashPrimedFloat(desc.seed, x0, y1);
-		float c11 = hashPrimedFloat(desc.seed, x1, y1);
+	// Detail over the separable grid (xs[col], ys[row]) in world units
+	GridDetail gridDetail(const std::vector<float> &xs, const std::vector<float> &ys) const;
 
-		glm::vec2 t = glm::fract(p);
+	// Fades a raw octave towards OctaveMean by the grid detail, scaling its gradients along
+	void fadeOctave(std::span<float> layer, glm::vec2 *gradients, const GridDetail &detail, int octave) const;
 
-		switch (desc.interpolation) {
-			case Interpolation::Linear:
-				break;
-			case Interpolation::Smoothstep:
-				t = smoothStep(t);
-				break;
-			case Interpolation::Smootherstep:
-				t = smootherStep(t);
-				break;
-			default:
-				break;
+	// One raw octave over the separable grid (xs[col], ys[row]), already scaled by the octave frequency.
+	// With a stride above 1 it is sampled every stride samples and upsampled.
+	void fillOctave(std::span<float> layer, const std::vector<float> &xs, const std::vector<float> &ys, float spacing, int stride) const;
+
+	// Rebuilds layers unless they already hold the grid with the current layer settings
+	void updateOctaveLayers(OctaveLayers &layers, glm::vec2 origin, glm::vec2 step, int width, int height, bool derivatives) const;
+	void sumOctaveLayers(std::span<float> out, const OctaveLayers &layers) const;
+	void sumOctaveLayers(std::span<glm::vec3> out, const OctaveLayers &layers) const;
+
+
+	// Corner of the lattice cell around a point, times PrimeX and PrimeY, and the offset from it in [0, 1)
+	struct LatticePoint {
+		int x;
+		int y;
+		glm::vec2 t;
+	};
+
+	// Lattice coordinate times a hash prime, wrapping like the hashes do at any distance
+	static int primed(int64_t cell, int prime) {
+		return static_cast<int>(static_cast<uint32_t>(cell) * static_cast<uint32_t>(prime));
+	}
+
+	// Primed coordinate of the cell steps cells past primedCell, wrapping like primed
+	static int stepPrimed(int primedCell, int steps, int prime) {
+		return static_cast<int>(static_cast<uint32_t>(primedCell) + static_cast<uint32_t>(steps) * static_cast<uint32_t>(prime));
+	}
+
+	static LatticePoint latticePoint(glm::vec2 p) {
+		return {primed(static_cast<int64_t>(glm::floor(p.x)), PrimeX), primed(static_cast<int64_t>(glm::floor(p.y)), PrimeY), glm::fract(p)};
+	}
+
+	template<class H, Interpolation I>
+	float evalLinear(glm::vec2 p) const {
+		return evalLinear<H, I>(latticePoint(p));
+	}
+
+	template<class H, Interpolation I>
+	float evalLinear(const LatticePoint &l) const {
+		int x0 = l.x;
+		int y0 = l.y;
+
+		int x1 = stepPrimed(x0, 1, PrimeX);
+		int y1 = stepPrimed(y0, 1, PrimeY);
+
+		float c00 = NoiseHash::hashFloat<H>(hashKey, x0, y0);
+		float c10 = NoiseHash::hashFloat<H>(hashKey, x1, y0);
+		float c01 = NoiseHash::hashFloat<H>(hashKey, x0, y1);
+		float c11 = NoiseHash::hashFloat<H>(hashKey, x1, y1);
+
+		glm::vec2 t = l.t;
+
+		if constexpr (I == Interpolation::Smoothstep) {
+			t = smoothStep(t);
 		}
+		else if constexpr (I == Interpolation::Smootherstep) {
+			t = smootherStep(t);
+		}
+
 		// Linear interpolate between the four corners
 		float top = lerp(c00, c10, t.x);
 		float bot = lerp(c01, c11, t.x);
@@ -214,44 +678,50 @@ private:
 
 
 	// Given a float point, evaluate the value noise using the surrounding 3x3 grid of integer points.
-	float evalCubic(glm::vec2 p) {
+	template<class H>
+	float evalCubic(glm::vec2 p) const {
+		return evalCubic<H>(latticePoint(p));
+	}
 
-		float xFrac = glm::fract(p.x);
-		float yFrac = glm::fract(p.y);
+	template<class H>
+	float evalCubic(const LatticePoint &l) const {
+
+		float xFrac = l.t.x;
+		float yFrac = l.t.y;
 
 		// Generate the primed coordinates for the 16 surrounding points.
-		int x1 = int(glm::floor(p.x)) * PrimeX;
-		int y1 = int(glm::floor(p.y)) * PrimeY;
-		int x0 = x1 - PrimeX;
-		int y0 = y1 - PrimeY;
-		int x2 = x1 + PrimeX;
-		int y2 = y1 + PrimeY;
-		int x3 = x2 + PrimeX; // Advance two steps
-		int y3 = y2 + PrimeY;
+		int x1 = l.x;
+		int y1 = l.y;
+		int x0 = stepPrimed(x1, -1, PrimeX);
+		int y0 = stepPrimed(y1, -1, PrimeY);
+		int x2 = stepPrimed(x1, 1, PrimeX);
+		int y2 = stepPrimed(y1, 1, PrimeY);
+		int x3 = stepPrimed(x1, 2, PrimeX); // Advance two steps
+		int y3 = stepPrimed(y1, 2, PrimeY);
 
 		// First Row
-		float c00 = hashPrimedFloat(desc.seed, x0, y0);
-		float c10 = hashPrimedFloat(desc.seed, x1, y0);
-		float c20 = hashPrimedFloat(desc.seed, x2, y0);
-		float c30 = hashPrimedFloat(desc.seed, x3, y0);
+		float c00 = NoiseHash::hashFloat<H>(hashKey, x0, y0);
+		float c10 = NoiseHash::hashFloat<H>(hashKey, x1, y0);
+		float c20 = NoiseHash::hashFloat<H>(hashKey, x2, y0);
+		float c30 = NoiseHash::hashFloat<H>(hashKey, x3, y0);
 
 		// Second Row
-		float c01 = hashPrimedFloat(desc.seed, x0, y1);
-		float c11 = hashPrimedFloat(desc.seed, x1, y1);
-		float c21 = hashPrimedFloat(desc.seed, x2, y1);
-		float c31 = hashPrimedFloat(desc.seed, x3, y1);
+		float c01 = NoiseHash::hashFloat<H>(hashKey, x0, y1);
+		float c11 = NoiseHash::hashFloat<H>(hashKey, x1, y1);
+		float c21 = NoiseHash::hashFloat<H>(hashKey, x2, y1);
+		float c31 = NoiseHash::hashFloat<H>(hashKey, x3, y1);
 
 		// Third Row
-		float c02 = hashPrimedFloat(desc.seed, x0, y2);
-		float c12 = hashPrimedFloat(desc.seed, x1, y2);
-		float c22 = hashPrimedFloat(desc.seed, x2, y2);
-		float c32 = hashPrimedFloat(desc.seed, x3, y2);
+		float c02 = NoiseHash::hashFloat<H>(hashKey, x0, y2);
+		float c12 = NoiseHash::hashFloat<H>(hashKey, x1, y2);
+		float c22 = NoiseHash::hashFloat<H>(hashKey, x2, y2);
+		float c32 = NoiseHash::hashFloat<H>(hashKey, x3, y2);
 
 		// Fourth Row
-		float c03 = hashPrimedFloat(desc.seed, x0, y3);
-		float c13 = hashPrimedFloat(desc.seed, x1, y3);
-		float c23 = hashPrimedFloat(desc.seed, x2, y3);
-		float c33 = hashPrimedFloat(desc.seed, x3, y3);
+		float c03 = NoiseHash::hashFloat<H>(hashKey, x0, y3);
+		float c13 = NoiseHash::hashFloat<H>(hashKey, x1, y3);
+		float c23 = NoiseHash::hashFloat<H>(hashKey, x2, y3);
+		float c33 = NoiseHash::hashFloat<H>(hashKey, x3, y3);
 
 		// Interpolate each row
 		float r0 = cubicLerp(c00, c10, c20, c30, xFrac);
@@ -268,10 +738,249 @@ private:
 
 	}
 
+	// evalLinear with its derivative, in lattice units
+	template<class H, Interpolation I>
+	glm::vec3 evalLinearDerivative(glm::vec2 p) const {
+		LatticePoint l = latticePoint(p);
+		int x0 = l.x;
+		int y0 = l.y;
+
+		int x1 = stepPrimed(x0, 1, PrimeX);
+		int y1 = stepPrimed(y0, 1, PrimeY);
+
+		float c00 = NoiseHash::hashFloat<H>(hashKey, x0, y0);
+		float c10 = NoiseHash::hashFloat<H>(hashKey, x1, y0);
+		float c01 = NoiseHash::hashFloat<H>(hashKey, x0, y1);
+		float c11 = NoiseHash::hashFloat<H>(hashKey, x1, y1);
+
+		glm::vec2 f = l.t;
+		glm::vec2 t = f;
+		glm::vec2 dt(1.0f);
+
+		if constexpr (I == Interpolation::Smoothstep) {
+			t = smoothStep(f);
+			dt = smoothStepDerivative(f);
+		}
+		else if constexpr (I == Interpolation::Smootherstep) {
+			t = smootherStep(f);
+			dt = smootherStepDerivative(f);
+		}
+
+		float top = lerp(c00, c10, t.x);
+		float bot = lerp(c01, c11, t.x);
+		float dx = lerp(c10 - c00, c11 - c01, t.y) * dt.x;
+		float dy = (bot - top) * dt.y;
+		return {lerp(top, bot, t.y), dx, dy};
+	}
+
+	// evalCubic with its derivative, in lattice units
+	template<class H>
+	glm::vec3 evalCubicDerivative(glm::vec2 p) const {
+		LatticePoint l = latticePoint(p);
+
+		float xFrac = l.t.x;
+		float yFrac = l.t.y;
+
+		int x1 = l.x;
+		int y1 = l.y;
+		int x0 = stepPrimed(x1, -1, PrimeX);
+		int y0 = stepPrimed(y1, -1, PrimeY);
+		int x2 = stepPrimed(x1, 1, PrimeX);
+		int y2 = stepPrimed(y1, 1, PrimeY);
+		int x3 = stepPrimed(x1, 2, PrimeX);
+		int y3 = stepPrimed(y1, 2, PrimeY);
+
+		// Each row interpolated along x, with its derivative along x
+		glm::vec2 r0 = cubicLerpWithDerivative(NoiseHash::hashFloat<H>(hashKey, x0, y0), NoiseHash::hashFloat<H>(hashKey, x1, y0), NoiseHash::hashFloat<H>(hashKey, x2, y0), NoiseHash::hashFloat<H>(hashKey, x3, y0), xFrac);
+		glm::vec2 r1 = cubicLerpWithDerivative(NoiseHash::hashFloat<H>(hashKey, x0, y1), NoiseHash::hashFloat<H>(hashKey, x1, y1), NoiseHash::hashFloat<H>(hashKey, x2, y1), NoiseHash::hashFloat<H>(hashKey, x3, y1), xFrac);
+		glm::vec2 r2 = cubicLerpWithDerivative(NoiseHash::hashFloat<H>(hashKey, x0, y2), NoiseHash::hashFloat<H>(hashKey, x1, y2), NoiseHash::hashFloat<H>(hashKey, x2, y2), NoiseHash::hashFloat<H>(hashKey, x3, y2), xFrac);
+		glm::vec2 r3 = cubicLerpWithDerivative(NoiseHash::hashFloat<H>(hashKey, x0, y3), NoiseHash::hashFloat<H>(hashKey, x1, y3), NoiseHash::hashFloat<H>(hashKey, x2, y3), NoiseHash::hashFloat<H>(hashKey, x3, y3), xFrac);
+
+		glm::vec2 v = cubicLerpWithDerivative(r0.x, r1.x, r2.x, r3.x, yFrac);
+
+		// The x derivative passes through the y interpolation unless it clamps
+		float dx = 0.0f;
+		if (v.x > 0.0f && v.x < 1.0f) {
+			glm::vec4 w = cubicLerpWeights(yFrac);
+			dx = w.x * r0.y + w.y * r1.y + w.z * r2.y + w.w * r3.y;
+		}
+		return {v.x, dx, v.y};
+	}
+
+	// Gradient noise on the square lattice. Always uses quintic interpolation, the interpolation setting is ignored.
+	template<class H>
+	float evalPerlin(glm::vec2 p) const {
+		return evalPerlin<H>(latticePoint(p));
+	}
+
+	template<class H>
+	float evalPerlin(const LatticePoint &l) const {
+		int x0 = l.x;
+		int y0 = l.y;
+		int x1 = stepPrimed(x0, 1, PrimeX);
+		int y1 = stepPrimed(y0, 1, PrimeY);
+
+		// Offsets from the bottom left corner
+		glm::vec2 d = l.t;
+
+		float g00 = gradientDot(NoiseHash::hashInt<H>(hashKey, x0, y0), d.x, d.y);
+		float g10 = gradientDot(NoiseHash::hashInt<H>(hashKey, x1, y0), d.x - 1.0f, d.y);
+		float g01 = gradientDot(NoiseHash::hashInt<H>(hashKey, x0, y1), d.x, d.y - 1.0f);
+		float g11 = gradientDot(NoiseHash::hashInt<H>(hashKey, x1, y1), d.x - 1.0f, d.y - 1.0f);
+
+		glm::vec2 t = smootherStep(d);
+		float top = lerp(g00, g10, t.x);
+		float bot = lerp(g01, g11, t.x);
+		return glm::clamp(lerp(top, bot, t.y) * PerlinScale * 0.5f + 0.5f, 0.0f, 1.0f);
+	}
+
+	// Contribution of one simplex corner at offset (x, y), radial falloff (0.5 - r^2)^4
+	static float simplexCorner(int hash, float x, float y) {
+		float a = glm::max(0.5f - x * x - y * y, 0.0f);
+		a *= a;
+		return a * a * gradientDot(hash, x, y);
+	}
+
+	// OpenSimplex style gradient noise on the skewed triangular lattice
+	template<class H>
+	float evalSimplex(glm::vec2 p) const {
+		// Skew into the square lattice to find the cell
+		float s = (p.x + p.y) * SimplexF2;
+		float i = glm::floor(p.x + s);
+		float j = glm::floor(p.y + s);
+
+		// Unskew the cell origin back and take the offsets from it
+		float t = (i + j) * SimplexG2;
+		float x0 = p.x - (i - t);
+		float y0 = p.y - (j - t);
+
+		return evalSimplexCell<H>(primed(static_cast<int64_t>(i), PrimeX), primed(static_cast<int64_t>(j), PrimeY), x0, y0);
+	}
+
+	// Simplex noise of the skewed cell (iPrimed, jPrimed), at the unskewed offset (x0, y0) from its origin
+	template<class H>
+	float evalSimplexCell(int iPrimed, int jPrimed, float x0, float y0) const {
+		// Lower or upper triangle of the cell
+		bool lower = x0 > y0;
+		float x1 = x0 - (lower ? 1.0f : 0.0f) + SimplexG2;
+		float y1 = y0 - (lower ? 0.0f : 1.0f) + SimplexG2;
+		float x2 = x0 - 1.0f + 2.0f * SimplexG2;
+		float y2 = y0 - 1.0f + 2.0f * SimplexG2;
+
+		float n0 = simplexCorner(NoiseHash::hashInt<H>(hashKey, iPrimed, jPrimed), x0, y0);
+		float n1 = simplexCorner(NoiseHash::hashInt<H>(hashKey, stepPrimed(iPrimed, lower ? 1 : 0, PrimeX), stepPrimed(jPrimed, lower ? 0 : 1, PrimeY)), x1, y1);
+		float n2 = simplexCorner(NoiseHash::hashInt<H>(hashKey, stepPrimed(iPrimed, 1, PrimeX), stepPrimed(jPrimed, 1, PrimeY)), x2, y2);
+
+		return glm::clamp((n0 + n1 + n2) * SimplexScale * 0.5f + 0.5f, 0.0f, 1.0f);
+	}
+
+	// Feature point of the cell hashed to h, as an offset in [0, 1) from the cell corner.
+	// Both offsets come from the well mixed high half after folding it onto the low half.
+	static glm::vec2 cellularOffset(int h) {
+		h ^= h >> 15;
+		return glm::vec2(float(h & 0xffff), float((h >> 16) & 0xffff)) * (1.0f / 65536.0f);
+	}
+
+	// Euclidean distances are compared squared and rooted once at the end
+	template<CellularDistance D>
+	static float cellularDistance(float x, float y) {
+		if constexpr (D == CellularDistance::Manhattan) {
+			return glm::abs(x) + glm::abs(y);
+		}
+		else {
+			return x * x + y * y;
+		}
+	}
+
+	// The 3x3 cell neighbourhood, centre first, then edges, then corners so the closest cells narrow the search early
+	static constexpr int CellularNeighbours[9][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+
+	// Worley noise: distances to the jittered feature points of the surrounding cells
+	template<class H, CellularDistance D, CellularReturn C>
+	float evalCellular(glm::vec2 p) const {
+		return evalCellular<H, D, C>(latticePoint(p));
+	}
+
+	template<class H, CellularDistance D, CellularReturn C>
+	float evalCellular(const LatticePoint &l) const {
+		int x0 = l.x;
+		int y0 = l.y;
+		glm::vec2 t = l.t;
+
+		float f1 = CellularMaxDistance;
+		float f2 = CellularMaxDistance;
+
+		for (const auto &[i, j] : CellularNeighbours) {
+			// Skip the cell when even its closest point can't beat the distance the return value depends on
+			float edgeX = i < 0 ? t.x : (i > 0 ? 1.0f - t.x : 0.0f);
+			float edgeY = j < 0 ? t.y : (j > 0 ? 1.0f - t.y : 0.0f);
+			if (cellularDistance<D>(edgeX, edgeY) >= (C == CellularReturn::F1 ? f1 : f2)) {
+				continue;
+			}
+
+			int xPrimed = stepPrimed(x0, i, PrimeX);
+			int yPrimed = stepPrimed(y0, j, PrimeY);
+			glm::vec2 offset = cellularOffset(NoiseHash::hashInt<H>(hashKey, xPrimed, yPrimed));
+			float d = cellularDistance<D>((float(i) + offset.x) - t.x, (float(j) + offset.y) - t.y);
+
+			f2 = glm::min(glm::max(f1, d), f2);
+			f1 = glm::min(f1, d);
+		}
+
+		if constexpr (D == CellularDistance::Euclidean) {
+			f1 = glm::sqrt(f1);
+			f2 = glm::sqrt(f2);
+		}
+
+		if constexpr (C == CellularReturn::F2) {
+			return glm::clamp(f2 * CellularScale, 0.0f, 1.0f);
+		}
+		else if constexpr (C == CellularReturn::F2MinusF1) {
+			return glm::clamp((f2 - f1) * CellularScale, 0.0f, 1.0f);
+		}
+		else {
+			return glm::clamp(f1 * CellularScale, 0.0f, 1.0f);
+		}
+	}
+
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C>
+	float evalFunction(glm::vec2 p) const {
+		if constexpr (F == Function::Cellular) {
+			return evalCellular<H, D, C>(p);
+		}
+		else if constexpr (F == Function::ValueCubic) {
+			return evalCubic<H>(p);
+		}
+		else if constexpr (F == Function::Perlin) {
+			return evalPerlin<H>(p);
+		}
+		else if constexpr (F == Function::Simplex) {
+			return evalSimplex<H>(p);
+		}
+		else {
+			return evalLinear<H, I>(p);
+		}
+	}
+
+	// Domain warp offset at p in world units, two FBM lookups at the warp frequency mapped to [-1, 1]
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C>
+	glm::vec2 evalWarp(glm::vec2 p) const {
+		glm::vec2 q = p * (desc.frequency * desc.warpFrequency);
+		float wx = evalFBm<H, F, I, D, C, Fractal::FBM>(q);
+		float wy = evalFBm<H, F, I, D, C, Fractal::FBM>(q + glm::vec2(WarpOffsetX, WarpOffsetY));
+		return glm::vec2(wx * 2.0f - 1.0f, wy * 2.0f - 1.0f) * desc.warpAmplitude;
+	}
+
+	// Octave loop shared by FBM, ridged and turbulence.
 	// Todo: Check correctness compared to old version
-	float evalFBm(glm::vec2 p) {
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	float evalFBm(glm::vec2 p, float detail = std::numeric_limits<float>::infinity()) const {
+		return sumOctaves<R>([&](float freq) { return evalFunction<H, F, I, D, C>(p * freq); }, detail);
+	}
 
-		int s = desc.seed;
+	// The octave loop over octave(freq), the function at freq times the first octave frequency
+	template<Fractal R, class Octave>
+	float sumOctaves(Octave octave, float detail) const {
 
 		// Decrease amplitude as octaves increase
 		float amp = lerp(0.4f, 1.0f, 1.0f / desc.octaves);
@@ -280,19 +989,15 @@ private:
 
 		for (int i = 0; i < desc.octaves; i++) {
 
-			float noise;
-			switch (desc.function) {
-				case Function::Value:
-					noise = evalLinear(p * freq);
-					break;
-				case Function::ValueCubic:
-					noise = evalCubic(p * freq);
-					break;
-				default:
-					noise = evalLinear(p * freq);
-					break;
+			// Octaves below the feature size fade to their mean and are no longer evaluated
+			float noise = OctaveMean;
+			float fade = glm::clamp(detail - float(i), 0.0f, 1.0f);
+			if (fade > 0.0f) {
+				noise = octaveShape<R>(octave(freq));
+				if (fade < 1.0f) {
+					noise = lerp(OctaveMean, noise, fade);
+				}
 			}
-			s++;
 			sum += amp * noise;
 
 			// Amplify the smaller values, don't oversaturate the larger values.
@@ -308,6 +1013,621 @@ private:
 		return glm::clamp(sum, 0.0f, 1.0f);
 
 	}
+
+	template<class H, Function F, Interpolation I>
+	glm::vec3 evalFunctionDerivative(glm::vec2 p) const {
+		if constexpr (F == Function::ValueCubic) {
+			return evalCubicDerivative<H>(p);
+		}
+		else {
+			return evalLinearDerivative<H, I>(p);
+		}
+	}
+
+	// evalFunctionDerivative for the function, interpolation and hash of desc, picked at runtime
+	glm::vec3 evalOctaveDerivative(glm::vec2 p) const {
+		return NoiseHash::dispatch(desc.hash, [&]<class H>() { return evalOctaveDerivative<H>(p); });
+	}
+
+	template<class H>
+	glm::vec3 evalOctaveDerivative(glm::vec2 p) const {
+		if (desc.function == Function::ValueCubic) {
+			return evalCubicDerivative<H>(p);
+		}
+		switch (desc.interpolation) {
+			case Interpolation::Smoothstep:
+				return evalLinearDerivative<H, Interpolation::Smoothstep>(p);
+			case Interpolation::Smootherstep:
+				return evalLinearDerivative<H, Interpolation::Smootherstep>(p);
+			default:
+				return evalLinearDerivative<H, Interpolation::Linear>(p);
+		}
+	}
+
+	// evalFBm with its derivative. The octave weights depend on the previous octaves, so their derivatives
+	// are carried along with them. Octave fades are slow enough to count as constant.
+	template<class H, Function F, Interpolation I>
+	glm::vec3 evalFBmDerivative(glm::vec2 p, float detail = std::numeric_limits<float>::infinity()) const {
+
+		float amp = lerp(0.4f, 1.0f, 1.0f / desc.octaves);
+		glm::vec2 dAmp(0.0f);
+		float freq = 1.0f;
+		float sum = 0.0f;
+		glm::vec2 dSum(0.0f);
+
+		for (int i = 0; i < desc.octaves; i++) {
+
+			glm::vec3 noise(OctaveMean, 0.0f, 0.0f);
+			float fade = glm::clamp(detail - float(i), 0.0f, 1.0f);
+			if (fade > 0.0f) {
+				noise = evalFunctionDerivative<H, F, I>(p * freq);
+				if (fade < 1.0f) {
+					noise = {lerp(OctaveMean, noise.x, fade), noise.y * fade, noise.z * fade};
+				}
+			}
+			glm::vec2 dNoise = glm::vec2(noise.y, noise.z) * freq;
+			sum += amp * noise.x;
+			dSum += dAmp * noise.x + dNoise * amp;
+
+			float weight = lerp(1.0f, (noise.x * 0.5f), desc.weightedStrength);
+			glm::vec2 dWeight = dNoise * (0.5f * desc.weightedStrength);
+			dAmp = (dAmp * weight + dWeight * amp) * desc.gain;
+			amp *= weight;
+			amp *= desc.gain;
+
+			freq *= desc.lacunarity;
+
+		}
+
+		if (sum <= 0.0f || sum >= 1.0f) {
+			dSum = glm::vec2(0.0f);
+		}
+		return {glm::clamp(sum, 0.0f, 1.0f), dSum.x, dSum.y};
+
+	}
+
+	template<class H, Function F, Interpolation I, Fractal R>
+	static glm::vec3 sampleDerivative(const Noise &noise, glm::vec2 p) {
+
+		float detail = noise.octaveDetail(p);
+		p = p * noise.desc.frequency;
+
+		glm::vec3 out;
+		if constexpr (R == Fractal::FBM) {
+			out = noise.evalFBmDerivative<H, F, I>(p, detail);
+		}
+		else {
+			out = noise.evalFunctionDerivative<H, F, I>(p);
+		}
+
+		// Back to world units
+		float scale = noise.desc.frequency * noise.desc.amplitude;
+		return {out.x * noise.desc.amplitude, out.y * scale, out.z * scale};
+	}
+
+	// One specialized kernel per hash, function, interpolation, cellular variant and fractal combination
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	static float sample(const Noise &noise, glm::vec2 p) {
+
+		// Domain warping moves the sample before the FBM evaluation
+		if constexpr (R == Fractal::DomainWarp) {
+			p = p + noise.evalWarp<H, F, I, D, C>(p);
+		}
+
+		float detail = isOctaveFractal(R) ? noise.octaveDetail(p) : 0.0f;
+		p = p * noise.desc.frequency;
+
+		float out;
+		if constexpr (isOctaveFractal(R)) {
+			out = noise.evalFBm<H, F, I, D, C, R>(p, detail);
+		}
+		else if constexpr (R == Fractal::DomainWarp) {
+			out = noise.evalFBm<H, F, I, D, C, Fractal::FBM>(p);
+		}
+		else {
+			out = noise.evalFunction<H, F, I, D, C>(p);
+		}
+
+		return out * noise.desc.amplitude;
+	}
+
+
+	// Large Coordinate Kernels
+	// ----------------------------
+
+	// Lattice cell along one axis and the offset inside it in [0, 1)
+	struct LatticeAxis {
+		int64_t cell;
+		float t;
+	};
+
+	// World coordinate origin + offset in fixed point
+	static int64_t toFixed(int64_t origin, float offset) {
+		return origin * (int64_t(1) << FixedBits) + std::llround(double(offset) * double(1 << FixedBits));
+	}
+
+	static glm::i64vec2 toFixed(glm::i64vec2 origin, glm::vec2 offset) {
+		return {toFixed(origin.x, offset.x), toFixed(origin.y, offset.y)};
+	}
+
+	// The fixed point coordinates a * scaleA + b * scaleB, computed exactly and split into a lattice cell and the offset inside it
+	static LatticeAxis latticeAxis(int64_t a, float scaleA, int64_t b = 0, float scaleB = 0.0f);
+
+	// octaveDetail at a fixed point position, the distance taken in double precision
+	float octaveDetail(glm::i64vec2 p) const {
+		if (!cullsOctaves()) {
+			return std::numeric_limits<float>::infinity();
+		}
+		glm::dvec2 d = glm::dvec2(p) * (1.0 / double(1 << FixedBits)) - glm::dvec2(desc.detailCenter);
+		return octaveDetailAt(float(glm::dot(d, d)));
+	}
+
+	// evalFunction at the fixed point position p times scale
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C>
+	float evalFunction(glm::i64vec2 p, float scale) const {
+		if constexpr (F == Function::Simplex) {
+			// Skew the fixed point position, then unskew the offsets inside the cell
+			float along = scale * (1.0f + SimplexF2);
+			float across = scale * SimplexF2;
+			LatticeAxis i = latticeAxis(p.x, along, p.y, across);
+			LatticeAxis j = latticeAxis(p.y, along, p.x, across);
+			float t = (i.t + j.t) * SimplexG2;
+			return evalSimplexCell<H>(primed(i.cell, PrimeX), primed(j.cell, PrimeY), i.t - t, j.t - t);
+		}
+		else {
+			LatticeAxis x = latticeAxis(p.x, scale);
+			LatticeAxis y = latticeAxis(p.y, scale);
+			LatticePoint l{primed(x.cell, PrimeX), primed(y.cell, PrimeY), glm::vec2(x.t, y.t)};
+
+			if constexpr (F == Function::Cellular) {
+				return evalCellular<H, D, C>(l);
+			}
+			else if constexpr (F == Function::ValueCubic) {
+				return evalCubic<H>(l);
+			}
+			else if constexpr (F == Function::Perlin) {
+				return evalPerlin<H>(l);
+			}
+			else {
+				return evalLinear<H, I>(l);
+			}
+		}
+	}
+
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	float evalFBm(glm::i64vec2 p, float scale, float detail = std::numeric_limits<float>::infinity()) const {
+		return sumOctaves<R>([&](float freq) { return evalFunction<H, F, I, D, C>(p, scale * freq); }, detail);
+	}
+
+	// evalWarp at a fixed point position, in fixed point. The y lookup is shifted by WarpOffset lattice cells of the
+	// first warp octave like in evalWarp.
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C>
+	glm::i64vec2 evalWarp(glm::i64vec2 p) const {
+		float scale = desc.frequency * desc.warpFrequency;
+		glm::i64vec2 shift = toFixed(glm::i64vec2(0), glm::vec2(WarpOffsetX, WarpOffsetY) / scale);
+		float wx = evalFBm<H, F, I, D, C, Fractal::FBM>(p, scale);
+		float wy = evalFBm<H, F, I, D, C, Fractal::FBM>(p + shift, scale);
+		return toFixed(glm::i64vec2(0), glm::vec2(wx * 2.0f - 1.0f, wy * 2.0f - 1.0f) * desc.warpAmplitude);
+	}
+
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	static float sampleLarge(const Noise &noise, glm::i64vec2 origin, glm::vec2 offset) {
+		glm::i64vec2 p = toFixed(origin, offset);
+
+		if constexpr (R == Fractal::DomainWarp) {
+			p = p + noise.evalWarp<H, F, I, D, C>(p);
+		}
+
+		float out;
+		if constexpr (isOctaveFractal(R)) {
+			out = noise.evalFBm<H, F, I, D, C, R>(p, noise.desc.frequency, noise.octaveDetail(p));
+		}
+		else if constexpr (R == Fractal::DomainWarp) {
+			out = noise.evalFBm<H, F, I, D, C, Fractal::FBM>(p, noise.desc.frequency);
+		}
+		else {
+			out = noise.evalFunction<H, F, I, D, C>(p, noise.desc.frequency);
+		}
+
+		return out * noise.desc.amplitude;
+	}
+
+
+	// 3D Kernels
+	// ----------------------------
+
+	template<class H, Interpolation I>
+	float evalLinear(glm::vec3 p) const {
+		int x0 = primed(static_cast<int64_t>(glm::floor(p.x)), PrimeX);
+		int y0 = primed(static_cast<int64_t>(glm::floor(p.y)), PrimeY);
+		int z0 = primed(static_cast<int64_t>(glm::floor(p.z)), PrimeZ);
+		int x1 = stepPrimed(x0, 1, PrimeX);
+		int y1 = stepPrimed(y0, 1, PrimeY);
+		int z1 = stepPrimed(z0, 1, PrimeZ);
+
+		glm::vec3 t = glm::fract(p);
+		if constexpr (I == Interpolation::Smoothstep) {
+			t = smoothStep(t);
+		}
+		else if constexpr (I == Interpolation::Smootherstep) {
+			t = smootherStep(t);
+		}
+
+		// Along x on the four lattice edges, then y, then z
+		float x00 = lerp(NoiseHash::hashFloat3<H>(hashKey, x0, y0, z0), NoiseHash::hashFloat3<H>(hashKey, x1, y0, z0), t.x);
+		float x10 = lerp(NoiseHash::hashFloat3<H>(hashKey, x0, y1, z0), NoiseHash::hashFloat3<H>(hashKey, x1, y1, z0), t.x);
+		float x01 = lerp(NoiseHash::hashFloat3<H>(hashKey, x0, y0, z1), NoiseHash::hashFloat3<H>(hashKey, x1, y0, z1), t.x);
+		float x11 = lerp(NoiseHash::hashFloat3<H>(hashKey, x0, y1, z1), NoiseHash::hashFloat3<H>(hashKey, x1, y1, z1), t.x);
+		return lerp(lerp(x00, x10, t.y), lerp(x01, x11, t.y), t.z);
+	}
+
+	// cubicLerp through the 4x4x4 neighbourhood, rows along x, then planes along y, then along z
+	template<class H>
+	float evalCubic(glm::vec3 p) const {
+		glm::vec3 frac = glm::fract(p);
+		int x1 = primed(static_cast<int64_t>(glm::floor(p.x)), PrimeX);
+		int y1 = primed(static_cast<int64_t>(glm::floor(p.y)), PrimeY);
+		int z1 = primed(static_cast<int64_t>(glm::floor(p.z)), PrimeZ);
+		int xs[4] = {stepPrimed(x1, -1, PrimeX), x1, stepPrimed(x1, 1, PrimeX), stepPrimed(x1, 2, PrimeX)};
+		int ys[4] = {stepPrimed(y1, -1, PrimeY), y1, stepPrimed(y1, 1, PrimeY), stepPrimed(y1, 2, PrimeY)};
+		int zs[4] = {stepPrimed(z1, -1, PrimeZ), z1, stepPrimed(z1, 1, PrimeZ), stepPrimed(z1, 2, PrimeZ)};
+
+		float planes[4];
+		for (int k = 0; k < 4; k++) {
+			float rows[4];
+			for (int j = 0; j < 4; j++) {
+				rows[j] = cubicLerp(NoiseHash::hashFloat3<H>(hashKey, xs[0], ys[j], zs[k]), NoiseHash::hashFloat3<H>(hashKey, xs[1], ys[j], zs[k]),
+									NoiseHash::hashFloat3<H>(hashKey, xs[2], ys[j], zs[k]), NoiseHash::hashFloat3<H>(hashKey, xs[3], ys[j], zs[k]), frac.x);
+			}
+			planes[k] = cubicLerp(rows[0], rows[1], rows[2], rows[3], frac.y);
+		}
+		return cubicLerp(planes[0], planes[1], planes[2], planes[3], frac.z);
+	}
+
+	template<class H>
+	float evalPerlin(glm::vec3 p) const {
+		int x0 = primed(static_cast<int64_t>(glm::floor(p.x)), PrimeX);
+		int y0 = primed(static_cast<int64_t>(glm::floor(p.y)), PrimeY);
+		int z0 = primed(static_cast<int64_t>(glm::floor(p.z)), PrimeZ);
+		int x1 = stepPrimed(x0, 1, PrimeX);
+		int y1 = stepPrimed(y0, 1, PrimeY);
+		int z1 = stepPrimed(z0, 1, PrimeZ);
+
+		glm::vec3 d = glm::fract(p);
+		glm::vec3 d1 = d - 1.0f;
+
+		float g000 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x0, y0, z0), d.x, d.y, d.z);
+		float g100 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x1, y0, z0), d1.x, d.y, d.z);
+		float g010 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x0, y1, z0), d.x, d1.y, d.z);
+		float g110 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x1, y1, z0), d1.x, d1.y, d.z);
+		float g001 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x0, y0, z1), d.x, d.y, d1.z);
+		float g101 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x1, y0, z1), d1.x, d.y, d1.z);
+		float g011 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x0, y1, z1), d.x, d1.y, d1.z);
+		float g111 = gradientDot(NoiseHash::hashInt3<H>(hashKey, x1, y1, z1), d1.x, d1.y, d1.z);
+
+		glm::vec3 t = smootherStep(d);
+		float v = lerp(lerp(lerp(g000, g100, t.x), lerp(g010, g110, t.x), t.y), lerp(lerp(g001, g101, t.x), lerp(g011, g111, t.x), t.y), t.z);
+		return glm::clamp(v * PerlinScale3 * 0.5f + 0.5f, 0.0f, 1.0f);
+	}
+
+	// Contribution of one simplex corner at offset (x, y, z), radial falloff (0.5 - r^2)^4 so it vanishes on the
+	// far faces of the tetrahedra and the noise stays continuous
+	static float simplexCorner(int hash, float x, float y, float z) {
+		float a = glm::max(0.5f - x * x - y * y - z * z, 0.0f);
+		a *= a;
+		return a * a * gradientDot(hash, x, y, z);
+	}
+
+	// Simplex noise on the tetrahedral lattice
+	template<class H>
+	float evalSimplex(glm::vec3 p) const {
+		float s = (p.x + p.y + p.z) * SimplexF3;
+		float i = glm::floor(p.x + s);
+		float j = glm::floor(p.y + s);
+		float k = glm::floor(p.z + s);
+
+		float t = (i + j + k) * SimplexG3;
+		float x0 = p.x - (i - t);
+		float y0 = p.y - (j - t);
+		float z0 = p.z - (k - t);
+
+		// The tetrahedron is picked by the order of the offsets, the second and third corners step along the largest
+		// one and then the two largest
+		bool xy = x0 >= y0;
+		bool yz = y0 >= z0;
+		bool xz = x0 >= z0;
+		bool i1 = xy && xz;
+		bool j1 = !xy && yz;
+		bool k1 = !yz && !xz;
+		bool i2 = xy || xz;
+		bool j2 = !xy || yz;
+		bool k2 = !yz || !xz;
+
+		float x1 = x0 - (i1 ? 1.0f : 0.0f) + SimplexG3;
+		float y1 = y0 - (j1 ? 1.0f : 0.0f) + SimplexG3;
+		float z1 = z0 - (k1 ? 1.0f : 0.0f) + SimplexG3;
+		float x2 = x0 - (i2 ? 1.0f : 0.0f) + 2.0f * SimplexG3;
+		float y2 = y0 - (j2 ? 1.0f : 0.0f) + 2.0f * SimplexG3;
+		float z2 = z0 - (k2 ? 1.0f : 0.0f) + 2.0f * SimplexG3;
+		float x3 = x0 - 1.0f + 3.0f * SimplexG3;
+		float y3 = y0 - 1.0f + 3.0f * SimplexG3;
+		float z3 = z0 - 1.0f + 3.0f * SimplexG3;
+
+		int iPrimed = primed(static_cast<int64_t>(i), PrimeX);
+		int jPrimed = primed(static_cast<int64_t>(j), PrimeY);
+		int kPrimed = primed(static_cast<int64_t>(k), PrimeZ);
+
+		float n0 = simplexCorner(NoiseHash::hashInt3<H>(hashKey, iPrimed, jPrimed, kPrimed), x0, y0, z0);
+		float n1 = simplexCorner(NoiseHash::hashInt3<H>(hashKey, stepPrimed(iPrimed, i1, PrimeX), stepPrimed(jPrimed, j1, PrimeY), stepPrimed(kPrimed, k1, PrimeZ)), x1, y1, z1);
+		float n2 = simplexCorner(NoiseHash::hashInt3<H>(hashKey, stepPrimed(iPrimed, i2, PrimeX), stepPrimed(jPrimed, j2, PrimeY), stepPrimed(kPrimed, k2, PrimeZ)), x2, y2, z2);
+		float n3 = simplexCorner(NoiseHash::hashInt3<H>(hashKey, stepPrimed(iPrimed, 1, PrimeX), stepPrimed(jPrimed, 1, PrimeY), stepPrimed(kPrimed, 1, PrimeZ)), x3, y3, z3);
+
+		return glm::clamp((n0 + n1 + n2 + n3) * SimplexScale3 * 0.5f + 0.5f, 0.0f, 1.0f);
+	}
+
+	// Feature point of the 3D cell hashed to h, 10 bits per axis from the hash folded like cellularOffset
+	static glm::vec3 cellularOffset3(int h) {
+		h ^= h >> 15;
+		return glm::vec3(float(h & 0x3ff), float((h >> 10) & 0x3ff), float((h >> 20) & 0x3ff)) * (1.0f / 1024.0f);
+	}
+
+	template<CellularDistance D>
+	static float cellularDistance(float x, float y, float z) {
+		if constexpr (D == CellularDistance::Manhattan) {
+			return glm::abs(x) + glm::abs(y) + glm::abs(z);
+		}
+		else {
+			return x * x + y * y + z * z;
+		}
+	}
+
+	// The 3x3x3 cell neighbourhood, centre first, then faces, edges and corners
+	static constexpr int CellularNeighbours3[27][3] = {
+			{0, 0, 0},
+			{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1},
+			{-1, -1, 0}, {1, -1, 0}, {-1, 1, 0}, {1, 1, 0}, {-1, 0, -1}, {1, 0, -1}, {-1, 0, 1}, {1, 0, 1}, {0, -1, -1}, {0, 1, -1}, {0, -1, 1}, {0, 1, 1},
+			{-1, -1, -1}, {1, -1, -1}, {-1, 1, -1}, {1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {-1, 1, 1}, {1, 1, 1}};
+
+	template<class H, CellularDistance D, CellularReturn C>
+	float evalCellular(glm::vec3 p) const {
+		int x0 = primed(static_cast<int64_t>(glm::floor(p.x)), PrimeX);
+		int y0 = primed(static_cast<int64_t>(glm::floor(p.y)), PrimeY);
+		int z0 = primed(static_cast<int64_t>(glm::floor(p.z)), PrimeZ);
+		glm::vec3 t = glm::fract(p);
+
+		float f1 = CellularMaxDistance;
+		float f2 = CellularMaxDistance;
+
+		for (const auto &[i, j, k] : CellularNeighbours3) {
+			float edgeX = i < 0 ? t.x : (i > 0 ? 1.0f - t.x : 0.0f);
+			float edgeY = j < 0 ? t.y : (j > 0 ? 1.0f - t.y : 0.0f);
+			float edgeZ = k < 0 ? t.z : (k > 0 ? 1.0f - t.z : 0.0f);
+			if (cellularDistance<D>(edgeX, edgeY, edgeZ) >= (C == CellularReturn::F1 ? f1 : f2)) {
+				continue;
+			}
+
+			int h = NoiseHash::hashInt3<H>(hashKey, stepPrimed(x0, i, PrimeX), stepPrimed(y0, j, PrimeY), stepPrimed(z0, k, PrimeZ));
+			glm::vec3 offset = cellularOffset3(h);
+			float d = cellularDistance<D>((float(i) + offset.x) - t.x, (float(j) + offset.y) - t.y, (float(k) + offset.z) - t.z);
+
+			f2 = glm::min(glm::max(f1, d), f2);
+			f1 = glm::min(f1, d);
+		}
+
+		if constexpr (D == CellularDistance::Euclidean) {
+			f1 = glm::sqrt(f1);
+			f2 = glm::sqrt(f2);
+		}
+
+		if constexpr (C == CellularReturn::F2) {
+			return glm::clamp(f2 * CellularScale, 0.0f, 1.0f);
+		}
+		else if constexpr (C == CellularReturn::F2MinusF1) {
+			return glm::clamp((f2 - f1) * CellularScale, 0.0f, 1.0f);
+		}
+		else {
+			return glm::clamp(f1 * CellularScale, 0.0f, 1.0f);
+		}
+	}
+
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C>
+	float evalFunction(glm::vec3 p) const {
+		if constexpr (F == Function::Cellular) {
+			return evalCellular<H, D, C>(p);
+		}
+		else if constexpr (F == Function::ValueCubic) {
+			return evalCubic<H>(p);
+		}
+		else if constexpr (F == Function::Perlin) {
+			return evalPerlin<H>(p);
+		}
+		else if constexpr (F == Function::Simplex) {
+			return evalSimplex<H>(p);
+		}
+		else {
+			return evalLinear<H, I>(p);
+		}
+	}
+
+	// evalFBm in 3D, every octave is evaluated
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	float evalFBm(glm::vec3 p) const {
+		float amp = lerp(0.4f, 1.0f, 1.0f / desc.octaves);
+		float freq = 1.0f;
+		float sum = 0.0f;
+
+		for (int i = 0; i < desc.octaves; i++) {
+			float noise = octaveShape<R>(evalFunction<H, F, I, D, C>(p * freq));
+			sum += amp * noise;
+			amp *= lerp(1.0f, (noise * 0.5f), desc.weightedStrength);
+			amp *= desc.gain;
+			freq *= desc.lacunarity;
+		}
+
+		return glm::clamp(sum, 0.0f, 1.0f);
+	}
+
+	// evalWarp in 3D, a third FBM lookup for the z offset
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C>
+	glm::vec3 evalWarp(glm::vec3 p) const {
+		glm::vec3 q = p * (desc.frequency * desc.warpFrequency);
+		glm::vec3 offset(WarpOffsetX, WarpOffsetY, WarpOffsetZ);
+		float wx = evalFBm<H, F, I, D, C, Fractal::FBM>(q);
+		float wy = evalFBm<H, F, I, D, C, Fractal::FBM>(q + offset);
+		float wz = evalFBm<H, F, I, D, C, Fractal::FBM>(q - offset);
+		return glm::vec3(wx * 2.0f - 1.0f, wy * 2.0f - 1.0f, wz * 2.0f - 1.0f) * desc.warpAmplitude;
+	}
+
+	template<class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	static float sample3(const Noise &noise, glm::vec3 p) {
+		if constexpr (R == Fractal::DomainWarp) {
+			p = p + noise.evalWarp<H, F, I, D, C>(p);
+		}
+
+		p = p * noise.desc.frequency;
+
+		float out;
+		if constexpr (isOctaveFractal(R)) {
+			out = noise.evalFBm<H, F, I, D, C, R>(p);
+		}
+		else if constexpr (R == Fractal::DomainWarp) {
+			out = noise.evalFBm<H, F, I, D, C, Fractal::FBM>(p);
+		}
+		else {
+			out = noise.evalFunction<H, F, I, D, C>(p);
+		}
+
+		return out * noise.desc.amplitude;
+	}
+
+
+	// Kernel Resolution
+	// ----------------------------
+
+	// Points a sample kernel takes: 2D, 3D or 2D split into a large origin and an offset
+	enum class Domain {
+		Plane,
+		Volume,
+		LargePlane
+	};
+
+	template<Domain Dom>
+	using SampleFnOf = std::conditional_t<Dom == Domain::Volume, SampleFn3, std::conditional_t<Dom == Domain::LargePlane, SampleLargeFn, SampleFn>>;
+
+	template<Domain Dom, class H, Function F, Interpolation I, CellularDistance D, CellularReturn C, Fractal R>
+	static constexpr SampleFnOf<Dom> sampleKernel() {
+		if constexpr (Dom == Domain::Volume) {
+			return &sample3<H, F, I, D, C, R>;
+		}
+		else if constexpr (Dom == Domain::LargePlane) {
+			return &sampleLarge<H, F, I, D, C, R>;
+		}
+		else {
+			return &sample<H, F, I, D, C, R>;
+		}
+	}
+
+	template<Domain Dom, class H, Function F, Interpolation I, CellularDistance D = DefaultCellularDistance, CellularReturn C = DefaultCellularReturn>
+	static SampleFnOf<Dom> resolveFractal(Fractal fractal) {
+		switch (fractal) {
+			case Fractal::FBM:
+				return sampleKernel<Dom, H, F, I, D, C, Fractal::FBM>();
+			case Fractal::Ridged:
+				return sampleKernel<Dom, H, F, I, D, C, Fractal::Ridged>();
+			case Fractal::Turbulence:
+				return sampleKernel<Dom, H, F, I, D, C, Fractal::Turbulence>();
+			case Fractal::DomainWarp:
+				return sampleKernel<Dom, H, F, I, D, C, Fractal::DomainWarp>();
+			default:
+				return sampleKernel<Dom, H, F, I, D, C, Fractal::None>();
+		}
+	}
+
+	template<Domain Dom, class H, Function F>
+	static SampleFnOf<Dom> resolveInterpolation(Interpolation interpolation, Fractal fractal) {
+		switch (interpolation) {
+			case Interpolation::Smoothstep:
+				return resolveFractal<Dom, H, F, Interpolation::Smoothstep>(fractal);
+			case Interpolation::Smootherstep:
+				return resolveFractal<Dom, H, F, Interpolation::Smootherstep>(fractal);
+			default:
+				return resolveFractal<Dom, H, F, Interpolation::Linear>(fractal);
+		}
+	}
+
+	template<Domain Dom, class H, CellularDistance D>
+	static SampleFnOf<Dom> resolveCellularReturn(CellularReturn cellularReturn, Fractal fractal) {
+		switch (cellularReturn) {
+			case CellularReturn::F2:
+				return resolveFractal<Dom, H, Function::Cellular, Interpolation::Linear, D, CellularReturn::F2>(fractal);
+			case CellularReturn::F2MinusF1:
+				return resolveFractal<Dom, H, Function::Cellular, Interpolation::Linear, D, CellularReturn::F2MinusF1>(fractal);
+			default:
+				return resolveFractal<Dom, H, Function::Cellular, Interpolation::Linear, D, CellularReturn::F1>(fractal);
+		}
+	}
+
+	template<Domain Dom, class H>
+	static SampleFnOf<Dom> resolveCellular(const Descriptor &descriptor) {
+		switch (descriptor.cellularDistance) {
+			case CellularDistance::EuclideanSquared:
+				return resolveCellularReturn<Dom, H, CellularDistance::EuclideanSquared>(descriptor.cellularReturn, descriptor.fractal);
+			case CellularDistance::Manhattan:
+				return resolveCellularReturn<Dom, H, CellularDistance::Manhattan>(descriptor.cellularReturn, descriptor.fractal);
+			default:
+				return resolveCellularReturn<Dom, H, CellularDistance::Euclidean>(descriptor.cellularReturn, descriptor.fractal);
+		}
+	}
+
+	template<class H, Function F, Interpolation I>
+	static DerivativeFn resolveDerivativeFractal(Fractal fractal) {
+		switch (fractal) {
+			case Fractal::None:
+				return &sampleDerivative<H, F, I, Fractal::None>;
+			case Fractal::FBM:
+				return &sampleDerivative<H, F, I, Fractal::FBM>;
+			default:
+				return nullptr;
+		}
+	}
+
+	// Analytic derivative kernel for desc, nullptr when there is none
+	template<class H>
+	static DerivativeFn resolveDerivative(const Descriptor &descriptor) {
+		switch (descriptor.function) {
+			case Function::Value:
+				switch (descriptor.interpolation) {
+					case Interpolation::Smoothstep:
+						return resolveDerivativeFractal<H, Function::Value, Interpolation::Smoothstep>(descriptor.fractal);
+					case Interpolation::Smootherstep:
+						return resolveDerivativeFractal<H, Function::Value, Interpolation::Smootherstep>(descriptor.fractal);
+					default:
+						return resolveDerivativeFractal<H, Function::Value, Interpolation::Linear>(descriptor.fractal);
+				}
+			case Function::ValueCubic:
+				return resolveDerivativeFractal<H, Function::ValueCubic, Interpolation::Linear>(descriptor.fractal);
+			default:
+				return nullptr;
+		}
+	}
+
+	// Sample kernel for desc, SampleFn in 2D and SampleFn3 in 3D
+	template<Domain Dom, class H>
+	static SampleFnOf<Dom> resolveSample(const Descriptor &descriptor) {
+		switch (descriptor.function) {
+			// Cubic, gradient and cellular noise ignore the interpolation setting
+			case Function::ValueCubic:
+				return resolveFractal<Dom, H, Function::ValueCubic, Interpolation::Linear>(descriptor.fractal);
+			case Function::Perlin:
+				return resolveFractal<Dom, H, Function::Perlin, Interpolation::Linear>(descriptor.fractal);
+			case Function::Simplex:
+				return resolveFractal<Dom, H, Function::Simplex, Interpolation::Linear>(descriptor.fractal);
+			case Function::Cellular:
+				return resolveCellular<Dom, H>(descriptor);
+			default:
+				return resolveInterpolation<Dom, H, Function::Value>(descriptor.interpolation, descriptor.fractal);
+		}
+	}
 };
 
 //
@@ -0,0 +1,72 @@
+#include "noise_simd.h"
+
+// Compiled with -mavx2 (or /arch:AVX2), see src/CMakeLists.txt. Only selected when the CPU reports AVX2.
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+#include "noise_kernels.h"
+
+namespace {
+
+	struct Avx2 {
+		static constexpr int Width = 8;
+		using F = __m256;
+		using I = __m256i;
+
+		static F splat(float v) { return _mm256_set1_ps(v); }
+		static I splatI(int32_t v) { return _mm256_set1_epi32(v); }
+		static F load(const float *p) { return _mm256_loadu_ps(p); }
+		static void store(float *p, F v) { _mm256_storeu_ps(p, v); }
+
+		static F add(F a, F b) { return _mm256_add_ps(a, b); }
+		static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+		static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+		static F div(F a, F b) { return _mm256_div_ps(a, b); }
+		static F min(F a, F b) { return _mm256_min_ps(a, b); }
+		static F max(F a, F b) { return _mm256_max_ps(a, b); }
+		static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+		static F abs(F a) { return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))); }
+
+		static I add(I a, I b) { return _mm256_add_epi32(a, b); }
+		static I mul(I a, I b) { return _mm256_mullo_epi32(a, b); }
+		static I bitAnd(I a, I b) { return _mm256_and_si256(a, b); }
+		static I bitXor(I a, I b) { return _mm256_xor_si256(a, b); }
+
+		static F bitXor(F a, F b) { return _mm256_xor_ps(a, b); }
+		template<int N> static I shiftLeft(I a) { return _mm256_slli_epi32(a, N); }
+		template<int N> static I shiftRight(I a) { return _mm256_srai_epi32(a, N); }
+		template<int N> static I shiftRightLogical(I a) { return _mm256_srli_epi32(a, N); }
+
+		static I equal(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+		static I greaterThan(F a, F b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+		static F select(I mask, F a, F b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+
+		static F castToFloat(I a) { return _mm256_castsi256_ps(a); }
+		static F toFloat(I a) { return _mm256_cvtepi32_ps(a); }
+
+		static I gather(const int32_t *table, I index) { return _mm256_i32gather_epi32(table, index, 4); }
+		static F gatherF(const float *table, I index) { return _mm256_i32gather_ps(table, index, 4); }
+		static F floor(F a) { return _mm256_floor_ps(a); }
+		static I floorToInt(F a) { return _mm256_cvttps_epi32(_mm256_floor_ps(a)); }
+	};
+}
+
+NoiseSimd::PointsFn NoiseSimd::avx2Points(const Params &params) {
+	return resolve<Avx2>(params);
+}
+
+NoiseSimd::Points3Fn NoiseSimd::avx2Points3(const Params &params) {
+	return resolve<Avx2, 3>(params);
+}
+
+#else
+
+NoiseSimd::PointsFn NoiseSimd::avx2Points(const Params &) {
+	return nullptr;
+}
+
+NoiseSimd::Points3Fn NoiseSimd::avx2Points3(const Params &) {
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,281 @@
+#include "noise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*
+ * Per sample cost of every Function x Interpolation x Fractal combination over several octave counts, the baseline
+ * noise optimizations are judged against.
+ *
+ *   scalar  Noise::eval at every sample of the grid
+ *   batch   Noise::fillGrid over the same grid, the lattice walking or SIMD path of the running CPU
+ *
+ * Each measurement runs the warmup passes untimed, then times every repetition on its own and reports the median
+ * and the fastest repetition. The grid has one sample per world unit at a frequency below one, so the value kernels
+ * take the lattice walking path.
+ *
+ * --check compares fillGrid against eval instead, with octave culling on and bordered grids whose last sample lands
+ * on a culled octave's subgrid, and exits with 1 when a sample is off by more than the octave tolerance. Build with
+ * NOISE_SANITIZE to have out of bounds taps caught as well.
+ *
+ * Usage: noise_bench [--repetitions N] [--warmup N] [--grid N] [--json FILE] [--check]
+ * --json - writes the JSON report to stdout instead of the table.
+ */
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	constexpr Noise::Function Functions[] = {Noise::Value, Noise::ValueCubic, Noise::Simplex, Noise::Perlin, Noise::Cellular};
+	constexpr const char *FunctionNames[] = {"Value", "ValueCubic", "Simplex", "Perlin", "Cellular"};
+	constexpr Noise::Interpolation Interpolations[] = {Noise::Linear, Noise::Cosine, Noise::Smoothstep, Noise::Smootherstep};
+	constexpr const char *InterpolationNames[] = {"Linear", "Cosine", "Smoothstep", "Smootherstep"};
+	constexpr Noise::Fractal Fractals[] = {Noise::Fractal::None, Noise::Fractal::FBM, Noise::Fractal::Ridged, Noise::Fractal::Turbulence, Noise::Fractal::DomainWarp};
+	constexpr const char *FractalNames[] = {"None", "FBM", "Ridged", "Turbulence", "DomainWarp"};
+	constexpr int OctaveCounts[] = {1, 3, 6};
+
+	constexpr float Frequency = 0.05f;
+
+	// Chunk grids with their border, the sizes (width - 1) of which are multiples of every octave stride
+	constexpr int CheckGrids[] = {2, 9, 33, 34, 35, 66, 67};
+	constexpr float CheckOctaveTolerance = 0.01f;
+	constexpr int CheckOctaveCounts[] = {0, 6}; // No octaves at all has no strides to cull
+
+	volatile float sink; // Keeps the timed samples from being optimized away
+
+	struct Settings {
+		int repetitions = 5;
+		int warmup = 1;
+		int grid = 128; // Samples per side
+		std::string json; // Empty prints the table only
+		bool check = false;
+	};
+
+	struct Result {
+		const char *function;
+		const char *interpolation;
+		const char *fractal;
+		int octaves;
+		const char *path;
+		double medianNs; // Per sample
+		double fastestNs;
+	};
+
+	// One timed pass over the grid, in ns per sample
+	double scalarPass(const Noise &noise, int grid) {
+		float folded = 0.0f;
+		auto begin = Clock::now();
+		for (int row = 0; row < grid; row++) {
+			for (int col = 0; col < grid; col++) {
+				folded += noise.eval(glm::vec2(float(col), float(row)));
+			}
+		}
+		double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+		sink = folded;
+		return ns / (double(grid) * grid);
+	}
+
+	double batchPass(const Noise &noise, std::vector<float> &out, int grid) {
+		auto begin = Clock::now();
+		noise.fillGrid(out, {0.0f, 0.0f}, {1.0f, 1.0f}, grid, grid);
+		double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+		sink = out[out.size() / 2];
+		return ns / (double(grid) * grid);
+	}
+
+	template<class Pass>
+	Result measure(const Settings &settings, Pass pass) {
+		for (int i = 0; i < settings.warmup; i++) {
+			pass();
+		}
+
+		std::vector<double> times;
+		times.reserve(settings.repetitions);
+		for (int i = 0; i < settings.repetitions; i++) {
+			times.push_back(pass());
+		}
+		std::sort(times.begin(), times.end());
+
+		Result result{};
+		result.medianNs = times[times.size() / 2];
+		result.fastestNs = times.front();
+		return result;
+	}
+
+	// Largest difference between fillGrid and eval over a size x size grid starting one sample before the origin
+	float gridDifference(const Noise &noise, int size) {
+		std::vector<float> out(static_cast<size_t>(size) * size);
+		noise.fillGrid(out, {-1.0f, -1.0f}, {1.0f, 1.0f}, size, size);
+
+		float difference = 0.0f;
+		for (int row = 0; row < size; row++) {
+			for (int col = 0; col < size; col++) {
+				float expected = noise.eval(glm::vec2(float(col - 1), float(row - 1)));
+				float actual = out[row * size + col];
+				if (std::isnan(actual)) {
+					return std::numeric_limits<float>::infinity();
+				}
+				difference = std::max(difference, std::abs(actual - expected));
+			}
+		}
+		return difference;
+	}
+
+	// fillGrid against eval with octave culling, true when every grid is within the tolerance
+	bool check() {
+		bool passed = true;
+		std::printf("Noise check, octave tolerance %g\n\n", CheckOctaveTolerance);
+		std::printf("%-11s %-11s %7s %6s %12s %12s\n", "function", "fractal", "octaves", "grid", "difference", "tolerance");
+
+		for (size_t f = 0; f < std::size(Functions); f++) {
+			for (size_t r = 0; r < std::size(Fractals); r++) {
+				for (int octaves : CheckOctaveCounts) {
+					Noise::Descriptor desc;
+					desc.function = Functions[f];
+					desc.fractal = Fractals[r];
+					desc.octaves = octaves;
+					desc.frequency = Frequency;
+					desc.octaveTolerance = CheckOctaveTolerance;
+					Noise noise(desc);
+
+					float tolerance = (CheckOctaveTolerance + Noise::BatchTolerance) * desc.amplitude;
+					for (int size : CheckGrids) {
+						float difference = gridDifference(noise, size);
+						bool ok = difference <= tolerance;
+						passed = passed && ok;
+						std::printf("%-11s %-11s %7d %6d %12.6f %12.6f%s\n", FunctionNames[f], FractalNames[r], octaves, size, difference, tolerance, ok ? "" : "  FAILED");
+					}
+				}
+			}
+		}
+		return passed;
+	}
+
+	void writeJson(std::FILE *file, const Settings &settings, const std::vector<Result> &results) {
+		std::fprintf(file, "{\n");
+		std::fprintf(file, "  \"simd\": \"%s\",\n", NoiseSimd::levelName(NoiseSimd::detectLevel()));
+		std::fprintf(file, "  \"grid\": %d,\n", settings.grid);
+		std::fprintf(file, "  \"repetitions\": %d,\n", settings.repetitions);
+		std::fprintf(file, "  \"warmup\": %d,\n", settings.warmup);
+		std::fprintf(file, "  \"frequency\": %g,\n", Frequency);
+		std::fprintf(file, "  \"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++) {
+			const Result &r = results[i];
+			std::fprintf(file, "    {\"function\": \"%s\", \"interpolation\": \"%s\", \"fractal\": \"%s\", \"octaves\": %d, \"path\": \"%s\", "
+					"\"ns_per_sample\": %.3f, \"fastest_ns_per_sample\": %.3f, \"samples_per_sec\": %.0f}%s\n",
+					r.function, r.interpolation, r.fractal, r.octaves, r.path, r.medianNs, r.fastestNs, 1e9 / r.medianNs,
+					i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(file, "  ]\n}\n");
+	}
+
+	bool parse(int argc, char **argv, Settings &settings) {
+		for (int i = 1; i < argc; i++) {
+			bool hasValue = i + 1 < argc;
+			if (std::strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+				settings.repetitions = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+				settings.warmup = std::max(0, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--grid") == 0 && hasValue) {
+				settings.grid = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+				settings.json = argv[++i];
+			}
+			else if (std::strcmp(argv[i], "--check") == 0) {
+				settings.check = true;
+			}
+			else {
+				std::fprintf(stderr, "Usage: %s [--repetitions N] [--warmup N] [--grid N] [--json FILE] [--check]\n", argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char **argv) {
+	Settings settings;
+	if (!parse(argc, argv, settings)) {
+		return 1;
+	}
+	if (settings.check) {
+		return check() ? 0 : 1;
+	}
+	bool table = settings.json != "-";
+
+	if (table) {
+		std::printf("Noise bench, SIMD level %s, %dx%d grid, %d repetitions after %d warmup\n\n",
+				NoiseSimd::levelName(NoiseSimd::detectLevel()), settings.grid, settings.grid, settings.repetitions, settings.warmup);
+		std::printf("%-11s %-13s %-11s %7s %-7s %10s %10s %14s\n",
+				"function", "interpolation", "fractal", "octaves", "path", "ns/sample", "fastest", "samples/sec");
+	}
+
+	std::vector<Result> results;
+	std::vector<float> out(static_cast<size_t>(settings.grid) * settings.grid);
+
+	for (size_t f = 0; f < std::size(Functions); f++) {
+		for (size_t i = 0; i < std::size(Interpolations); i++) {
+			for (size_t r = 0; r < std::size(Fractals); r++) {
+				for (int octaves : OctaveCounts) {
+
+					// Octaves only change the fractals
+					if (Fractals[r] == Noise::Fractal::None && octaves != OctaveCounts[0]) {
+						continue;
+					}
+
+					Noise::Descriptor desc;
+					desc.function = Functions[f];
+					desc.interpolation = Interpolations[i];
+					desc.fractal = Fractals[r];
+					desc.octaves = octaves;
+					desc.frequency = Frequency;
+					Noise noise(desc);
+
+					Result scalar = measure(settings, [&] { return scalarPass(noise, settings.grid); });
+					scalar.path = "scalar";
+					Result batch = measure(settings, [&] { return batchPass(noise, out, settings.grid); });
+					batch.path = "batch";
+
+					for (Result result : {scalar, batch}) {
+						result.function = FunctionNames[f];
+						result.interpolation = InterpolationNames[i];
+						result.fractal = FractalNames[r];
+						result.octaves = octaves;
+						results.push_back(result);
+
+						if (table) {
+							std::printf("%-11s %-13s %-11s %7d %-7s %10.2f %10.2f %14.0f\n",
+									result.function, result.interpolation, result.fractal, result.octaves, result.path,
+									result.medianNs, result.fastestNs, 1e9 / result.medianNs);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (settings.json == "-") {
+		writeJson(stdout, settings, results);
+	}
+	else if (!settings.json.empty()) {
+		std::FILE *file = std::fopen(settings.json.c_str(), "w");
+		if (!file) {
+			std::fprintf(stderr, "Could not open %s\n", settings.json.c_str());
+			return 1;
+		}
+		writeJson(file, settings, results);
+		std::fclose(file);
+	}
+	return 0;
+}
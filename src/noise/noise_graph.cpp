@@ -0,0 +1,351 @@
+#include "noise_graph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+	float selectValue(float a, float b, float control, float threshold, float falloff) {
+		if (falloff <= 0.0f) {
+			return control < threshold ? a : b;
+		}
+		float t = glm::clamp((control - (threshold - falloff)) / (2.0f * falloff), 0.0f, 1.0f);
+		t = t * t * (3.0f - 2.0f * t);
+		return Noise::lerp(a, b, t);
+	}
+
+	float blendValue(float a, float b, float mask) {
+		return Noise::lerp(a, b, glm::clamp(mask, 0.0f, 1.0f));
+	}
+}
+
+
+// Nodes
+// ----------------------------
+
+NoiseGraph::NodeId NoiseGraph::addNode(Node node) {
+	nodes.push_back(node);
+	output = static_cast<NodeId>(nodes.size()) - 1;
+	compiled = false;
+	return output;
+}
+
+void NoiseGraph::checkInput(NodeId node) const {
+	if (node < 0 || node >= static_cast<NodeId>(nodes.size())) {
+		throw std::runtime_error("NoiseGraph: unknown node " + std::to_string(node));
+	}
+}
+
+NoiseGraph::NodeId NoiseGraph::source(const Noise::Descriptor &descriptor) {
+	sources.emplace_back(descriptor);
+	return addNode({.op = Op::Source, .data = static_cast<int>(sources.size()) - 1});
+}
+
+NoiseGraph::NodeId NoiseGraph::constant(float value) {
+	return addNode({.op = Op::Constant, .x = value});
+}
+
+NoiseGraph::NodeId NoiseGraph::add(NodeId a, NodeId b) {
+	checkInput(a);
+	checkInput(b);
+	return addNode({.op = Op::Add, .inputs = {a, b, -1}});
+}
+
+NoiseGraph::NodeId NoiseGraph::multiply(NodeId a, NodeId b) {
+	checkInput(a);
+	checkInput(b);
+	return addNode({.op = Op::Multiply, .inputs = {a, b, -1}});
+}
+
+NoiseGraph::NodeId NoiseGraph::select(NodeId a, NodeId b, NodeId control, float threshold, float falloff) {
+	checkInput(a);
+	checkInput(b);
+	checkInput(control);
+	return addNode({.op = Op::Select, .inputs = {a, b, control}, .x = threshold, .y = falloff});
+}
+
+NoiseGraph::NodeId NoiseGraph::clamp(NodeId a, float lower, float upper) {
+	checkInput(a);
+	return addNode({.op = Op::Clamp, .inputs = {a, -1, -1}, .x = lower, .y = upper});
+}
+
+NoiseGraph::NodeId NoiseGraph::curve(NodeId a, std::vector<glm::vec2> points) {
+	checkInput(a);
+	if (points.size() < 2) {
+		throw std::runtime_error("NoiseGraph: a curve needs at least two control points");
+	}
+
+	std::vector<float> table;
+	table.reserve(points.size() * 2);
+	for (glm::vec2 point : points) {
+		table.push_back(point.x);
+		table.push_back(point.y);
+	}
+	tables.push_back(std::move(table));
+	return addNode({.op = Op::Curve, .inputs = {a, -1, -1}, .data = static_cast<int>(tables.size()) - 1});
+}
+
+NoiseGraph::NodeId NoiseGraph::terrace(NodeId a, std::vector<float> levels, bool invert) {
+	checkInput(a);
+	if (levels.size() < 2) {
+		throw std::runtime_error("NoiseGraph: a terrace needs at least two levels");
+	}
+
+	tables.push_back(std::move(levels));
+	return addNode({.op = Op::Terrace, .inputs = {a, -1, -1}, .x = invert ? 1.0f : 0.0f, .data = static_cast<int>(tables.size()) - 1});
+}
+
+NoiseGraph::NodeId NoiseGraph::blend(NodeId a, NodeId b, NodeId mask) {
+	checkInput(a);
+	checkInput(b);
+	checkInput(mask);
+	return addNode({.op = Op::Blend, .inputs = {a, b, mask}});
+}
+
+void NoiseGraph::setOutput(NodeId node) {
+	checkInput(node);
+	output = node;
+	compiled = false;
+}
+
+
+// Compilation
+// ----------------------------
+
+bool NoiseGraph::sameNode(const Node &a, const Node &b) const {
+	if (a.op != b.op || a.x != b.x || a.y != b.y || !std::equal(std::begin(a.inputs), std::end(a.inputs), std::begin(b.inputs))) {
+		return false;
+	}
+
+	switch (a.op) {
+		case Op::Source:
+			return sources[a.data].desc == sources[b.data].desc;
+		case Op::Curve:
+		case Op::Terrace:
+			return tables[a.data] == tables[b.data];
+		default:
+			return true;
+	}
+}
+
+void NoiseGraph::compile() {
+	if (output < 0) {
+		throw std::runtime_error("NoiseGraph: cannot compile an empty graph");
+	}
+
+	// Nodes only reference earlier nodes, so one backwards pass marks everything the output depends on
+	std::vector<bool> reachable(output + 1, false);
+	reachable[output] = true;
+	for (NodeId id = output; id >= 0; id--) {
+		if (!reachable[id]) continue;
+		for (NodeId input : nodes[id].inputs) {
+			if (input >= 0) reachable[input] = true;
+		}
+	}
+
+	// Creation order is already topological. Inputs are renamed to the value that computes them, so a node
+	// matching an earlier one (same op, inputs and parameters) reuses its value instead of being emitted again.
+	std::vector<int> valueOf(output + 1, -1);
+	std::vector<Node> values;
+	for (NodeId id = 0; id <= output; id++) {
+		if (!reachable[id]) continue;
+
+		Node node = nodes[id];
+		for (NodeId &input : node.inputs) {
+			if (input >= 0) input = valueOf[input];
+		}
+		if ((node.op == Op::Add || node.op == Op::Multiply) && node.inputs[0] > node.inputs[1]) {
+			std::swap(node.inputs[0], node.inputs[1]);
+		}
+
+		auto same = std::find_if(values.begin(), values.end(), [&](const Node &value) { return sameNode(value, node); });
+		if (same != values.end()) {
+			valueOf[id] = static_cast<int>(same - values.begin());
+			continue;
+		}
+		valueOf[id] = static_cast<int>(values.size());
+		values.push_back(node);
+	}
+
+	// Last instruction reading each value, the result is never released
+	int result = valueOf[output];
+	std::vector<int> lastUse(values.size(), -1);
+	for (int i = 0; i < static_cast<int>(values.size()); i++) {
+		for (int input : values[i].inputs) {
+			if (input >= 0) lastUse[input] = i;
+		}
+	}
+	lastUse[result] = static_cast<int>(values.size());
+
+	// Assign scratch registers. Every op works elementwise, so an instruction may write over an input it reads
+	// for the last time.
+	program.clear();
+	registers = 0;
+	std::vector<int> freeRegisters;
+	std::vector<int> registerOf(values.size(), -1);
+	for (int i = 0; i < static_cast<int>(values.size()); i++) {
+		const Node &value = values[i];
+		for (int k = 0; k < 3; k++) {
+			int input = value.inputs[k];
+			bool repeated = std::find(value.inputs, value.inputs + k, input) != value.inputs + k;
+			if (input >= 0 && !repeated && lastUse[input] == i) {
+				freeRegisters.push_back(registerOf[input]);
+			}
+		}
+
+		if (freeRegisters.empty()) {
+			registerOf[i] = registers++;
+		}
+		else {
+			registerOf[i] = freeRegisters.back();
+			freeRegisters.pop_back();
+		}
+
+		Instruction instruction{.op = value.op, .out = registerOf[i], .x = value.x, .y = value.y, .data = value.data};
+		for (int k = 0; k < 3; k++) {
+			instruction.inputs[k] = value.inputs[k] >= 0 ? registerOf[value.inputs[k]] : -1;
+		}
+		program.push_back(instruction);
+	}
+
+	outputRegister = registerOf[result];
+	compiled = true;
+}
+
+
+// Evaluation
+// ----------------------------
+
+float NoiseGraph::evalCurve(const std::vector<float> &points, float v) {
+	size_t count = points.size() / 2;
+	if (v <= points[0]) {
+		return points[1];
+	}
+	for (size_t i = 1; i < count; i++) {
+		float x1 = points[i * 2];
+		if (v < x1) {
+			float x0 = points[i * 2 - 2];
+			float t = x1 > x0 ? (v - x0) / (x1 - x0) : 1.0f;
+			return Noise::lerp(points[i * 2 - 1], points[i * 2 + 1], t);
+		}
+	}
+	return points[count * 2 - 1];
+}
+
+float NoiseGraph::evalTerrace(const std::vector<float> &levels, bool invert, float v) {
+	// Levels around v, holding the end levels outside of them
+	auto upper = std::upper_bound(levels.begin(), levels.end(), v);
+	if (upper == levels.begin()) {
+		return levels.front();
+	}
+	if (upper == levels.end()) {
+		return levels.back();
+	}
+
+	float low = *(upper - 1);
+	float high = *upper;
+	float t = (v - low) / (high - low);
+	if (invert) {
+		t = 1.0f - t;
+		std::swap(low, high);
+	}
+	return Noise::lerp(low, high, t * t);
+}
+
+void NoiseGraph::fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height) const {
+	if (!compiled) {
+		throw std::runtime_error("NoiseGraph: fillGrid called before compile");
+	}
+
+	size_t count = static_cast<size_t>(width) * height;
+	assert(out.size() >= count);
+
+	std::vector<std::vector<float>> scratch(registers, std::vector<float>(count));
+
+	for (const Instruction &instruction : program) {
+		float *o = scratch[instruction.out].data();
+		const float *a = instruction.inputs[0] >= 0 ? scratch[instruction.inputs[0]].data() : nullptr;
+		const float *b = instruction.inputs[1] >= 0 ? scratch[instruction.inputs[1]].data() : nullptr;
+		const float *c = instruction.inputs[2] >= 0 ? scratch[instruction.inputs[2]].data() : nullptr;
+
+		switch (instruction.op) {
+			case Op::Source:
+				sources[instruction.data].fillGrid(scratch[instruction.out], origin, step, width, height);
+				break;
+			case Op::Constant:
+				std::fill(o, o + count, instruction.x);
+				break;
+			case Op::Add:
+				for (size_t k = 0; k < count; k++) o[k] = a[k] + b[k];
+				break;
+			case Op::Multiply:
+				for (size_t k = 0; k < count; k++) o[k] = a[k] * b[k];
+				break;
+			case Op::Select:
+				for (size_t k = 0; k < count; k++) o[k] = selectValue(a[k], b[k], c[k], instruction.x, instruction.y);
+				break;
+			case Op::Clamp:
+				for (size_t k = 0; k < count; k++) o[k] = glm::clamp(a[k], instruction.x, instruction.y);
+				break;
+			case Op::Curve:
+				for (size_t k = 0; k < count; k++) o[k] = evalCurve(tables[instruction.data], a[k]);
+				break;
+			case Op::Terrace:
+				for (size_t k = 0; k < count; k++) o[k] = evalTerrace(tables[instruction.data], instruction.x != 0.0f, a[k]);
+				break;
+			case Op::Blend:
+				for (size_t k = 0; k < count; k++) o[k] = blendValue(a[k], b[k], c[k]);
+				break;
+		}
+	}
+
+	std::copy(scratch[outputRegister].begin(), scratch[outputRegister].end(), out.begin());
+}
+
+float NoiseGraph::eval(glm::vec2 p) const {
+	if (!compiled) {
+		throw std::runtime_error("NoiseGraph: eval called before compile");
+	}
+
+	std::vector<float> scratch(registers);
+	for (const Instruction &instruction : program) {
+		float a = instruction.inputs[0] >= 0 ? scratch[instruction.inputs[0]] : 0.0f;
+		float b = instruction.inputs[1] >= 0 ? scratch[instruction.inputs[1]] : 0.0f;
+		float c = instruction.inputs[2] >= 0 ? scratch[instruction.inputs[2]] : 0.0f;
+		float &o = scratch[instruction.out];
+
+		switch (instruction.op) {
+			case Op::Source:
+				o = sources[instruction.data].eval(p);
+				break;
+			case Op::Constant:
+				o = instruction.x;
+				break;
+			case Op::Add:
+				o = a + b;
+				break;
+			case Op::Multiply:
+				o = a * b;
+				break;
+			case Op::Select:
+				o = selectValue(a, b, c, instruction.x, instruction.y);
+				break;
+			case Op::Clamp:
+				o = glm::clamp(a, instruction.x, instruction.y);
+				break;
+			case Op::Curve:
+				o = evalCurve(tables[instruction.data], a);
+				break;
+			case Op::Terrace:
+				o = evalTerrace(tables[instruction.data], instruction.x != 0.0f, a);
+				break;
+			case Op::Blend:
+				o = blendValue(a, b, c);
+				break;
+		}
+	}
+
+	return scratch[outputRegister];
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "noise.h"
+
+/*
+ * Composes several Noise sources with libnoise style modules.
+ *
+ * Nodes are built bottom up, every node only referencing nodes created before it, and the node returned last
+ * (or the one passed to setOutput) is the result. compile() flattens the nodes reachable from the output into a
+ * topologically ordered program, merging identical sub-expressions and reusing scratch buffers once their values
+ * are no longer needed. fillGrid then runs that program one instruction at a time over the whole grid.
+ * Adding nodes after compile() requires compiling again.
+ *
+ * Example, mountains masked into plains:
+ *   NoiseGraph graph;
+ *   auto plains = graph.multiply(graph.source(plainsDesc), graph.constant(0.2f));
+ *   auto mountains = graph.source(mountainDesc);
+ *   graph.blend(plains, mountains, graph.source(maskDesc));
+ *   graph.compile();
+ */
+class NoiseGraph {
+public:
+
+	using NodeId = int;
+
+	enum Op {
+		Source,   // Noise evaluation
+		Constant, // x
+		Add,      // a + b
+		Multiply, // a * b
+		Select,   // a where control < x, b above it, smoothly blended within y of x
+		Clamp,    // a clamped to [x, y]
+		Curve,    // a remapped through the piecewise linear curve of control points
+		Terrace,  // a flattened into terraces between the levels, inverted when x != 0
+		Blend     // lerp(a, b, clamp(mask, 0, 1))
+	};
+
+	NoiseGraph() = default;
+
+	// Graph of a single source, equivalent to the descriptor on its own
+	explicit NoiseGraph(const Noise::Descriptor &descriptor) {
+		source(descriptor);
+		compile();
+	}
+
+
+	// Nodes
+	// ----------------------------
+
+	NodeId source(const Noise::Descriptor &descriptor);
+	NodeId constant(float value);
+	NodeId add(NodeId a, NodeId b);
+	NodeId multiply(NodeId a, NodeId b);
+
+	/**
+	 * Picks a below the threshold of control and b above it.
+	 * @param falloff Half width of the smooth transition around the threshold, 0 for a hard edge
+	 */
+	NodeId select(NodeId a, NodeId b, NodeId control, float threshold, float falloff = 0.0f);
+
+	NodeId clamp(NodeId a, float lower, float upper);
+
+	/**
+	 * Remaps a through a piecewise linear curve, holding the end values outside of it.
+	 * @param points Control points (input, output), at least two, sorted by input
+	 */
+	NodeId curve(NodeId a, std::vector<glm::vec2> points);
+
+	/**
+	 * Terraces a between the given levels, flat just above each level and steep just below the next one.
+	 * @param levels At least two levels, sorted ascending
+	 * @param invert Steep just above each level and flat just below the next one instead
+	 */
+	NodeId terrace(NodeId a, std::vector<float> levels, bool invert = false);
+
+	// Blends from a to b by mask, which is clamped to [0, 1]
+	NodeId blend(NodeId a, NodeId b, NodeId mask);
+
+	// Result of the graph, defaults to the last node created
+	void setOutput(NodeId node);
+
+
+	// Evaluation
+	// ----------------------------
+
+	/**
+	 * Evaluates the graph over a regular grid, with the same layout as Noise::fillGrid.
+	 * Runs every instruction over the whole grid before the next one, each source through Noise::fillGrid.
+	 * Throws std::runtime_error when the graph is not compiled.
+	 */
+	void fillGrid(std::span<float> out, glm::vec2 origin, glm::vec2 step, int width, int height) const;
+
+	// Evaluates the graph at a single point, running the compiled program per sample
+	float eval(glm::vec2 p) const;
+
+	// Flattens the graph into the evaluation program. Throws std::runtime_error for an empty graph.
+	// Also called by the single source constructor.
+	void compile();
+
+	bool isCompiled() const {
+		return compiled;
+	}
+
+	// Instructions in the compiled program, after shared sub-expressions are merged
+	size_t instructionCount() const {
+		return program.size();
+	}
+
+	// Scratch buffers the compiled program needs
+	int registerCount() const {
+		return registers;
+	}
+
+
+private:
+
+	struct Node {
+		Op op = Op::Constant;
+		NodeId inputs[3] = {-1, -1, -1};
+		float x = 0.0f;
+		float y = 0.0f;
+		int data = -1; // Index into sources or tables
+	};
+
+	// One node of the program, reading and writing scratch registers
+	struct Instruction {
+		Op op = Op::Constant;
+		int out = -1;
+		int inputs[3] = {-1, -1, -1};
+		float x = 0.0f;
+		float y = 0.0f;
+		int data = -1;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Noise> sources;
+	std::vector<std::vector<float>> tables; // Curve points as flattened (input, output) pairs, terrace levels
+	NodeId output = -1;
+
+	std::vector<Instruction> program;
+	int registers = 0;
+	int outputRegister = -1;
+	bool compiled = false;
+
+	NodeId addNode(Node node);
+	void checkInput(NodeId node) const;
+	bool sameNode(const Node &a, const Node &b) const;
+
+	static float evalCurve(const std::vector<float> &points, float v);
+	static float evalTerrace(const std::vector<float> &levels, bool invert, float v);
+};
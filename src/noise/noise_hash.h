@@ -0,0 +1,294 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include "noise_simd.h"
+
+/*
+ * Lattice hash policies.
+ *
+ * Every noise kernel, scalar, lattice walking and SIMD, takes its hash as a template parameter. A policy mixes the
+ * seed with the primed lattice coordinates (x * PrimeX, y * PrimeY) into 32 bits, hash3 with z * PrimeZ as well. It is written once against the
+ * integer lane operations of the traits in noise_kernels.h, so every path hashes bit for bit the same.
+ * Noise::Descriptor::hash picks the instantiation when the kernels are resolved, see dispatch().
+ *
+ * A policy hashes under a Key: the seed lanes, and the seeded tables of the table driven Permutation policy.
+ *
+ * Lanes need splatI, add, mul, bitAnd, bitXor, shiftLeft<N> and shiftRightLogical<N> on 32-bit integers, wrapping,
+ * and gather(const int32_t*, I), gatherF(const float*, I) for the table lookups.
+ * noise_hash_suite measures the speed and statistical quality of each policy.
+ */
+namespace NoiseHash {
+
+	struct PermutationTable;
+
+	// One scalar lane, used by Noise::eval and the lattice walkers
+	struct Lane {
+		using F = float;
+		using I = uint32_t;
+
+		static I splatI(int32_t v) { return static_cast<uint32_t>(v); }
+		static I add(I a, I b) { return a + b; }
+		static I mul(I a, I b) { return a * b; }
+		static I bitAnd(I a, I b) { return a & b; }
+		static I bitXor(I a, I b) { return a ^ b; }
+		template<int N> static I shiftLeft(I a) { return a << N; }
+		template<int N> static I shiftRightLogical(I a) { return a >> N; }
+		static I gather(const int32_t *table, I index) { return static_cast<uint32_t>(table[index]); }
+		static F gatherF(const float *table, I index) { return table[index]; }
+	};
+
+	// What the lattice is hashed under
+	template<class S>
+	struct Key {
+		typename S::I seed;
+		const PermutationTable *table = nullptr; // Permutation policy only
+	};
+
+	using ScalarKey = Key<Lane>;
+
+	// The coordinates and seed offset by the primes and folded together, the input of every finalizer below
+	template<class S>
+	typename S::I combine(typename S::I seed, typename S::I xPrimed, typename S::I yPrimed) {
+		using namespace NoiseSimd;
+		return S::bitXor(S::bitXor(S::add(seed, S::splatI(PrimeZ)), S::add(xPrimed, S::splatI(PrimeY))), S::add(yPrimed, S::splatI(PrimeX)));
+	}
+
+	// combine with the primed z coordinate folded in as well
+	template<class S>
+	typename S::I combine(typename S::I seed, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+		return S::bitXor(combine<S>(seed, xPrimed, yPrimed), S::add(zPrimed, S::splatI(NoiseSimd::PrimeW)));
+	}
+
+	// The original hash, one multiply by PrimeW. Cheap, but only the high bits are well mixed.
+	struct PrimeXor {
+		template<class S>
+		static typename S::I mix(typename S::I h) {
+			return S::mul(h, S::splatI(NoiseSimd::PrimeW));
+		}
+
+		template<class S>
+		static typename S::I hash(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			return mix<S>(combine<S>(key.seed, xPrimed, yPrimed));
+		}
+
+		template<class S>
+		static typename S::I hash3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			return mix<S>(combine<S>(key.seed, xPrimed, yPrimed, zPrimed));
+		}
+	};
+
+	// Nested PCG output permutations, pcg(y + pcg(x + seed)). The shift is fixed, vector lanes can't shift by a
+	// per lane amount on SSE2.
+	struct Pcg {
+		template<class S>
+		static typename S::I permute(typename S::I v) {
+			auto state = S::add(S::mul(v, S::splatI(747796405)), S::splatI(static_cast<int32_t>(2891336453u)));
+			auto word = S::mul(S::bitXor(S::template shiftRightLogical<13>(state), state), S::splatI(277803737));
+			return S::bitXor(S::template shiftRightLogical<22>(word), word);
+		}
+
+		template<class S>
+		static typename S::I hash(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			return permute<S>(S::add(yPrimed, permute<S>(S::add(xPrimed, key.seed))));
+		}
+
+		template<class S>
+		static typename S::I hash3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			return permute<S>(S::add(zPrimed, hash<S>(key, xPrimed, yPrimed)));
+		}
+	};
+
+	// The 32-bit xxHash avalanche (the murmur3 finalizer with the xxHash primes) over the combined input
+	struct XxHash {
+		template<class S>
+		static typename S::I mix(typename S::I h) {
+			h = S::bitXor(h, S::template shiftRightLogical<15>(h));
+			h = S::mul(h, S::splatI(static_cast<int32_t>(0x85ebca77u)));
+			h = S::bitXor(h, S::template shiftRightLogical<13>(h));
+			h = S::mul(h, S::splatI(static_cast<int32_t>(0xc2b2ae3du)));
+			return S::bitXor(h, S::template shiftRightLogical<16>(h));
+		}
+
+		template<class S>
+		static typename S::I hash(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			return mix<S>(combine<S>(key.seed, xPrimed, yPrimed));
+		}
+
+		template<class S>
+		static typename S::I hash3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			return mix<S>(combine<S>(key.seed, xPrimed, yPrimed, zPrimed));
+		}
+	};
+
+	// Thomas Wang's hash32shift with the multiply spelled as shifts, no 32-bit multiplies for SSE2 to emulate
+	struct ShiftAdd {
+		template<class S>
+		static typename S::I mix(typename S::I h) {
+			h = S::add(S::bitXor(h, S::splatI(-1)), S::template shiftLeft<15>(h));
+			h = S::bitXor(h, S::template shiftRightLogical<12>(h));
+			h = S::add(h, S::template shiftLeft<2>(h));
+			h = S::bitXor(h, S::template shiftRightLogical<4>(h));
+			h = S::add(S::add(h, S::template shiftLeft<3>(h)), S::template shiftLeft<11>(h));
+			return S::bitXor(h, S::template shiftRightLogical<16>(h));
+		}
+
+		template<class S>
+		static typename S::I hash(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			return mix<S>(combine<S>(key.seed, xPrimed, yPrimed));
+		}
+
+		template<class S>
+		static typename S::I hash3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			return mix<S>(combine<S>(key.seed, xPrimed, yPrimed, zPrimed));
+		}
+	};
+
+	/**
+	 * Seeded permutation and pre-scaled value tables of the Permutation policy, 4KB so they stay in L1.
+	 * Only the low bits of the primed coordinates index them, PrimeX, PrimeY and PrimeZ are odd so those are a permutation
+	 * of the low bits of the lattice coordinates: the noise repeats every Size lattice cells.
+	 */
+	struct PermutationTable {
+		static constexpr int Size = 256;
+		static constexpr int Mask = Size - 1;
+
+		int seed;
+		std::array<int32_t, Size * 2> perm; // Doubled so perm[perm[x] + y] needs no second mask
+		std::array<int32_t, Size> hashes; // For the functions picking gradients and feature points
+		std::array<float, Size> values; // hashes mapped to [0, 1] like hashFloat, for value noise
+
+		explicit PermutationTable(int seed) : seed(seed) {
+			// Fisher-Yates shuffle driven by xxHash over the seed
+			Key<Lane> key{static_cast<uint32_t>(seed)};
+			std::array<int32_t, Size> order;
+			std::iota(order.begin(), order.end(), 0);
+			for (int i = Size - 1; i > 0; i--) {
+				uint32_t r = XxHash::hash<Lane>(key, static_cast<uint32_t>(i), static_cast<uint32_t>(NoiseSimd::PrimeW));
+				std::swap(order[i], order[r % static_cast<uint32_t>(i + 1)]);
+			}
+
+			// Bits 23 to 30 hold the entry index and the rest is random. The permutation visits every entry once per
+			// period, so the values are stratified over [0, 1] and the gradients from bits 28 to 30 are evenly picked.
+			for (int i = 0; i < Size; i++) {
+				perm[i] = perm[i + Size] = order[i];
+				uint32_t random = XxHash::hash<Lane>(key, static_cast<uint32_t>(i), 0u);
+				hashes[i] = static_cast<int32_t>((random & 0x807fffffu) | (static_cast<uint32_t>(i) << 23));
+				values[i] = static_cast<float>(hashes[i] & 0x7fffffff) / 2147483647.0f;
+			}
+		}
+	};
+
+	// Table lookups instead of integer multiplies: perm[perm[x] + y] picks the hash. Needs key.table for the seed.
+	struct Permutation {
+		template<class S>
+		static typename S::I index(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			auto mask = S::splatI(PermutationTable::Mask);
+			auto row = S::gather(key.table->perm.data(), S::bitAnd(xPrimed, mask));
+			return S::gather(key.table->perm.data(), S::add(row, S::bitAnd(yPrimed, mask)));
+		}
+
+		// perm[perm[perm[x] + y] + z], index is below Size so the doubled table covers the last step too
+		template<class S>
+		static typename S::I index3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			auto mask = S::splatI(PermutationTable::Mask);
+			return S::gather(key.table->perm.data(), S::add(index<S>(key, xPrimed, yPrimed), S::bitAnd(zPrimed, mask)));
+		}
+
+		template<class S>
+		static typename S::I hash(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			return S::gather(key.table->hashes.data(), index<S>(key, xPrimed, yPrimed));
+		}
+
+		template<class S>
+		static typename S::I hash3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			return S::gather(key.table->hashes.data(), index3<S>(key, xPrimed, yPrimed, zPrimed));
+		}
+
+		// The hash already mapped to [0, 1]
+		template<class S>
+		static typename S::F value(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed) {
+			return S::gatherF(key.table->values.data(), index<S>(key, xPrimed, yPrimed));
+		}
+
+		template<class S>
+		static typename S::F value3(const Key<S> &key, typename S::I xPrimed, typename S::I yPrimed, typename S::I zPrimed) {
+			return S::gatherF(key.table->values.data(), index3<S>(key, xPrimed, yPrimed, zPrimed));
+		}
+	};
+
+	// Policies with a value table skip the conversion of the hash to [0, 1]
+	template<class H>
+	constexpr bool HasValueTable = std::is_same_v<H, Permutation>;
+
+	/**
+	 * Calls fn.template operator()<Policy>() with the policy of the NoiseSimd::Hash value, so a resolver is
+	 * written once for every hash:
+	 *   dispatch(params.hash, [&]<class H>() { return Kernels<S, H>::resolve(params); });
+	 */
+	template<class Fn>
+	auto dispatch(int32_t hash, Fn &&fn) {
+		switch (hash) {
+			case NoiseSimd::HashPcg:
+				return fn.template operator()<Pcg>();
+			case NoiseSimd::HashXxHash:
+				return fn.template operator()<XxHash>();
+			case NoiseSimd::HashShiftAdd:
+				return fn.template operator()<ShiftAdd>();
+			case NoiseSimd::HashPermutation:
+				return fn.template operator()<Permutation>();
+			default:
+				return fn.template operator()<PrimeXor>();
+		}
+	}
+
+	// Scalar hash of the primed lattice point
+	template<class H>
+	int hashInt(const ScalarKey &key, int xPrimed, int yPrimed) {
+		return static_cast<int>(H::template hash<Lane>(key, static_cast<uint32_t>(xPrimed), static_cast<uint32_t>(yPrimed)));
+	}
+
+	template<class H>
+	int hashInt(int seed, int xPrimed, int yPrimed) {
+		static_assert(!std::is_same_v<H, Permutation>, "The permutation tables come with the key");
+		return hashInt<H>(ScalarKey{static_cast<uint32_t>(seed)}, xPrimed, yPrimed);
+	}
+
+	// Scalar hash mapped to [0, 1] from its low 31 bits
+	template<class H>
+	float hashFloat(const ScalarKey &key, int xPrimed, int yPrimed) {
+		if constexpr (HasValueTable<H>) {
+			return H::template value<Lane>(key, static_cast<uint32_t>(xPrimed), static_cast<uint32_t>(yPrimed));
+		}
+		else {
+			int h = hashInt<H>(key, xPrimed, yPrimed) & 0x7fffffff;
+			return h / 2147483647.0f;
+		}
+	}
+
+	// Scalar hash of the primed 3D lattice point
+	template<class H>
+	int hashInt3(const ScalarKey &key, int xPrimed, int yPrimed, int zPrimed) {
+		return static_cast<int>(H::template hash3<Lane>(key, static_cast<uint32_t>(xPrimed), static_cast<uint32_t>(yPrimed), static_cast<uint32_t>(zPrimed)));
+	}
+
+	template<class H>
+	float hashFloat3(const ScalarKey &key, int xPrimed, int yPrimed, int zPrimed) {
+		if constexpr (HasValueTable<H>) {
+			return H::template value3<Lane>(key, static_cast<uint32_t>(xPrimed), static_cast<uint32_t>(yPrimed), static_cast<uint32_t>(zPrimed));
+		}
+		else {
+			int h = hashInt3<H>(key, xPrimed, yPrimed, zPrimed) & 0x7fffffff;
+			return h / 2147483647.0f;
+		}
+	}
+
+	template<class H>
+	float hashFloat(int seed, int xPrimed, int yPrimed) {
+		static_assert(!std::is_same_v<H, Permutation>, "The permutation tables come with the key");
+		return hashFloat<H>(ScalarKey{static_cast<uint32_t>(seed)}, xPrimed, yPrimed);
+	}
+}
@@ -0,0 +1,821 @@
+#pragma once
+
+#include "noise_simd.h"
+#include "noise_hash.h"
+
+#include <type_traits>
+
+/*
+ * Instruction set independent noise kernels.
+ *
+ * Included by each noise_<isa>.cpp after it defines a traits struct S with:
+ *   Width                              Number of lanes
+ *   F, I                               Float and 32-bit integer vector types
+ *   splat(float), splatI(int32_t)      Broadcast
+ *   load(const float*), store(float*, F)
+ *   add/sub/mul/div/min/max (F, F)     Float arithmetic
+ *   sqrt(F), abs(F)
+ *   add/mul (I, I), bitAnd, bitXor     Integer arithmetic (multiplication wraps)
+ *   gather(const int32_t*, I)          Per lane table lookups, for the Permutation hash
+ *   gatherF(const float*, I)
+ *   toFloat(I), floor(F), floorToInt(F)
+ *   bitXor(F, F), castToFloat(I)        Bitwise float ops
+ *   shiftLeft<N>(I), shiftRight<N>(I)  Shifts (right is arithmetic)
+ *   shiftRightLogical<N>(I)            Logical right shift
+ *   equal(I, I), greaterThan(F, F)     Comparisons returning all-ones lane masks as I
+ *   select(I mask, F a, F b)           mask ? a : b per lane
+ *
+ * Every 2D kernel has a 3D overload taking z as well, points3 evaluates those.
+ *
+ * Kernels are templated on function, interpolation, cellular variant and fractal so every combination is compiled without
+ * branches in the sample loop, and on the lattice hash policy H of noise_hash.h. resolve() picks the instantiation once
+ * per descriptor.
+ *
+ * Every kernel follows the operation order of the scalar code in noise.h so results match Noise::eval
+ * up to Noise::BatchTolerance (the only differences come from compilers fusing multiply-adds).
+ */
+namespace NoiseSimd {
+
+	// PointsFn for 2D kernels, Points3Fn for 3D ones
+	template<int Dims>
+	using PointsFnOf = std::conditional_t<Dims == 3, Points3Fn, PointsFn>;
+
+	template<class S, class H = NoiseHash::PrimeXor>
+	struct Kernels {
+		using F = typename S::F;
+		using I = typename S::I;
+		using Key = NoiseHash::Key<S>;
+
+		// Hashing
+		// ----------------------------
+
+		static I hashPrimedInt(const Key &key, I xPrimed, I yPrimed) {
+			return H::template hash<S>(key, xPrimed, yPrimed);
+		}
+
+		static F hashPrimedFloat(const Key &key, I xPrimed, I yPrimed) {
+			if constexpr (NoiseHash::HasValueTable<H>) {
+				return H::template value<S>(key, xPrimed, yPrimed);
+			}
+			else {
+				I hash = S::bitAnd(hashPrimedInt(key, xPrimed, yPrimed), S::splatI(0x7fffffff));
+				return S::div(S::toFloat(hash), S::splat(2147483647.0f));
+			}
+		}
+
+		static I hashPrimedInt(const Key &key, I xPrimed, I yPrimed, I zPrimed) {
+			return H::template hash3<S>(key, xPrimed, yPrimed, zPrimed);
+		}
+
+		static F hashPrimedFloat(const Key &key, I xPrimed, I yPrimed, I zPrimed) {
+			if constexpr (NoiseHash::HasValueTable<H>) {
+				return H::template value3<S>(key, xPrimed, yPrimed, zPrimed);
+			}
+			else {
+				I hash = S::bitAnd(hashPrimedInt(key, xPrimed, yPrimed, zPrimed), S::splatI(0x7fffffff));
+				return S::div(S::toFloat(hash), S::splat(2147483647.0f));
+			}
+		}
+
+		// Branchless Noise::gradientDot
+		static F gradientDot(I hash, F x, F y) {
+			I h = S::bitAnd(S::template shiftRight<28>(hash), S::splatI(7));
+			I swap = S::equal(S::bitAnd(h, S::splatI(4)), S::splatI(4));
+			F u = S::select(swap, y, x);
+			F v = S::select(swap, x, y);
+
+			// Hash bits 0 and 1 flip the signs
+			u = S::bitXor(u, S::castToFloat(S::template shiftLeft<31>(h)));
+			v = S::bitXor(v, S::castToFloat(S::bitAnd(S::template shiftLeft<30>(h), S::splatI(INT32_MIN))));
+			return S::add(u, S::mul(v, S::splat(0.5f)));
+		}
+
+		// Branchless 3D Noise::gradientDot
+		static F gradientDot(I hash, F x, F y, F z) {
+			I h = S::bitAnd(S::template shiftRight<28>(hash), S::splatI(15));
+			F u = S::select(S::equal(S::bitAnd(h, S::splatI(8)), S::splatI(8)), y, x);
+			F v = S::select(S::equal(S::bitAnd(h, S::splatI(12)), S::splatI(0)), y,
+							S::select(S::equal(S::bitAnd(h, S::splatI(13)), S::splatI(12)), x, z));
+
+			u = S::bitXor(u, S::castToFloat(S::template shiftLeft<31>(h)));
+			v = S::bitXor(v, S::castToFloat(S::bitAnd(S::template shiftLeft<30>(h), S::splatI(INT32_MIN))));
+			return S::add(u, v);
+		}
+
+		static F clamp01(F v) {
+			return S::min(S::max(v, S::splat(0.0f)), S::splat(1.0f));
+		}
+
+
+		// Interpolation
+		// ----------------------------
+
+		static F lerp(F a, F b, F t) {
+			return S::add(a, S::mul(t, S::sub(b, a)));
+		}
+
+		static F cubicLerp(F a, F b, F c, F d, F t) {
+			F p = S::sub(S::sub(d, c), S::sub(a, b));
+			F q = S::sub(S::sub(a, b), p);
+			F r = S::sub(c, a);
+			F pt = S::mul(S::mul(S::mul(p, t), t), t);
+			F qt = S::mul(S::mul(q, t), t);
+			return clamp01(S::add(S::add(S::add(pt, qt), S::mul(r, t)), b));
+		}
+
+		template<int32_t Interp>
+		static F interpolate(F t) {
+			if constexpr (Interp == InterpolationSmoothstep) {
+				return S::mul(S::mul(t, t), S::sub(S::splat(3.0f), S::mul(S::splat(2.0f), t)));
+			}
+			else if constexpr (Interp == InterpolationSmootherstep) {
+				F inner = S::add(S::mul(t, S::sub(S::mul(t, S::splat(6.0f)), S::splat(15.0f))), S::splat(10.0f));
+				return S::mul(S::mul(S::mul(t, t), t), inner);
+			}
+			else {
+				return t;
+			}
+		}
+
+
+		// Noise functions
+		// ----------------------------
+
+		template<int32_t Interp>
+		static F evalLinear(const Key &key, F x, F y) {
+			I x0 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y0 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I x1 = S::add(x0, S::splatI(PrimeX));
+			I y1 = S::add(y0, S::splatI(PrimeY));
+
+			F c00 = hashPrimedFloat(key, x0, y0);
+			F c10 = hashPrimedFloat(key, x1, y0);
+			F c01 = hashPrimedFloat(key, x0, y1);
+			F c11 = hashPrimedFloat(key, x1, y1);
+
+			F tx = interpolate<Interp>(S::sub(x, S::floor(x)));
+			F ty = interpolate<Interp>(S::sub(y, S::floor(y)));
+
+			F top = lerp(c00, c10, tx);
+			F bot = lerp(c01, c11, tx);
+			return lerp(top, bot, ty);
+		}
+
+		static F evalCubicRow(const Key &key, I x0, I x1, I x2, I x3, I yPrimed, F xFrac) {
+			return cubicLerp(hashPrimedFloat(key, x0, yPrimed),
+							 hashPrimedFloat(key, x1, yPrimed),
+							 hashPrimedFloat(key, x2, yPrimed),
+							 hashPrimedFloat(key, x3, yPrimed),
+							 xFrac);
+		}
+
+		static F evalCubic(const Key &key, F x, F y) {
+			F xFrac = S::sub(x, S::floor(x));
+			F yFrac = S::sub(y, S::floor(y));
+
+			I x1 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y1 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I x0 = S::add(x1, S::splatI(-PrimeX));
+			I y0 = S::add(y1, S::splatI(-PrimeY));
+			I x2 = S::add(x1, S::splatI(PrimeX));
+			I y2 = S::add(y1, S::splatI(PrimeY));
+			I x3 = S::add(x2, S::splatI(PrimeX));
+			I y3 = S::add(y2, S::splatI(PrimeY));
+
+			F r0 = evalCubicRow(key, x0, x1, x2, x3, y0, xFrac);
+			F r1 = evalCubicRow(key, x0, x1, x2, x3, y1, xFrac);
+			F r2 = evalCubicRow(key, x0, x1, x2, x3, y2, xFrac);
+			F r3 = evalCubicRow(key, x0, x1, x2, x3, y3, xFrac);
+
+			return cubicLerp(r0, r1, r2, r3, yFrac);
+		}
+
+		static F evalPerlin(const Key &key, F x, F y) {
+			I x0 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y0 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I x1 = S::add(x0, S::splatI(PrimeX));
+			I y1 = S::add(y0, S::splatI(PrimeY));
+
+			F dx = S::sub(x, S::floor(x));
+			F dy = S::sub(y, S::floor(y));
+			F dx1 = S::sub(dx, S::splat(1.0f));
+			F dy1 = S::sub(dy, S::splat(1.0f));
+
+			F g00 = gradientDot(hashPrimedInt(key, x0, y0), dx, dy);
+			F g10 = gradientDot(hashPrimedInt(key, x1, y0), dx1, dy);
+			F g01 = gradientDot(hashPrimedInt(key, x0, y1), dx, dy1);
+			F g11 = gradientDot(hashPrimedInt(key, x1, y1), dx1, dy1);
+
+			F tx = interpolate<InterpolationSmootherstep>(dx);
+			F ty = interpolate<InterpolationSmootherstep>(dy);
+			F v = lerp(lerp(g00, g10, tx), lerp(g01, g11, tx), ty);
+			return clamp01(S::add(S::mul(S::mul(v, S::splat(PerlinScale)), S::splat(0.5f)), S::splat(0.5f)));
+		}
+
+		static F simplexCorner(I hash, F x, F y) {
+			F a = S::max(S::sub(S::sub(S::splat(0.5f), S::mul(x, x)), S::mul(y, y)), S::splat(0.0f));
+			a = S::mul(a, a);
+			return S::mul(S::mul(a, a), gradientDot(hash, x, y));
+		}
+
+		static F evalSimplex(const Key &key, F x, F y) {
+			F s = S::mul(S::add(x, y), S::splat(SimplexF2));
+			F i = S::floor(S::add(x, s));
+			F j = S::floor(S::add(y, s));
+
+			F t = S::mul(S::add(i, j), S::splat(SimplexG2));
+			F x0 = S::sub(x, S::sub(i, t));
+			F y0 = S::sub(y, S::sub(j, t));
+
+			I lower = S::greaterThan(x0, y0);
+			F one = S::splat(1.0f);
+			F zero = S::splat(0.0f);
+			F x1 = S::add(S::sub(x0, S::select(lower, one, zero)), S::splat(SimplexG2));
+			F y1 = S::add(S::sub(y0, S::select(lower, zero, one)), S::splat(SimplexG2));
+			F x2 = S::add(S::sub(x0, one), S::splat(2.0f * SimplexG2));
+			F y2 = S::add(S::sub(y0, one), S::splat(2.0f * SimplexG2));
+
+			I iPrimed = S::mul(S::floorToInt(S::add(x, s)), S::splatI(PrimeX));
+			I jPrimed = S::mul(S::floorToInt(S::add(y, s)), S::splatI(PrimeY));
+			I i1 = S::bitAnd(lower, S::splatI(PrimeX));
+			I j1 = S::bitAnd(S::bitXor(lower, S::splatI(-1)), S::splatI(PrimeY));
+
+			F n0 = simplexCorner(hashPrimedInt(key, iPrimed, jPrimed), x0, y0);
+			F n1 = simplexCorner(hashPrimedInt(key, S::add(iPrimed, i1), S::add(jPrimed, j1)), x1, y1);
+			F n2 = simplexCorner(hashPrimedInt(key, S::add(iPrimed, S::splatI(PrimeX)), S::add(jPrimed, S::splatI(PrimeY))), x2, y2);
+
+			F sum = S::add(S::add(n0, n1), n2);
+			return clamp01(S::add(S::mul(S::mul(sum, S::splat(SimplexScale)), S::splat(0.5f)), S::splat(0.5f)));
+		}
+
+		template<int32_t Dist>
+		static F cellularDistance(F x, F y) {
+			if constexpr (Dist == CellularManhattan) {
+				return S::add(S::abs(x), S::abs(y));
+			}
+			else {
+				return S::add(S::mul(x, x), S::mul(y, y));
+			}
+		}
+
+		// Noise::evalCellular without the neighbour pruning, every lane visits all 9 cells so no lane
+		// waits on another. The pruned cells can't change F1 or F2, so the results still match.
+		template<int32_t Dist, int32_t Ret>
+		static F evalCellular(const Key &key, F x, F y) {
+			I x0 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y0 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			F tx = S::sub(x, S::floor(x));
+			F ty = S::sub(y, S::floor(y));
+
+			F f1 = S::splat(CellularMaxDistance);
+			F f2 = S::splat(CellularMaxDistance);
+			F offsetScale = S::splat(1.0f / 65536.0f);
+
+			for (int j = -1; j <= 1; j++) {
+				I yPrimed = S::add(y0, S::splatI(j * PrimeY));
+				for (int i = -1; i <= 1; i++) {
+					I h = hashPrimedInt(key, S::add(x0, S::splatI(i * PrimeX)), yPrimed);
+					h = S::bitXor(h, S::template shiftRight<15>(h));
+					F ox = S::mul(S::toFloat(S::bitAnd(h, S::splatI(0xffff))), offsetScale);
+					F oy = S::mul(S::toFloat(S::bitAnd(S::template shiftRight<16>(h), S::splatI(0xffff))), offsetScale);
+
+					F d = cellularDistance<Dist>(S::sub(S::add(S::splat(float(i)), ox), tx), S::sub(S::add(S::splat(float(j)), oy), ty));
+					f2 = S::min(S::max(f1, d), f2);
+					f1 = S::min(f1, d);
+				}
+			}
+
+			if constexpr (Dist == CellularEuclidean) {
+				f1 = S::sqrt(f1);
+				f2 = S::sqrt(f2);
+			}
+
+			if constexpr (Ret == CellularF2) {
+				return clamp01(S::mul(f2, S::splat(CellularScale)));
+			}
+			else if constexpr (Ret == CellularF2MinusF1) {
+				return clamp01(S::mul(S::sub(f2, f1), S::splat(CellularScale)));
+			}
+			else {
+				return clamp01(S::mul(f1, S::splat(CellularScale)));
+			}
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret>
+		static F evalFunction(const Key &key, F x, F y) {
+			if constexpr (Fn == FunctionCellular) {
+				return evalCellular<Dist, Ret>(key, x, y);
+			}
+			else if constexpr (Fn == FunctionValueCubic) {
+				return evalCubic(key, x, y);
+			}
+			else if constexpr (Fn == FunctionPerlin) {
+				return evalPerlin(key, x, y);
+			}
+			else if constexpr (Fn == FunctionSimplex) {
+				return evalSimplex(key, x, y);
+			}
+			else {
+				return evalLinear<Interp>(key, x, y);
+			}
+		}
+
+		static constexpr bool isOctaveFractal(int32_t fractal) {
+			return fractal == FractalFBM || fractal == FractalRidged || fractal == FractalTurbulence;
+		}
+
+		template<int32_t Frac>
+		static F octaveShape(F noise) {
+			if constexpr (Frac == FractalTurbulence) {
+				return S::abs(S::sub(S::mul(noise, S::splat(2.0f)), S::splat(1.0f)));
+			}
+			else if constexpr (Frac == FractalRidged) {
+				return S::sub(S::splat(1.0f), S::abs(S::sub(S::mul(noise, S::splat(2.0f)), S::splat(1.0f))));
+			}
+			else {
+				return noise;
+			}
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static F evalFBm(const Params &params, const Key &key, F x, F y) {
+			float amp0 = 0.4f + (1.0f / params.octaves) * (1.0f - 0.4f);
+			F amp = S::splat(amp0);
+			F sum = S::splat(0.0f);
+			F strength = S::splat(params.weightedStrength);
+			float freq = 1.0f;
+
+			for (int i = 0; i < params.octaves; i++) {
+				F f = S::splat(freq);
+				F noise = octaveShape<Frac>(evalFunction<Fn, Interp, Dist, Ret>(key, S::mul(x, f), S::mul(y, f)));
+				sum = S::add(sum, S::mul(amp, noise));
+
+				amp = S::mul(amp, lerp(S::splat(1.0f), S::mul(noise, S::splat(0.5f)), strength));
+				amp = S::mul(amp, S::splat(params.gain));
+
+				freq *= params.lacunarity;
+			}
+
+			return clamp01(sum);
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static F eval(const Params &params, F x, F y) {
+			Key key{S::splatI(params.seed), params.table};
+
+			// Noise::evalWarp
+			if constexpr (Frac == FractalDomainWarp) {
+				F warpScale = S::splat(params.frequency * params.warpFrequency);
+				F qx = S::mul(x, warpScale);
+				F qy = S::mul(y, warpScale);
+				F wx = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, qx, qy);
+				F wy = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, S::add(qx, S::splat(WarpOffsetX)), S::add(qy, S::splat(WarpOffsetY)));
+				F warpAmplitude = S::splat(params.warpAmplitude);
+				x = S::add(x, S::mul(S::sub(S::mul(wx, S::splat(2.0f)), S::splat(1.0f)), warpAmplitude));
+				y = S::add(y, S::mul(S::sub(S::mul(wy, S::splat(2.0f)), S::splat(1.0f)), warpAmplitude));
+			}
+
+			F frequency = S::splat(params.frequency);
+			x = S::mul(x, frequency);
+			y = S::mul(y, frequency);
+
+			F out;
+			if constexpr (isOctaveFractal(Frac)) {
+				out = evalFBm<Fn, Interp, Dist, Ret, Frac>(params, key, x, y);
+			}
+			else if constexpr (Frac == FractalDomainWarp) {
+				out = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, x, y);
+			}
+			else {
+				out = evalFunction<Fn, Interp, Dist, Ret>(key, x, y);
+			}
+			return S::mul(out, S::splat(params.amplitude));
+		}
+
+
+		// 3D noise functions
+		// ----------------------------
+
+		template<int32_t Interp>
+		static F evalLinear(const Key &key, F x, F y, F z) {
+			I x0 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y0 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I z0 = S::mul(S::floorToInt(z), S::splatI(PrimeZ));
+			I x1 = S::add(x0, S::splatI(PrimeX));
+			I y1 = S::add(y0, S::splatI(PrimeY));
+			I z1 = S::add(z0, S::splatI(PrimeZ));
+
+			F tx = interpolate<Interp>(S::sub(x, S::floor(x)));
+			F ty = interpolate<Interp>(S::sub(y, S::floor(y)));
+			F tz = interpolate<Interp>(S::sub(z, S::floor(z)));
+
+			F x00 = lerp(hashPrimedFloat(key, x0, y0, z0), hashPrimedFloat(key, x1, y0, z0), tx);
+			F x10 = lerp(hashPrimedFloat(key, x0, y1, z0), hashPrimedFloat(key, x1, y1, z0), tx);
+			F x01 = lerp(hashPrimedFloat(key, x0, y0, z1), hashPrimedFloat(key, x1, y0, z1), tx);
+			F x11 = lerp(hashPrimedFloat(key, x0, y1, z1), hashPrimedFloat(key, x1, y1, z1), tx);
+			return lerp(lerp(x00, x10, ty), lerp(x01, x11, ty), tz);
+		}
+
+		static F evalCubic(const Key &key, F x, F y, F z) {
+			F xFrac = S::sub(x, S::floor(x));
+			F yFrac = S::sub(y, S::floor(y));
+			F zFrac = S::sub(z, S::floor(z));
+
+			I x1 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y1 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I z1 = S::mul(S::floorToInt(z), S::splatI(PrimeZ));
+			I xs[4] = {S::add(x1, S::splatI(-PrimeX)), x1, S::add(x1, S::splatI(PrimeX)), S::add(S::add(x1, S::splatI(PrimeX)), S::splatI(PrimeX))};
+			I ys[4] = {S::add(y1, S::splatI(-PrimeY)), y1, S::add(y1, S::splatI(PrimeY)), S::add(S::add(y1, S::splatI(PrimeY)), S::splatI(PrimeY))};
+			I zs[4] = {S::add(z1, S::splatI(-PrimeZ)), z1, S::add(z1, S::splatI(PrimeZ)), S::add(S::add(z1, S::splatI(PrimeZ)), S::splatI(PrimeZ))};
+
+			F planes[4];
+			for (int k = 0; k < 4; k++) {
+				F rows[4];
+				for (int j = 0; j < 4; j++) {
+					rows[j] = cubicLerp(hashPrimedFloat(key, xs[0], ys[j], zs[k]), hashPrimedFloat(key, xs[1], ys[j], zs[k]),
+										hashPrimedFloat(key, xs[2], ys[j], zs[k]), hashPrimedFloat(key, xs[3], ys[j], zs[k]), xFrac);
+				}
+				planes[k] = cubicLerp(rows[0], rows[1], rows[2], rows[3], yFrac);
+			}
+			return cubicLerp(planes[0], planes[1], planes[2], planes[3], zFrac);
+		}
+
+		static F evalPerlin(const Key &key, F x, F y, F z) {
+			I x0 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y0 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I z0 = S::mul(S::floorToInt(z), S::splatI(PrimeZ));
+			I x1 = S::add(x0, S::splatI(PrimeX));
+			I y1 = S::add(y0, S::splatI(PrimeY));
+			I z1 = S::add(z0, S::splatI(PrimeZ));
+
+			F dx = S::sub(x, S::floor(x));
+			F dy = S::sub(y, S::floor(y));
+			F dz = S::sub(z, S::floor(z));
+			F dx1 = S::sub(dx, S::splat(1.0f));
+			F dy1 = S::sub(dy, S::splat(1.0f));
+			F dz1 = S::sub(dz, S::splat(1.0f));
+
+			F g000 = gradientDot(hashPrimedInt(key, x0, y0, z0), dx, dy, dz);
+			F g100 = gradientDot(hashPrimedInt(key, x1, y0, z0), dx1, dy, dz);
+			F g010 = gradientDot(hashPrimedInt(key, x0, y1, z0), dx, dy1, dz);
+			F g110 = gradientDot(hashPrimedInt(key, x1, y1, z0), dx1, dy1, dz);
+			F g001 = gradientDot(hashPrimedInt(key, x0, y0, z1), dx, dy, dz1);
+			F g101 = gradientDot(hashPrimedInt(key, x1, y0, z1), dx1, dy, dz1);
+			F g011 = gradientDot(hashPrimedInt(key, x0, y1, z1), dx, dy1, dz1);
+			F g111 = gradientDot(hashPrimedInt(key, x1, y1, z1), dx1, dy1, dz1);
+
+			F tx = interpolate<InterpolationSmootherstep>(dx);
+			F ty = interpolate<InterpolationSmootherstep>(dy);
+			F tz = interpolate<InterpolationSmootherstep>(dz);
+			F v = lerp(lerp(lerp(g000, g100, tx), lerp(g010, g110, tx), ty), lerp(lerp(g001, g101, tx), lerp(g011, g111, tx), ty), tz);
+			return clamp01(S::add(S::mul(S::mul(v, S::splat(PerlinScale3)), S::splat(0.5f)), S::splat(0.5f)));
+		}
+
+		static F simplexCorner(I hash, F x, F y, F z) {
+			F a = S::max(S::sub(S::sub(S::sub(S::splat(0.5f), S::mul(x, x)), S::mul(y, y)), S::mul(z, z)), S::splat(0.0f));
+			a = S::mul(a, a);
+			return S::mul(S::mul(a, a), gradientDot(hash, x, y, z));
+		}
+
+		// Noise::evalSimplex in 3D, the tetrahedron ranks as lane masks
+		static F evalSimplex(const Key &key, F x, F y, F z) {
+			F s = S::mul(S::add(S::add(x, y), z), S::splat(SimplexF3));
+			F i = S::floor(S::add(x, s));
+			F j = S::floor(S::add(y, s));
+			F k = S::floor(S::add(z, s));
+
+			F t = S::mul(S::add(S::add(i, j), k), S::splat(SimplexG3));
+			F x0 = S::sub(x, S::sub(i, t));
+			F y0 = S::sub(y, S::sub(j, t));
+			F z0 = S::sub(z, S::sub(k, t));
+
+			// a >= b is !(b > a)
+			I all = S::splatI(-1);
+			I xy = S::bitXor(S::greaterThan(y0, x0), all);
+			I yz = S::bitXor(S::greaterThan(z0, y0), all);
+			I xz = S::bitXor(S::greaterThan(z0, x0), all);
+			I nxy = S::bitXor(xy, all);
+			I nyz = S::bitXor(yz, all);
+			I nxz = S::bitXor(xz, all);
+			I i1 = S::bitAnd(xy, xz);
+			I j1 = S::bitAnd(nxy, yz);
+			I k1 = S::bitAnd(nyz, nxz);
+			I i2 = S::bitXor(S::bitAnd(nxy, nxz), all);
+			I j2 = S::bitXor(S::bitAnd(xy, nyz), all);
+			I k2 = S::bitXor(S::bitAnd(yz, xz), all);
+
+			F one = S::splat(1.0f);
+			F zero = S::splat(0.0f);
+			F g1 = S::splat(SimplexG3);
+			F g2 = S::splat(2.0f * SimplexG3);
+			F g3 = S::splat(3.0f * SimplexG3);
+			F x1 = S::add(S::sub(x0, S::select(i1, one, zero)), g1);
+			F y1 = S::add(S::sub(y0, S::select(j1, one, zero)), g1);
+			F z1 = S::add(S::sub(z0, S::select(k1, one, zero)), g1);
+			F x2 = S::add(S::sub(x0, S::select(i2, one, zero)), g2);
+			F y2 = S::add(S::sub(y0, S::select(j2, one, zero)), g2);
+			F z2 = S::add(S::sub(z0, S::select(k2, one, zero)), g2);
+			F x3 = S::add(S::sub(x0, one), g3);
+			F y3 = S::add(S::sub(y0, one), g3);
+			F z3 = S::add(S::sub(z0, one), g3);
+
+			I iPrimed = S::mul(S::floorToInt(S::add(x, s)), S::splatI(PrimeX));
+			I jPrimed = S::mul(S::floorToInt(S::add(y, s)), S::splatI(PrimeY));
+			I kPrimed = S::mul(S::floorToInt(S::add(z, s)), S::splatI(PrimeZ));
+			I px = S::splatI(PrimeX);
+			I py = S::splatI(PrimeY);
+			I pz = S::splatI(PrimeZ);
+
+			F n0 = simplexCorner(hashPrimedInt(key, iPrimed, jPrimed, kPrimed), x0, y0, z0);
+			F n1 = simplexCorner(hashPrimedInt(key, S::add(iPrimed, S::bitAnd(i1, px)), S::add(jPrimed, S::bitAnd(j1, py)), S::add(kPrimed, S::bitAnd(k1, pz))), x1, y1, z1);
+			F n2 = simplexCorner(hashPrimedInt(key, S::add(iPrimed, S::bitAnd(i2, px)), S::add(jPrimed, S::bitAnd(j2, py)), S::add(kPrimed, S::bitAnd(k2, pz))), x2, y2, z2);
+			F n3 = simplexCorner(hashPrimedInt(key, S::add(iPrimed, px), S::add(jPrimed, py), S::add(kPrimed, pz)), x3, y3, z3);
+
+			F sum = S::add(S::add(S::add(n0, n1), n2), n3);
+			return clamp01(S::add(S::mul(S::mul(sum, S::splat(SimplexScale3)), S::splat(0.5f)), S::splat(0.5f)));
+		}
+
+		template<int32_t Dist>
+		static F cellularDistance(F x, F y, F z) {
+			if constexpr (Dist == CellularManhattan) {
+				return S::add(S::add(S::abs(x), S::abs(y)), S::abs(z));
+			}
+			else {
+				return S::add(S::add(S::mul(x, x), S::mul(y, y)), S::mul(z, z));
+			}
+		}
+
+		// 3D Noise::evalCellular, all 27 cells without pruning
+		template<int32_t Dist, int32_t Ret>
+		static F evalCellular(const Key &key, F x, F y, F z) {
+			I x0 = S::mul(S::floorToInt(x), S::splatI(PrimeX));
+			I y0 = S::mul(S::floorToInt(y), S::splatI(PrimeY));
+			I z0 = S::mul(S::floorToInt(z), S::splatI(PrimeZ));
+			F tx = S::sub(x, S::floor(x));
+			F ty = S::sub(y, S::floor(y));
+			F tz = S::sub(z, S::floor(z));
+
+			F f1 = S::splat(CellularMaxDistance);
+			F f2 = S::splat(CellularMaxDistance);
+			F offsetScale = S::splat(1.0f / 1024.0f);
+			I offsetMask = S::splatI(0x3ff);
+
+			for (int k = -1; k <= 1; k++) {
+				I zPrimed = S::add(z0, S::splatI(k * PrimeZ));
+				for (int j = -1; j <= 1; j++) {
+					I yPrimed = S::add(y0, S::splatI(j * PrimeY));
+					for (int i = -1; i <= 1; i++) {
+						I h = hashPrimedInt(key, S::add(x0, S::splatI(i * PrimeX)), yPrimed, zPrimed);
+						h = S::bitXor(h, S::template shiftRight<15>(h));
+						F ox = S::mul(S::toFloat(S::bitAnd(h, offsetMask)), offsetScale);
+						F oy = S::mul(S::toFloat(S::bitAnd(S::template shiftRight<10>(h), offsetMask)), offsetScale);
+						F oz = S::mul(S::toFloat(S::bitAnd(S::template shiftRight<20>(h), offsetMask)), offsetScale);
+
+						F d = cellularDistance<Dist>(S::sub(S::add(S::splat(float(i)), ox), tx),
+													 S::sub(S::add(S::splat(float(j)), oy), ty),
+													 S::sub(S::add(S::splat(float(k)), oz), tz));
+						f2 = S::min(S::max(f1, d), f2);
+						f1 = S::min(f1, d);
+					}
+				}
+			}
+
+			if constexpr (Dist == CellularEuclidean) {
+				f1 = S::sqrt(f1);
+				f2 = S::sqrt(f2);
+			}
+
+			if constexpr (Ret == CellularF2) {
+				return clamp01(S::mul(f2, S::splat(CellularScale)));
+			}
+			else if constexpr (Ret == CellularF2MinusF1) {
+				return clamp01(S::mul(S::sub(f2, f1), S::splat(CellularScale)));
+			}
+			else {
+				return clamp01(S::mul(f1, S::splat(CellularScale)));
+			}
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret>
+		static F evalFunction(const Key &key, F x, F y, F z) {
+			if constexpr (Fn == FunctionCellular) {
+				return evalCellular<Dist, Ret>(key, x, y, z);
+			}
+			else if constexpr (Fn == FunctionValueCubic) {
+				return evalCubic(key, x, y, z);
+			}
+			else if constexpr (Fn == FunctionPerlin) {
+				return evalPerlin(key, x, y, z);
+			}
+			else if constexpr (Fn == FunctionSimplex) {
+				return evalSimplex(key, x, y, z);
+			}
+			else {
+				return evalLinear<Interp>(key, x, y, z);
+			}
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static F evalFBm(const Params &params, const Key &key, F x, F y, F z) {
+			float amp0 = 0.4f + (1.0f / params.octaves) * (1.0f - 0.4f);
+			F amp = S::splat(amp0);
+			F sum = S::splat(0.0f);
+			F strength = S::splat(params.weightedStrength);
+			float freq = 1.0f;
+
+			for (int i = 0; i < params.octaves; i++) {
+				F f = S::splat(freq);
+				F noise = octaveShape<Frac>(evalFunction<Fn, Interp, Dist, Ret>(key, S::mul(x, f), S::mul(y, f), S::mul(z, f)));
+				sum = S::add(sum, S::mul(amp, noise));
+
+				amp = S::mul(amp, lerp(S::splat(1.0f), S::mul(noise, S::splat(0.5f)), strength));
+				amp = S::mul(amp, S::splat(params.gain));
+
+				freq *= params.lacunarity;
+			}
+
+			return clamp01(sum);
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static F eval(const Params &params, F x, F y, F z) {
+			Key key{S::splatI(params.seed), params.table};
+
+			// Noise::evalWarp in 3D
+			if constexpr (Frac == FractalDomainWarp) {
+				F warpScale = S::splat(params.frequency * params.warpFrequency);
+				F qx = S::mul(x, warpScale);
+				F qy = S::mul(y, warpScale);
+				F qz = S::mul(z, warpScale);
+				F ox = S::splat(WarpOffsetX);
+				F oy = S::splat(WarpOffsetY);
+				F oz = S::splat(WarpOffsetZ);
+				F wx = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, qx, qy, qz);
+				F wy = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, S::add(qx, ox), S::add(qy, oy), S::add(qz, oz));
+				F wz = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, S::sub(qx, ox), S::sub(qy, oy), S::sub(qz, oz));
+				F warpAmplitude = S::splat(params.warpAmplitude);
+				x = S::add(x, S::mul(S::sub(S::mul(wx, S::splat(2.0f)), S::splat(1.0f)), warpAmplitude));
+				y = S::add(y, S::mul(S::sub(S::mul(wy, S::splat(2.0f)), S::splat(1.0f)), warpAmplitude));
+				z = S::add(z, S::mul(S::sub(S::mul(wz, S::splat(2.0f)), S::splat(1.0f)), warpAmplitude));
+			}
+
+			F frequency = S::splat(params.frequency);
+			x = S::mul(x, frequency);
+			y = S::mul(y, frequency);
+			z = S::mul(z, frequency);
+
+			F out;
+			if constexpr (isOctaveFractal(Frac)) {
+				out = evalFBm<Fn, Interp, Dist, Ret, Frac>(params, key, x, y, z);
+			}
+			else if constexpr (Frac == FractalDomainWarp) {
+				out = evalFBm<Fn, Interp, Dist, Ret, FractalFBM>(params, key, x, y, z);
+			}
+			else {
+				out = evalFunction<Fn, Interp, Dist, Ret>(key, x, y, z);
+			}
+			return S::mul(out, S::splat(params.amplitude));
+		}
+
+
+		// Entry points
+		// ----------------------------
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static void points(const Params &params, const float *xs, const float *ys, float *out, size_t count) {
+			size_t i = 0;
+			for (; i + S::Width <= count; i += S::Width) {
+				S::store(out + i, eval<Fn, Interp, Dist, Ret, Frac>(params, S::load(xs + i), S::load(ys + i)));
+			}
+
+			// Pad the remaining samples out to a full vector
+			if (i < count) {
+				float xTail[S::Width] = {};
+				float yTail[S::Width] = {};
+				float outTail[S::Width];
+				size_t remaining = count - i;
+				for (size_t j = 0; j < remaining; j++) {
+					xTail[j] = xs[i + j];
+					yTail[j] = ys[i + j];
+				}
+				S::store(outTail, eval<Fn, Interp, Dist, Ret, Frac>(params, S::load(xTail), S::load(yTail)));
+				for (size_t j = 0; j < remaining; j++) {
+					out[i + j] = outTail[j];
+				}
+			}
+		}
+
+		template<int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static void points3(const Params &params, const float *xs, const float *ys, const float *zs, float *out, size_t count) {
+			size_t i = 0;
+			for (; i + S::Width <= count; i += S::Width) {
+				S::store(out + i, eval<Fn, Interp, Dist, Ret, Frac>(params, S::load(xs + i), S::load(ys + i), S::load(zs + i)));
+			}
+
+			if (i < count) {
+				float xTail[S::Width] = {};
+				float yTail[S::Width] = {};
+				float zTail[S::Width] = {};
+				float outTail[S::Width];
+				size_t remaining = count - i;
+				for (size_t j = 0; j < remaining; j++) {
+					xTail[j] = xs[i + j];
+					yTail[j] = ys[i + j];
+					zTail[j] = zs[i + j];
+				}
+				S::store(outTail, eval<Fn, Interp, Dist, Ret, Frac>(params, S::load(xTail), S::load(yTail), S::load(zTail)));
+				for (size_t j = 0; j < remaining; j++) {
+					out[i + j] = outTail[j];
+				}
+			}
+		}
+
+		// Specialization lookup, mirrors Noise::resolveSample
+		// ----------------------------
+
+		template<int Dims, int32_t Fn, int32_t Interp, int32_t Dist, int32_t Ret, int32_t Frac>
+		static constexpr PointsFnOf<Dims> pointsKernel() {
+			if constexpr (Dims == 3) {
+				return &points3<Fn, Interp, Dist, Ret, Frac>;
+			}
+			else {
+				return &points<Fn, Interp, Dist, Ret, Frac>;
+			}
+		}
+
+		template<int Dims, int32_t Fn, int32_t Interp, int32_t Dist = CellularEuclidean, int32_t Ret = CellularF1>
+		static PointsFnOf<Dims> resolveFractal(int32_t fractal) {
+			switch (fractal) {
+				case FractalFBM:
+					return pointsKernel<Dims, Fn, Interp, Dist, Ret, FractalFBM>();
+				case FractalRidged:
+					return pointsKernel<Dims, Fn, Interp, Dist, Ret, FractalRidged>();
+				case FractalTurbulence:
+					return pointsKernel<Dims, Fn, Interp, Dist, Ret, FractalTurbulence>();
+				case FractalDomainWarp:
+					return pointsKernel<Dims, Fn, Interp, Dist, Ret, FractalDomainWarp>();
+				default:
+					return pointsKernel<Dims, Fn, Interp, Dist, Ret, FractalNone>();
+			}
+		}
+
+		template<int Dims, int32_t Fn>
+		static PointsFnOf<Dims> resolveInterpolation(int32_t interpolation, int32_t fractal) {
+			switch (interpolation) {
+				case InterpolationSmoothstep:
+					return resolveFractal<Dims, Fn, InterpolationSmoothstep>(fractal);
+				case InterpolationSmootherstep:
+					return resolveFractal<Dims, Fn, InterpolationSmootherstep>(fractal);
+				default:
+					return resolveFractal<Dims, Fn, InterpolationLinear>(fractal);
+			}
+		}
+
+		template<int Dims, int32_t Dist>
+		static PointsFnOf<Dims> resolveCellularReturn(int32_t cellularReturn, int32_t fractal) {
+			switch (cellularReturn) {
+				case CellularF2:
+					return resolveFractal<Dims, FunctionCellular, InterpolationLinear, Dist, CellularF2>(fractal);
+				case CellularF2MinusF1:
+					return resolveFractal<Dims, FunctionCellular, InterpolationLinear, Dist, CellularF2MinusF1>(fractal);
+				default:
+					return resolveFractal<Dims, FunctionCellular, InterpolationLinear, Dist, CellularF1>(fractal);
+			}
+		}
+
+		template<int Dims>
+		static PointsFnOf<Dims> resolveCellular(const Params &params) {
+			switch (params.cellularDistance) {
+				case CellularEuclideanSquared:
+					return resolveCellularReturn<Dims, CellularEuclideanSquared>(params.cellularReturn, params.fractal);
+				case CellularManhattan:
+					return resolveCellularReturn<Dims, CellularManhattan>(params.cellularReturn, params.fractal);
+				default:
+					return resolveCellularReturn<Dims, CellularEuclidean>(params.cellularReturn, params.fractal);
+			}
+		}
+
+		template<int Dims>
+		static PointsFnOf<Dims> resolve(const Params &params) {
+			switch (params.function) {
+				// Cubic, gradient and cellular noise ignore the interpolation setting
+				case FunctionValueCubic:
+					return resolveFractal<Dims, FunctionValueCubic, InterpolationLinear>(params.fractal);
+				case FunctionPerlin:
+					return resolveFractal<Dims, FunctionPerlin, InterpolationLinear>(params.fractal);
+				case FunctionSimplex:
+					return resolveFractal<Dims, FunctionSimplex, InterpolationLinear>(params.fractal);
+				case FunctionCellular:
+					return resolveCellular<Dims>(params);
+				default:
+					return resolveInterpolation<Dims, FunctionValue>(params.interpolation, params.fractal);
+			}
+		}
+	};
+
+	// Kernel for params with its hash policy, what the per instruction set entry points return
+	template<class S, int Dims = 2>
+	PointsFnOf<Dims> resolve(const Params &params) {
+		return NoiseHash::dispatch(params.hash, [&]<class H>() { return Kernels<S, H>::template resolve<Dims>(params); });
+	}
+}
@@ -0,0 +1,84 @@
+#include "noise_simd.h"
+
+// AArch64 only, the kernels rely on vdivq_f32 and the round-toward-minus-infinity conversions of ARMv8.
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+#include "noise_kernels.h"
+
+namespace {
+
+	struct Neon {
+		static constexpr int Width = 4;
+		using F = float32x4_t;
+		using I = int32x4_t;
+
+		static F splat(float v) { return vdupq_n_f32(v); }
+		static I splatI(int32_t v) { return vdupq_n_s32(v); }
+		static F load(const float *p) { return vld1q_f32(p); }
+		static void store(float *p, F v) { vst1q_f32(p, v); }
+
+		static F add(F a, F b) { return vaddq_f32(a, b); }
+		static F sub(F a, F b) { return vsubq_f32(a, b); }
+		static F mul(F a, F b) { return vmulq_f32(a, b); }
+		static F div(F a, F b) { return vdivq_f32(a, b); }
+		static F min(F a, F b) { return vminq_f32(a, b); }
+		static F max(F a, F b) { return vmaxq_f32(a, b); }
+		static F sqrt(F a) { return vsqrtq_f32(a); }
+		static F abs(F a) { return vabsq_f32(a); }
+
+		static I add(I a, I b) { return vaddq_s32(a, b); }
+		static I mul(I a, I b) { return vmulq_s32(a, b); }
+		static I bitAnd(I a, I b) { return vandq_s32(a, b); }
+		static I bitXor(I a, I b) { return veorq_s32(a, b); }
+
+		static F bitXor(F a, F b) { return vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(a), vreinterpretq_s32_f32(b))); }
+		template<int N> static I shiftLeft(I a) { return vshlq_n_s32(a, N); }
+		template<int N> static I shiftRight(I a) { return vshrq_n_s32(a, N); }
+		template<int N> static I shiftRightLogical(I a) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), N)); }
+
+		static I equal(I a, I b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+		static I greaterThan(F a, F b) { return vreinterpretq_s32_u32(vcgtq_f32(a, b)); }
+		static F select(I mask, F a, F b) { return vbslq_f32(vreinterpretq_u32_s32(mask), a, b); }
+
+		static F castToFloat(I a) { return vreinterpretq_f32_s32(a); }
+		static F toFloat(I a) { return vcvtq_f32_s32(a); }
+
+		// No gather on NEON, look the lanes up one by one
+		static I gather(const int32_t *table, I index) {
+			int32_t lanes[4];
+			vst1q_s32(lanes, index);
+			int32_t values[4] = {table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]};
+			return vld1q_s32(values);
+		}
+
+		static F gatherF(const float *table, I index) {
+			int32_t lanes[4];
+			vst1q_s32(lanes, index);
+			float values[4] = {table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]};
+			return vld1q_f32(values);
+		}
+		static F floor(F a) { return vrndmq_f32(a); }
+		static I floorToInt(F a) { return vcvtmq_s32_f32(a); }
+	};
+}
+
+NoiseSimd::PointsFn NoiseSimd::neonPoints(const Params &params) {
+	return resolve<Neon>(params);
+}
+
+NoiseSimd::Points3Fn NoiseSimd::neonPoints3(const Params &params) {
+	return resolve<Neon, 3>(params);
+}
+
+#else
+
+NoiseSimd::PointsFn NoiseSimd::neonPoints(const Params &) {
+	return nullptr;
+}
+
+NoiseSimd::Points3Fn NoiseSimd::neonPoints3(const Params &) {
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "noise_simd.h"
+#include "noise_kernels.h"
+#include "noise.h"
+
+#include <bit>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static_assert(NoiseSimd::FunctionValue == int(Noise::Function::Value) && NoiseSimd::FunctionCellular == int(Noise::Function::Cellular));
+static_assert(NoiseSimd::InterpolationLinear == int(Noise::Interpolation::Linear) && NoiseSimd::InterpolationSmootherstep == int(Noise::Interpolation::Smootherstep));
+static_assert(NoiseSimd::FractalNone == int(Noise::Fractal::None) && NoiseSimd::FractalDomainWarp == int(Noise::Fractal::DomainWarp));
+static_assert(NoiseSimd::CellularEuclidean == int(Noise::CellularDistance::Euclidean) && NoiseSimd::CellularManhattan == int(Noise::CellularDistance::Manhattan));
+static_assert(NoiseSimd::CellularF1 == int(Noise::CellularReturn::F1) && NoiseSimd::CellularF2MinusF1 == int(Noise::CellularReturn::F2MinusF1));
+static_assert(NoiseSimd::HashPrimeXor == int(Noise::Hash::PrimeXor) && NoiseSimd::HashPermutation == int(Noise::Hash::Permutation));
+static_assert(NoiseSimd::PrimeX == Noise::PrimeX && NoiseSimd::PrimeY == Noise::PrimeY);
+static_assert(NoiseSimd::PrimeZ == Noise::PrimeZ && NoiseSimd::PrimeW == Noise::PrimeW);
+static_assert(NoiseSimd::PerlinScale == Noise::PerlinScale && NoiseSimd::SimplexScale == Noise::SimplexScale);
+static_assert(NoiseSimd::SimplexF2 == Noise::SimplexF2 && NoiseSimd::SimplexG2 == Noise::SimplexG2);
+static_assert(NoiseSimd::PerlinScale3 == Noise::PerlinScale3 && NoiseSimd::SimplexScale3 == Noise::SimplexScale3);
+static_assert(NoiseSimd::SimplexF3 == Noise::SimplexF3 && NoiseSimd::SimplexG3 == Noise::SimplexG3);
+static_assert(NoiseSimd::WarpOffsetX == Noise::WarpOffsetX && NoiseSimd::WarpOffsetY == Noise::WarpOffsetY && NoiseSimd::WarpOffsetZ == Noise::WarpOffsetZ);
+static_assert(NoiseSimd::CellularMaxDistance == Noise::CellularMaxDistance && NoiseSimd::CellularScale == Noise::CellularScale);
+
+namespace {
+
+	// One lane fallback used when no vector instruction set is available.
+	// Integers are unsigned so the hash multiplications wrap instead of overflowing.
+	struct Scalar {
+		static constexpr int Width = 1;
+		using F = float;
+		using I = uint32_t;
+
+		static F splat(float v) { return v; }
+		static I splatI(int32_t v) { return static_cast<uint32_t>(v); }
+		static F load(const float *p) { return *p; }
+		static void store(float *p, F v) { *p = v; }
+
+		static F add(F a, F b) { return a + b; }
+		static F sub(F a, F b) { return a - b; }
+		static F mul(F a, F b) { return a * b; }
+		static F div(F a, F b) { return a / b; }
+		static F min(F a, F b) { return b < a ? b : a; }
+		static F max(F a, F b) { return a < b ? b : a; }
+		static F sqrt(F a) { return std::sqrt(a); }
+		static F abs(F a) { return std::fabs(a); }
+
+		static I add(I a, I b) { return a + b; }
+		static I mul(I a, I b) { return a * b; }
+		static I bitAnd(I a, I b) { return a & b; }
+		static I bitXor(I a, I b) { return a ^ b; }
+
+		static F bitXor(F a, F b) { return std::bit_cast<float>(std::bit_cast<uint32_t>(a) ^ std::bit_cast<uint32_t>(b)); }
+		template<int N> static I shiftLeft(I a) { return a << N; }
+		template<int N> static I shiftRight(I a) { return static_cast<uint32_t>(static_cast<int32_t>(a) >> N); }
+		template<int N> static I shiftRightLogical(I a) { return a >> N; }
+
+		static I equal(I a, I b) { return a == b ? ~0u : 0u; }
+		static I greaterThan(F a, F b) { return a > b ? ~0u : 0u; }
+		static F select(I mask, F a, F b) { return mask ? a : b; }
+
+		static F castToFloat(I a) { return std::bit_cast<float>(a); }
+		static F toFloat(I a) { return static_cast<float>(static_cast<int32_t>(a)); }
+
+		static I gather(const int32_t *table, I index) { return static_cast<uint32_t>(table[index]); }
+		static F gatherF(const float *table, I index) { return table[index]; }
+		static F floor(F a) { return std::floor(a); }
+		static I floorToInt(F a) { return static_cast<uint32_t>(static_cast<int32_t>(std::floor(a))); }
+	};
+
+	bool cpuHasAvx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) { // OS must save the ymm registers
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+}
+
+NoiseSimd::PointsFn NoiseSimd::scalarPoints(const Params &params) {
+	return resolve<Scalar>(params);
+}
+
+NoiseSimd::Points3Fn NoiseSimd::scalarPoints3(const Params &params) {
+	return resolve<Scalar, 3>(params);
+}
+
+NoiseSimd::Level NoiseSimd::detectLevel() {
+	Params params;
+	if (avx2Points(params) && cpuHasAvx2()) {
+		return Level::Avx2;
+	}
+	if (sse2Points(params)) {
+		return Level::Sse2;
+	}
+	if (neonPoints(params)) {
+		return Level::Neon;
+	}
+	return Level::Scalar;
+}
+
+const char *NoiseSimd::levelName(Level level) {
+	switch (level) {
+		case Level::Sse2:
+			return "SSE2";
+		case Level::Avx2:
+			return "AVX2";
+		case Level::Neon:
+			return "NEON";
+		default:
+			return "Scalar";
+	}
+}
+
+NoiseSimd::PointsFn NoiseSimd::pointsFn(Level level, const Params &params) {
+	PointsFn fn = nullptr;
+	switch (level) {
+		case Level::Avx2:
+			fn = avx2Points(params);
+			if (fn) break;
+			[[fallthrough]];
+		case Level::Sse2:
+			fn = sse2Points(params);
+			break;
+		case Level::Neon:
+			fn = neonPoints(params);
+			break;
+		default:
+			break;
+	}
+	return fn ? fn : scalarPoints(params);
+}
+
+NoiseSimd::Points3Fn NoiseSimd::points3Fn(Level level, const Params &params) {
+	Points3Fn fn = nullptr;
+	switch (level) {
+		case Level::Avx2:
+			fn = avx2Points3(params);
+			if (fn) break;
+			[[fallthrough]];
+		case Level::Sse2:
+			fn = sse2Points3(params);
+			break;
+		case Level::Neon:
+			fn = neonPoints3(params);
+			break;
+		default:
+			break;
+	}
+	return fn ? fn : scalarPoints3(params);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Batch (SIMD) evaluation backend for Noise.
+ *
+ * This header is deliberately free of glm and noise.h so that the per instruction set translation units
+ * (noise_sse2.cpp, noise_avx2.cpp, noise_neon.cpp) can be compiled with their own target flags without
+ * pulling shared inline code into them.
+ */
+namespace NoiseHash {
+	struct PermutationTable;
+}
+
+namespace NoiseSimd {
+
+	// Mirrors of the Noise enums and hash constants. Checked against noise.h in noise_simd.cpp.
+	enum Function : int32_t {
+		FunctionValue,
+		FunctionValueCubic,
+		FunctionSimplex,
+		FunctionPerlin,
+		FunctionCellular
+	};
+
+	enum Interpolation : int32_t {
+		InterpolationLinear,
+		InterpolationCosine,
+		InterpolationSmoothstep,
+		InterpolationSmootherstep
+	};
+
+	enum Fractal : int32_t {
+		FractalNone,
+		FractalFBM,
+		FractalRidged,
+		FractalTurbulence,
+		FractalDomainWarp
+	};
+
+	enum CellularDistance : int32_t {
+		CellularEuclidean,
+		CellularEuclideanSquared,
+		CellularManhattan
+	};
+
+	enum CellularReturn : int32_t {
+		CellularF1,
+		CellularF2,
+		CellularF2MinusF1
+	};
+
+	// Lattice hash policy, see noise_hash.h
+	enum Hash : int32_t {
+		HashPrimeXor,
+		HashPcg,
+		HashXxHash,
+		HashShiftAdd,
+		HashPermutation
+	};
+
+	constexpr int32_t PrimeX = 501125321;
+	constexpr int32_t PrimeY = 1136930381;
+	constexpr int32_t PrimeZ = 1720413743;
+	constexpr int32_t PrimeW = 0x27d4eb2d;
+
+	constexpr float PerlinScale = 1.25f;
+	constexpr float SimplexScale = 85.0f;
+	constexpr float SimplexF2 = 0.36602540378f;
+	constexpr float SimplexG2 = 0.21132486540f;
+	constexpr float PerlinScale3 = 1.0f;
+	constexpr float SimplexScale3 = 76.0f;
+	constexpr float SimplexF3 = 1.0f / 3.0f;
+	constexpr float SimplexG3 = 1.0f / 6.0f;
+	constexpr float CellularMaxDistance = 1e10f;
+	constexpr float CellularScale = 0.75f;
+	constexpr float WarpOffsetX = 5.2f;
+	constexpr float WarpOffsetY = 1.3f;
+	constexpr float WarpOffsetZ = 3.7f;
+
+	// Flattened copy of Noise::Descriptor handed to the kernels
+	struct Params {
+		int32_t function = FunctionValue;
+		int32_t interpolation = InterpolationLinear;
+		int32_t fractal = FractalNone;
+		int32_t seed = 0;
+		float frequency = 1.0f;
+		float lacunarity = 2.0f;
+		float weightedStrength = 0.0f;
+		float gain = 0.5f;
+		int32_t octaves = 3;
+		float amplitude = 1.0f;
+		int32_t cellularDistance = CellularEuclidean;
+		int32_t cellularReturn = CellularF1;
+		float warpFrequency = 0.5f;
+		float warpAmplitude = 8.0f;
+		int32_t hash = HashPrimeXor;
+		const NoiseHash::PermutationTable *table = nullptr; // Seeded tables of HashPermutation
+	};
+
+	// Evaluates count points: out[i] = Noise::eval({xs[i], ys[i]})
+	using PointsFn = void (*)(const Params &params, const float *xs, const float *ys, float *out, size_t count);
+
+	// Evaluates count 3D points: out[i] = Noise::eval({xs[i], ys[i], zs[i]})
+	using Points3Fn = void (*)(const Params &params, const float *xs, const float *ys, const float *zs, float *out, size_t count);
+
+	enum class Level {
+		Scalar,
+		Sse2,
+		Avx2,
+		Neon
+	};
+
+	// Best instruction set supported by both the build and the running CPU
+	Level detectLevel();
+
+	const char *levelName(Level level);
+
+	// Kernel specialized for params at the given level, falling back to the next best level if it was not compiled in.
+	// Only function, interpolation, fractal, the cellular variant and the hash select the kernel, the remaining params are read at evaluation time.
+	PointsFn pointsFn(Level level, const Params &params);
+	Points3Fn points3Fn(Level level, const Params &params);
+
+	// Per instruction set entry points. Return nullptr when the instruction set is not available in this build.
+	PointsFn scalarPoints(const Params &params);
+	PointsFn sse2Points(const Params &params);
+	PointsFn avx2Points(const Params &params);
+	PointsFn neonPoints(const Params &params);
+	Points3Fn scalarPoints3(const Params &params);
+	Points3Fn sse2Points3(const Params &params);
+	Points3Fn avx2Points3(const Params &params);
+	Points3Fn neonPoints3(const Params &params);
+}
@@ -0,0 +1,97 @@
+#include "noise_simd.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+#include "noise_kernels.h"
+
+namespace {
+
+	struct Sse2 {
+		static constexpr int Width = 4;
+		using F = __m128;
+		using I = __m128i;
+
+		static F splat(float v) { return _mm_set1_ps(v); }
+		static I splatI(int32_t v) { return _mm_set1_epi32(v); }
+		static F load(const float *p) { return _mm_loadu_ps(p); }
+		static void store(float *p, F v) { _mm_storeu_ps(p, v); }
+
+		static F add(F a, F b) { return _mm_add_ps(a, b); }
+		static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+		static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+		static F div(F a, F b) { return _mm_div_ps(a, b); }
+		static F min(F a, F b) { return _mm_min_ps(a, b); }
+		static F max(F a, F b) { return _mm_max_ps(a, b); }
+		static F sqrt(F a) { return _mm_sqrt_ps(a); }
+		static F abs(F a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); }
+
+		static I add(I a, I b) { return _mm_add_epi32(a, b); }
+		static I bitAnd(I a, I b) { return _mm_and_si128(a, b); }
+		static I bitXor(I a, I b) { return _mm_xor_si128(a, b); }
+
+		// SSE2 has no 32-bit mullo, multiply even and odd lanes as 64-bit and keep the low halves
+		static I mul(I a, I b) {
+			I even = _mm_mul_epu32(a, b);
+			I odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+									  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+		static F bitXor(F a, F b) { return _mm_xor_ps(a, b); }
+		template<int N> static I shiftLeft(I a) { return _mm_slli_epi32(a, N); }
+		template<int N> static I shiftRight(I a) { return _mm_srai_epi32(a, N); }
+		template<int N> static I shiftRightLogical(I a) { return _mm_srli_epi32(a, N); }
+
+		static I equal(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+		static I greaterThan(F a, F b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+		static F select(I mask, F a, F b) {
+			F m = _mm_castsi128_ps(mask);
+			return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+		}
+
+		static F castToFloat(I a) { return _mm_castsi128_ps(a); }
+		static F toFloat(I a) { return _mm_cvtepi32_ps(a); }
+
+		// No gather before AVX2, look the lanes up one by one
+		static I gather(const int32_t *table, I index) {
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<I *>(lanes), index);
+			return _mm_setr_epi32(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+		}
+
+		static F gatherF(const float *table, I index) {
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<I *>(lanes), index);
+			return _mm_setr_ps(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+		}
+
+		// SSE2 has no floor, truncate and step down where truncation rounded up (negative values)
+		static I floorToInt(F a) {
+			I t = _mm_cvttps_epi32(a);
+			return _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), a)));
+		}
+
+		static F floor(F a) { return _mm_cvtepi32_ps(floorToInt(a)); }
+	};
+}
+
+NoiseSimd::PointsFn NoiseSimd::sse2Points(const Params &params) {
+	return resolve<Sse2>(params);
+}
+
+NoiseSimd::Points3Fn NoiseSimd::sse2Points3(const Params &params) {
+	return resolve<Sse2, 3>(params);
+}
+
+#else
+
+NoiseSimd::PointsFn NoiseSimd::sse2Points(const Params &) {
+	return nullptr;
+}
+
+NoiseSimd::Points3Fn NoiseSimd::sse2Points3(const Params &) {
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+
+	// Worker count for a requested count, 0 or less picks the hardware concurrency
+	inline int threadCount(int threads) {
+		if (threads > 0) {
+			return threads;
+		}
+		return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	}
+
+	// Runs fn(i, worker) for every i in [0, count), handing indices out to the workers as they finish the previous one.
+	// The calling thread is worker 0.
+	template<class Fn>
+	void parallelFor(int count, int threads, Fn fn) {
+		threads = std::min(threads, count);
+		if (threads <= 1) {
+			for (int i = 0; i < count; i++) fn(i, 0);
+			return;
+		}
+
+		std::atomic<int> next = 0;
+		auto work = [&](int worker) {
+			for (int i = next++; i < count; i = next++) fn(i, worker);
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (int worker = 1; worker < threads; worker++) {
+			pool.emplace_back(work, worker);
+		}
+		work(0);
+		for (std::thread &thread : pool) {
+			thread.join();
+		}
+	}
+}
@@ -0,0 +1,264 @@
+#include "spectral.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+	using Parallel::parallelFor;
+	using Parallel::threadCount;
+
+	using Complex = std::complex<float>;
+
+	// Plain complex product, std::complex's operator* goes through a library call to handle infinities
+	Complex mul(Complex a, Complex b) {
+		return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+	}
+
+	bool isPowerOfTwo(int n) {
+		return n > 0 && (n & (n - 1)) == 0;
+	}
+
+	void checkLength(int n) {
+		if (!isPowerOfTwo(n)) {
+			throw std::runtime_error("SpectralNoise: FFT length " + std::to_string(n) + " is not a power of two");
+		}
+	}
+
+	// Twiddle factors of one transform length and the Stockham stages using them
+	class FFTPlan {
+	public:
+
+		explicit FFTPlan(int n) : n(n), twiddles(n) {
+			checkLength(n);
+			for (int k = 0; k < n; k++) {
+				double angle = -2.0 * std::numbers::pi * k / n;
+				twiddles[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+			}
+		}
+
+		// Transforms n values in place, ping-ponging the stages through scratch of the same length.
+		// The inverse is the forward transform of the conjugate, conjugated back.
+		void transform(Complex *data, Complex *scratch, bool inverse) const {
+			if (inverse) {
+				for (int k = 0; k < n; k++) data[k] = std::conj(data[k]);
+			}
+
+			Complex *x = data;
+			Complex *y = scratch;
+			int length = n;
+			int stride = 1;
+			for (; length >= 4; length /= 4, stride *= 4) {
+				radix4(x, y, length, stride);
+				std::swap(x, y);
+			}
+			if (length == 2) {
+				radix2(x, y, stride);
+				std::swap(x, y);
+			}
+			if (x != data) {
+				std::copy(x, x + n, data);
+			}
+
+			if (inverse) {
+				for (int k = 0; k < n; k++) data[k] = std::conj(data[k]);
+			}
+		}
+
+	private:
+
+		int n;
+		std::vector<Complex> twiddles; // exp(-2 pi i k / n)
+
+		// One radix-4 stage over sub-transforms of the given length, interleaved stride apart
+		void radix4(const Complex *x, Complex *y, int length, int stride) const {
+			int quarter = length / 4;
+			for (int p = 0; p < quarter; p++) {
+				Complex w1 = twiddles[p * stride];
+				Complex w2 = twiddles[2 * p * stride];
+				Complex w3 = twiddles[3 * p * stride];
+
+				const Complex *a = x + stride * p;
+				const Complex *b = a + stride * quarter;
+				const Complex *c = b + stride * quarter;
+				const Complex *d = c + stride * quarter;
+				Complex *out = y + stride * 4 * p;
+
+				for (int q = 0; q < stride; q++) {
+					Complex apc = a[q] + c[q];
+					Complex amc = a[q] - c[q];
+					Complex bpd = b[q] + d[q];
+					Complex bmd = b[q] - d[q];
+					Complex jbmd(-bmd.imag(), bmd.real());
+
+					out[q] = apc + bpd;
+					out[q + stride] = mul(w1, amc - jbmd);
+					out[q + stride * 2] = mul(w2, apc - bpd);
+					out[q + stride * 3] = mul(w3, amc + jbmd);
+				}
+			}
+		}
+
+		// Final radix-2 stage for odd powers of two, where every twiddle is 1
+		static void radix2(const Complex *x, Complex *y, int stride) {
+			for (int q = 0; q < stride; q++) {
+				y[q] = x[q] + x[q + stride];
+				y[q + stride] = x[q] - x[q + stride];
+			}
+		}
+	};
+
+	// Transposes a row major size^2 grid in place, one row of 32x32 blocks per task so both blocks of a swap stay cached
+	void transpose(Complex *data, int size, int threads) {
+		constexpr int Block = 32;
+		int blocks = (size + Block - 1) / Block;
+
+		parallelFor(blocks, threads, [&](int blockRow, int) {
+			int rowBegin = blockRow * Block;
+			int rowEnd = std::min(rowBegin + Block, size);
+			for (int blockCol = blockRow; blockCol < blocks; blockCol++) {
+				int colBegin = blockCol * Block;
+				int colEnd = std::min(colBegin + Block, size);
+				for (int row = rowBegin; row < rowEnd; row++) {
+					// On the diagonal block only the upper triangle swaps
+					for (int col = std::max(colBegin, blockCol == blockRow ? row + 1 : colBegin); col < colEnd; col++) {
+						std::swap(data[static_cast<size_t>(row) * size + col], data[static_cast<size_t>(col) * size + row]);
+					}
+				}
+			}
+		});
+	}
+
+	// Integer finalizer (lowbias32). The lattice hash of Noise is too structured for a white spectrum.
+	uint32_t mix(uint32_t h) {
+		h ^= h >> 16;
+		h *= 0x7feb352du;
+		h ^= h >> 15;
+		h *= 0x846ca68bu;
+		h ^= h >> 16;
+		return h;
+	}
+
+	// Uniform in (0, 1] for one frequency bin, stream picking independent values of the same bin
+	float uniform(int seed, int u, int v, uint32_t stream) {
+		uint32_t h = mix(static_cast<uint32_t>(seed) ^ mix(static_cast<uint32_t>(u) ^ mix(static_cast<uint32_t>(v) * 2u + stream)));
+		return (static_cast<float>(h >> 8) + 1.0f) * (1.0f / 16777216.0f);
+	}
+
+	// Signed frequency of bin k in cycles per sample, bins above size / 2 are the negative frequencies
+	float binFrequency(int k, int size) {
+		return static_cast<float>(k <= size / 2 ? k : k - size) / static_cast<float>(size);
+	}
+}
+
+
+// Generation
+// ----------------------------
+
+std::vector<float> SpectralNoise::generate() const {
+	checkLength(desc.size);
+	std::vector<float> out(static_cast<size_t>(desc.size) * desc.size);
+	generate(out);
+	return out;
+}
+
+void SpectralNoise::generate(std::span<float> out) const {
+	int size = desc.size;
+	checkLength(size);
+	size_t count = static_cast<size_t>(size) * size;
+	if (out.size() < count) {
+		throw std::runtime_error("SpectralNoise: output holds " + std::to_string(out.size()) + " samples, the map needs " + std::to_string(count));
+	}
+	int threads = threadCount(desc.threads);
+
+	// Band of kept frequencies in cycles per sample
+	float maxWavelength = desc.maxWavelength > 0.0f ? desc.maxWavelength : static_cast<float>(size);
+	float lowest = 1.0f / maxWavelength;
+	float highest = 1.0f / std::max(desc.minWavelength, 2.0f);
+
+	// Complex white noise per bin, scaled to an amplitude of f^(-beta / 2) for a power of f^-beta. Each bin only
+	// hashes its own coordinates, so the map doesn't depend on how rows are split over the threads.
+	std::vector<Complex> spectrum(count);
+	float exponent = -0.25f * desc.spectralExponent; // Applied to f^2
+	parallelFor(size, threads, [&](int v, int) {
+		float fy = binFrequency(v, size);
+		Complex *row = spectrum.data() + static_cast<size_t>(v) * size;
+		for (int u = 0; u < size; u++) {
+			float fx = binFrequency(u, size);
+			float f2 = fx * fx + fy * fy;
+			if (f2 < lowest * lowest || f2 > highest * highest) {
+				row[u] = 0.0f;
+				continue;
+			}
+
+			// Box-Muller, a gaussian magnitude with a uniform phase
+			float magnitude = std::sqrt(-2.0f * std::log(uniform(desc.seed, u, v, 0))) * std::pow(f2, exponent);
+			float phase = 2.0f * std::numbers::pi_v<float> * uniform(desc.seed, u, v, 1);
+			row[u] = Complex(magnitude * std::cos(phase), magnitude * std::sin(phase));
+		}
+	});
+
+	fft2D(spectrum, size, true, threads);
+
+	// The real part is a gaussian field with the same spectrum, rescaled to [0, amplitude] from its range
+	std::vector<float> rowMin(size);
+	std::vector<float> rowMax(size);
+	parallelFor(size, threads, [&](int row, int) {
+		size_t begin = static_cast<size_t>(row) * size;
+		float lo = spectrum[begin].real();
+		float hi = lo;
+		for (size_t k = begin; k < begin + size; k++) {
+			out[k] = spectrum[k].real();
+			lo = std::min(lo, out[k]);
+			hi = std::max(hi, out[k]);
+		}
+		rowMin[row] = lo;
+		rowMax[row] = hi;
+	});
+
+	float lo = *std::min_element(rowMin.begin(), rowMin.end());
+	float hi = *std::max_element(rowMax.begin(), rowMax.end());
+	float scale = hi > lo ? desc.amplitude / (hi - lo) : 0.0f;
+	parallelFor(size, threads, [&](int row, int) {
+		size_t begin = static_cast<size_t>(row) * size;
+		for (size_t k = begin; k < begin + size; k++) {
+			out[k] = (out[k] - lo) * scale;
+		}
+	});
+}
+
+
+// Transforms
+// ----------------------------
+
+void SpectralNoise::fft(std::span<std::complex<float>> data, bool inverse) {
+	int n = static_cast<int>(data.size());
+	FFTPlan plan(n);
+	std::vector<Complex> scratch(n);
+	plan.transform(data.data(), scratch.data(), inverse);
+}
+
+void SpectralNoise::fft2D(std::span<std::complex<float>> data, int size, bool inverse, int threads) {
+	FFTPlan plan(size);
+	size_t count = static_cast<size_t>(size) * size;
+	if (data.size() < count) {
+		throw std::runtime_error("SpectralNoise: 2D FFT data holds " + std::to_string(data.size()) + " values, a size " + std::to_string(size) + " grid needs " + std::to_string(count));
+	}
+	threads = std::min(threadCount(threads), size);
+
+	std::vector<std::vector<Complex>> scratch(threads, std::vector<Complex>(size));
+	auto transformRow = [&](int row, int worker) {
+		plan.transform(data.data() + static_cast<size_t>(row) * size, scratch[worker].data(), inverse);
+	};
+
+	// Rows, then the columns as rows of the transposed grid
+	parallelFor(size, threads, transformRow);
+	transpose(data.data(), size, threads);
+	parallelFor(size, threads, transformRow);
+	transpose(data.data(), size, threads);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <complex>
+#include <span>
+#include <vector>
+
+/*
+ * Spectral synthesis of large tileable height maps.
+ *
+ * White noise is shaped in the frequency domain by a 1/f^beta power spectrum and brought back with an inverse FFT,
+ * so the cost is O(N log N) in the sample count however many octaves of detail the spectrum covers. Per sample FBM
+ * is O(N * octaves) with the hashing and interpolation of every octave, which dominates for 8k-16k base maps.
+ *
+ * The FFT is a Stockham autosort transform, radix-4 stages with a final radix-2 stage for odd powers of two, with no
+ * bit reversal pass. Rows are transformed in parallel, columns through a blocked in place transpose and the same row
+ * transforms, so every pass streams through contiguous memory.
+ *
+ * The map wraps around its edges, it holds one period of the spectrum. A size^2 map needs size^2 complex floats of
+ * working memory on top of the output, 2GB at 16k.
+ */
+class SpectralNoise {
+public:
+
+	static constexpr int DefaultSeed = 0;
+	static constexpr int DefaultSize = 1024;
+	static constexpr float DefaultSpectralExponent = 3.0f; // H = 0.5, FBM with a gain of about 0.707 at a lacunarity of 2 (a gain of 0.5 is 4)
+	static constexpr float DefaultAmplitude = 1.0f;
+	static constexpr float DefaultMinWavelength = 2.0f;
+	static constexpr float DefaultMaxWavelength = 0.0f;
+	static constexpr int DefaultThreads = 0;
+
+	struct Descriptor {
+		int seed = DefaultSeed;
+		int size = DefaultSize; // Samples per side, a power of two
+		float spectralExponent = DefaultSpectralExponent; // beta of the radial power spectrum, 2H + 2 for a Hurst exponent H
+		float amplitude = DefaultAmplitude;
+		float minWavelength = DefaultMinWavelength; // Shortest kept wavelength in samples, 2 keeps up to Nyquist
+		float maxWavelength = DefaultMaxWavelength; // Longest kept wavelength in samples, 0 for the map size
+		int threads = DefaultThreads; // 0 for one per hardware thread
+
+		bool operator==(const Descriptor &) const = default;
+	};
+
+	Descriptor desc;
+
+	SpectralNoise() = default;
+
+	explicit SpectralNoise(Descriptor descriptor) : desc(descriptor) {}
+
+	/**
+	 * Generates the size^2 map of heights, row major, rescaled to [0, amplitude] like Noise.
+	 * The same descriptor gives the same map whatever the thread count.
+	 * Throws std::runtime_error unless size is a power of two.
+	 */
+	std::vector<float> generate() const;
+	void generate(std::span<float> out) const;
+
+
+	// Transforms
+	// ----------------------------
+
+	/**
+	 * In place discrete Fourier transform, exp(-2 pi i jk / n) forward and exp(+2 pi i jk / n) inverse, unnormalized.
+	 * Throws std::runtime_error unless the length is a power of two.
+	 */
+	static void fft(std::span<std::complex<float>> data, bool inverse = false);
+
+	// In place 2D transform of a row major size^2 grid, with the rows and columns split over the given threads
+	static void fft2D(std::span<std::complex<float>> data, int size, bool inverse = false, int threads = DefaultThreads);
+
+};
@@ -0,0 +1,252 @@
+#include "noise_compute.h"
+
+#include "application.h"
+#include "shader.h"
+#include "terrain.h"
+
+NoiseCompute::NoiseCompute() {
+	wgpu::Device &device = *Application::device;
+
+	shaderModule = Shader::loadShaderModule(device, RESOURCE_DIR "/shaders/noise_chunk.wgsl");
+
+	// Both entry points share one layout, heights_main doesn't touch the vertices
+	std::vector<wgpu::BindGroupLayoutEntry> entries(3, wgpu::Default);
+	entries[0].binding = 0;
+	entries[0].visibility = wgpu::ShaderStage::Compute;
+	entries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+	entries[0].buffer.minBindingSize = sizeof(Params);
+
+	entries[1].binding = 1;
+	entries[1].visibility = wgpu::ShaderStage::Compute;
+	entries[1].buffer.type = wgpu::BufferBindingType::Storage;
+
+	entries[2].binding = 2;
+	entries[2].visibility = wgpu::ShaderStage::Compute;
+	entries[2].buffer.type = wgpu::BufferBindingType::Storage;
+
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = entries.size();
+	bindGroupLayoutDesc.entries = entries.data();
+	bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor layoutDesc{};
+	layoutDesc.label = "Noise Compute Layout";
+	layoutDesc.bindGroupLayoutCount = 1;
+	layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+	pipelineLayout = device.createPipelineLayout(layoutDesc);
+
+	wgpu::ComputePipelineDescriptor pipelineDesc{};
+	pipelineDesc.layout = pipelineLayout;
+	pipelineDesc.compute.module = shaderModule;
+	pipelineDesc.compute.constantCount = 0;
+	pipelineDesc.compute.constants = nullptr;
+
+	pipelineDesc.compute.entryPoint = "heights_main";
+	heightsPipeline = device.createComputePipeline(pipelineDesc);
+	pipelineDesc.compute.entryPoint = "vertices_main";
+	verticesPipeline = device.createComputePipeline(pipelineDesc);
+	pipelineDesc.compute.entryPoint = "compact_vertices_main";
+	compactVerticesPipeline = device.createComputePipeline(pipelineDesc);
+	if (!heightsPipeline || !verticesPipeline || !compactVerticesPipeline) {
+		throw std::runtime_error("Could not create noise compute pipelines!");
+	}
+
+	wgpu::BufferDescriptor paramsDesc{};
+	paramsDesc.size = sizeof(Params);
+	paramsDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+	paramsDesc.mappedAtCreation = false;
+	paramsBuffer = device.createBuffer(paramsDesc);
+}
+
+NoiseCompute::~NoiseCompute() {
+	for (auto &readback : readbacks) {
+		readback->buffer.destroy();
+		readback->buffer.release();
+	}
+	if (heightsBuffer) {
+		heightsBuffer.destroy();
+		heightsBuffer.release();
+	}
+	paramsBuffer.destroy();
+	paramsBuffer.release();
+	heightsPipeline.release();
+	verticesPipeline.release();
+	compactVerticesPipeline.release();
+	pipelineLayout.release();
+	bindGroupLayout.release();
+	shaderModule.release();
+}
+
+bool NoiseCompute::supports(const Noise::Descriptor &desc) {
+	bool function = desc.function == Noise::Function::Value || desc.function == Noise::Function::ValueCubic;
+	bool fractal = desc.fractal == Noise::Fractal::None || desc.fractal == Noise::Fractal::FBM;
+	return function && fractal && desc.hash != Noise::Hash::Permutation;
+}
+
+NoiseCompute::Params NoiseCompute::makeParams(const Noise &noise, glm::vec2 gridOrigin, int borderedSize) {
+	const Noise::Descriptor &desc = noise.desc;
+	glm::vec2 detailLine = noise.octaveDetailLine();
+
+	Params params{};
+	params.origin = gridOrigin;
+	params.detailCenter = desc.detailCenter;
+	params.seed = static_cast<uint32_t>(desc.seed);
+	params.hash = desc.hash;
+	params.noiseFunction = desc.function;
+	params.interpolation = desc.interpolation;
+	params.fractal = desc.fractal;
+	params.octaves = static_cast<uint32_t>(glm::max(desc.octaves, 0));
+	params.frequency = desc.frequency;
+	params.lacunarity = desc.lacunarity;
+	params.gain = desc.gain;
+	params.weightedStrength = desc.weightedStrength;
+	params.amplitude = desc.amplitude;
+	params.firstAmplitude = Noise::lerp(0.4f, 1.0f, 1.0f / desc.octaves);
+	params.detailBase = detailLine.x;
+	params.detailSlope = detailLine.y;
+	params.cullsOctaves = noise.cullsOctaves();
+	params.borderedSize = static_cast<uint32_t>(borderedSize);
+	return params;
+}
+
+void NoiseCompute::reserveHeights(int borderedSize) {
+	uint64_t size = static_cast<uint64_t>(borderedSize) * borderedSize * sizeof(float);
+	if (size <= heightsSize) {
+		return;
+	}
+	if (heightsBuffer) {
+		heightsBuffer.destroy();
+		heightsBuffer.release();
+	}
+
+	wgpu::BufferDescriptor heightsDesc{};
+	heightsDesc.size = size;
+	heightsDesc.usage = wgpu::BufferUsage::Storage;
+	heightsDesc.mappedAtCreation = false;
+	heightsBuffer = Application::device->createBuffer(heightsDesc);
+	heightsSize = size;
+}
+
+void NoiseCompute::generate(const Noise &noise, Mesh &mesh, glm::vec2 gridOrigin) {
+	releaseFinishedReadbacks();
+
+	int borderedSize = mesh.meshSize + 2;
+	reserveHeights(borderedSize);
+
+	// Queue writes land before the next submit, so the chunks of a frame can share the params buffer
+	Params params = makeParams(noise, gridOrigin, borderedSize);
+	Application::queue->writeBuffer(paramsBuffer, 0, &params, sizeof(Params));
+
+	std::vector<wgpu::BindGroupEntry> bindings(3);
+	bindings[0].binding = 0;
+	bindings[0].buffer = paramsBuffer;
+	bindings[0].offset = 0;
+	bindings[0].size = sizeof(Params);
+
+	bindings[1].binding = 1;
+	bindings[1].buffer = heightsBuffer;
+	bindings[1].offset = 0;
+	bindings[1].size = heightsSize;
+
+	bindings[2].binding = 2;
+	bindings[2].buffer = mesh.vertexBuffer;
+	bindings[2].offset = 0;
+	bindings[2].size = mesh.vertexCount * mesh.vertexStride();
+
+	wgpu::BindGroupDescriptor bindGroupDesc{};
+	bindGroupDesc.layout = bindGroupLayout;
+	bindGroupDesc.entryCount = bindings.size();
+	bindGroupDesc.entries = bindings.data();
+	wgpu::BindGroup bindGroup = Application::device->createBindGroup(bindGroupDesc);
+
+	wgpu::CommandEncoderDescriptor encoderDesc{};
+	encoderDesc.label = "Noise Compute Encoder";
+	wgpu::CommandEncoder encoder = Application::device->createCommandEncoder(encoderDesc);
+
+	wgpu::ComputePassDescriptor passDesc{};
+	passDesc.label = "Noise Compute Pass";
+	wgpu::ComputePassEncoder pass = encoder.beginComputePass(passDesc);
+	pass.setBindGroup(0, bindGroup, 0, nullptr);
+
+	// The border first, the vertex normals read the neighbouring heights
+	uint32_t borderedGroups = (static_cast<uint32_t>(borderedSize) + WorkgroupSize - 1) / WorkgroupSize;
+	pass.setPipeline(heightsPipeline);
+	pass.dispatchWorkgroups(borderedGroups, borderedGroups, 1);
+
+	uint32_t meshGroups = (static_cast<uint32_t>(mesh.meshSize) + WorkgroupSize - 1) / WorkgroupSize;
+	pass.setPipeline(mesh.format == VertexFormat::Compact ? compactVerticesPipeline : verticesPipeline);
+	pass.dispatchWorkgroups(meshGroups, meshGroups, 1);
+	pass.end();
+
+	wgpu::CommandBufferDescriptor commandBufferDesc{};
+	commandBufferDesc.label = "Noise Compute Commands";
+	wgpu::CommandBuffer commands = encoder.finish(commandBufferDesc);
+	Application::queue->submit(commands);
+
+	commands.release();
+	pass.release();
+	encoder.release();
+	bindGroup.release();
+}
+
+void NoiseCompute::readHeights(const Mesh &mesh, std::function<void(std::vector<float>)> done) {
+	releaseFinishedReadbacks();
+
+	size_t count = mesh.vertexCount;
+	bool compact = mesh.format == VertexFormat::Compact;
+	uint64_t size = count * mesh.vertexStride();
+
+	Readback *readback = readbacks.emplace_back(std::make_unique<Readback>()).get();
+	wgpu::BufferDescriptor stagingDesc{};
+	stagingDesc.size = size;
+	stagingDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+	stagingDesc.mappedAtCreation = false;
+	readback->buffer = Application::device->createBuffer(stagingDesc);
+
+	wgpu::CommandEncoderDescriptor encoderDesc{};
+	encoderDesc.label = "Noise Readback Encoder";
+	wgpu::CommandEncoder encoder = Application::device->createCommandEncoder(encoderDesc);
+	encoder.copyBufferToBuffer(mesh.vertexBuffer, 0, readback->buffer, 0, size);
+	wgpu::CommandBufferDescriptor commandBufferDesc{};
+	wgpu::CommandBuffer commands = encoder.finish(commandBufferDesc);
+	Application::queue->submit(commands);
+	commands.release();
+	encoder.release();
+
+	// Whole vertices are copied, the heights are picked out of the positions once mapped
+	readback->callback = readback->buffer.mapAsync(wgpu::MapMode::Read, 0, size, [readback, count, size, compact, done](wgpu::BufferMapAsyncStatus status) {
+		std::vector<float> heights;
+		if (status == wgpu::BufferMapAsyncStatus::Success) {
+			const void *mapped = readback->buffer.getConstMappedRange(0, size);
+			heights.reserve(count);
+			for (size_t i = 0; i < count; i++) {
+				heights.push_back(compact ? static_cast<const CompactVertex *>(mapped)[i].unpackHeight() : static_cast<const Vertex *>(mapped)[i].position.y);
+			}
+			readback->buffer.unmap();
+		}
+		readback->finished = true;
+		done(std::move(heights));
+	});
+}
+
+float NoiseCompute::maxDifference(const Noise &noise, std::span<const float> heights, glm::vec2 gridOrigin, int meshSize) {
+	float difference = 0.0f;
+	for (int row = 0; row < meshSize; row++) {
+		for (int col = 0; col < meshSize; col++) {
+			float expected = noise.eval(gridOrigin + glm::vec2(float(col + 1), float(row + 1)));
+			difference = glm::max(difference, glm::abs(heights[row * meshSize + col] - expected));
+		}
+	}
+	return difference;
+}
+
+void NoiseCompute::releaseFinishedReadbacks() {
+	std::erase_if(readbacks, [](const std::unique_ptr<Readback> &readback) {
+		if (!readback->finished) {
+			return false;
+		}
+		readback->buffer.destroy();
+		readback->buffer.release();
+		return true;
+	});
+}
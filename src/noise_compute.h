@@ -0,0 +1,104 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <glm/glm.hpp>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+#include "noise/noise.h"
+
+class Mesh;
+
+/**
+ * Generates height field chunks on the GPU with the noise_chunk.wgsl compute pass: value and cubic noise, plain or
+ * FBM, under every hash but Permutation. The heights, normals and colors are written straight into the chunk's
+ * vertex buffer in the Vertex or CompactVertex layout of the mesh, the indices are Terrain's shared grid indices.
+ *
+ * The lattice hashes are integer exact and the float operations follow noise.h, so the heights match Noise::eval bit
+ * for bit as long as the shader compiler doesn't fuse multiply-adds. Octave culling goes through the GPU log2, the
+ * octaves it fades can differ by a few ulps. Normals and colors go through WGSL normalize and division and are close,
+ * not exact.
+ */
+class NoiseCompute {
+public:
+
+	// The NoiseParams uniforms of noise_chunk.wgsl
+	struct Params {
+		glm::vec2 origin; // World position of the first bordered sample
+		glm::vec2 detailCenter;
+		uint32_t seed;
+		uint32_t hash;
+		uint32_t noiseFunction;
+		uint32_t interpolation;
+		uint32_t fractal;
+		uint32_t octaves;
+		float frequency;
+		float lacunarity;
+		float gain;
+		float weightedStrength;
+		float amplitude;
+		float firstAmplitude; // WGSL divisions aren't correctly rounded, lerp(0.4, 1, 1 / octaves) is done here
+		float detailBase;
+		float detailSlope;
+		uint32_t cullsOctaves;
+		uint32_t borderedSize;
+	};
+	static_assert(sizeof(Params) == 80, "Params must match the WGSL struct layout");
+
+	static constexpr uint32_t WorkgroupSize = 8; // Per side, @workgroup_size of both entry points
+
+	NoiseCompute();
+	~NoiseCompute();
+
+	NoiseCompute(const NoiseCompute &) = delete;
+	NoiseCompute &operator=(const NoiseCompute &) = delete;
+
+	// True when the shader implements the noise of desc
+	static bool supports(const Noise::Descriptor &desc);
+
+	/**
+	 * Fills the vertex buffer of a GPU generated mesh, see Mesh(int meshSize), in one compute pass.
+	 * @param gridOrigin World position of the first sample of the bordered grid, one before the mesh corner
+	 */
+	void generate(const Noise &noise, Mesh &mesh, glm::vec2 gridOrigin);
+
+	/**
+	 * Copies the heights of a generated mesh back to the CPU for consumers such as collision. done gets the
+	 * row-major meshSize^2 heights once the copy is mapped, on a later device tick, or nothing when mapping fails.
+	 * Compact meshes only hold half float heights.
+	 */
+	void readHeights(const Mesh &mesh, std::function<void(std::vector<float>)> done);
+
+	// Largest difference between generated heights and Noise::eval at the same mesh samples, to check a backend
+	static float maxDifference(const Noise &noise, std::span<const float> heights, glm::vec2 gridOrigin, int meshSize);
+
+private:
+
+	// A staging buffer waiting to be mapped
+	struct Readback {
+		wgpu::Buffer buffer = nullptr;
+		std::unique_ptr<wgpu::BufferMapCallback> callback;
+		bool finished = false;
+	};
+
+	static Params makeParams(const Noise &noise, glm::vec2 gridOrigin, int borderedSize);
+
+	// Grows the bordered heights scratch buffer to hold borderedSize^2 samples
+	void reserveHeights(int borderedSize);
+
+	// Drops the readbacks whose callback already ran
+	void releaseFinishedReadbacks();
+
+	wgpu::ShaderModule shaderModule = nullptr;
+	wgpu::BindGroupLayout bindGroupLayout = nullptr;
+	wgpu::PipelineLayout pipelineLayout = nullptr;
+	wgpu::ComputePipeline heightsPipeline = nullptr;
+	wgpu::ComputePipeline verticesPipeline = nullptr;
+	wgpu::ComputePipeline compactVerticesPipeline = nullptr;
+	wgpu::Buffer paramsBuffer = nullptr;
+	wgpu::Buffer heightsBuffer = nullptr; // Shared by every chunk, only the vertex buffers outlive a pass
+	uint64_t heightsSize = 0;
+
+	std::vector<std::unique_ptr<Readback>> readbacks;
+};
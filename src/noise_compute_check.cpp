@@ -0,0 +1,211 @@
+#include "noise_compute.h"
+
+#include "application.h"
+#include "terrain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+/*
+ * Headless check of the noise_chunk.wgsl compute pass against Noise::eval, on the fallback (software) adapter so it
+ * runs without a GPU or a window.
+ *
+ * Every noise NoiseCompute supports is generated into a Vertex mesh, read back with readHeights and compared with
+ * maxDifference. The heights match eval bit for bit unless the shader compiler fuses multiply-adds or the GPU log2
+ * moves an octave's fade, both a few ulps per octave, so a height more than Tolerance * amplitude off fails the
+ * check and the exit code is 1. Compact meshes only read back half float heights and aren't checked.
+ *
+ * Usage: noise_compute_check [--mesh N] [--chunk X Y]
+ * --mesh is the vertices per side, chunk size + 1. --chunk is the chunk position, to check away from the origin.
+ */
+
+// The check runs NoiseCompute without the application, the device it creates takes the place of the app's
+std::unique_ptr<wgpu::Device> Application::device = nullptr;
+std::unique_ptr<wgpu::Queue> Application::queue = nullptr;
+wgpu::Limits Application::limits{};
+
+namespace {
+
+	constexpr float Tolerance = 1e-4f; // Relative to the amplitude
+
+	constexpr Noise::Function Functions[] = {Noise::Value, Noise::ValueCubic};
+	constexpr const char *FunctionNames[] = {"Value", "ValueCubic"};
+	constexpr Noise::Fractal Fractals[] = {Noise::Fractal::None, Noise::Fractal::FBM};
+	constexpr const char *FractalNames[] = {"None", "FBM"};
+	constexpr Noise::Hash Hashes[] = {Noise::PrimeXor, Noise::Pcg, Noise::XxHash, Noise::ShiftAdd};
+	constexpr const char *HashNames[] = {"PrimeXor", "Pcg", "XxHash", "ShiftAdd"};
+
+	constexpr auto ReadbackTimeout = std::chrono::seconds(30);
+
+	struct Settings {
+		int mesh = Chunk::DefaultChunkSize + 1;
+		glm::ivec2 chunk{3, -2};
+	};
+
+	bool parse(int argc, char **argv, Settings &settings) {
+		for (int i = 1; i < argc; i++) {
+			if (std::strcmp(argv[i], "--mesh") == 0 && i + 1 < argc) {
+				settings.mesh = std::max(2, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--chunk") == 0 && i + 2 < argc) {
+				settings.chunk.x = std::atoi(argv[++i]);
+				settings.chunk.y = std::atoi(argv[++i]);
+			}
+			else {
+				std::fprintf(stderr, "Usage: %s [--mesh N] [--chunk X Y]\n", argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Creates Application::device and queue on the fallback adapter, false when there is none
+	bool initDevice(wgpu::Instance instance) {
+		wgpu::RequestAdapterOptions adapterOpts{};
+		adapterOpts.nextInChain = nullptr;
+		adapterOpts.compatibleSurface = nullptr;
+		adapterOpts.forceFallbackAdapter = true;
+		wgpu::Adapter adapter = instance.requestAdapter(adapterOpts);
+		if (!adapter) {
+			return false;
+		}
+
+		wgpu::SupportedLimits supportedLimits;
+		adapter.getLimits(&supportedLimits);
+		wgpu::RequiredLimits requiredLimits = wgpu::Default;
+		requiredLimits.limits = supportedLimits.limits;
+
+		wgpu::DeviceDescriptor deviceDesc{};
+		deviceDesc.nextInChain = nullptr;
+		deviceDesc.label = "Noise Compute Check Device";
+		deviceDesc.requiredFeaturesCount = 0;
+		deviceDesc.requiredLimits = &requiredLimits;
+		deviceDesc.defaultQueue.label = "Default Queue";
+		wgpu::Device device = adapter.requestDevice(deviceDesc);
+		adapter.release();
+		if (!device) {
+			return false;
+		}
+
+		Application::device = std::make_unique<wgpu::Device>(device);
+		Application::queue = std::make_unique<wgpu::Queue>(Application::device->getQueue());
+		Application::device->getLimits(&supportedLimits);
+		Application::limits = supportedLimits.limits;
+		return true;
+	}
+
+	// Runs the callbacks of finished GPU work, see Application::onFrame
+	void poll() {
+#ifdef WEBGPU_BACKEND_WGPU
+		Application::queue->submit(0, nullptr);
+#else
+		Application::device->tick();
+#endif
+	}
+
+	// Generates a mesh of the noise on the GPU and reads its heights back, empty when the readback fails
+	std::vector<float> generateHeights(NoiseCompute &compute, const Noise &noise, int meshSize, glm::vec2 gridOrigin) {
+		Mesh mesh(meshSize);
+		mesh.format = VertexFormat::Standard;
+
+		// The buffer Terrain::initChunkBuffers creates for GPU generated meshes
+		wgpu::BufferDescriptor vertexBufferDesc{};
+		vertexBufferDesc.size = mesh.vertexCount * mesh.vertexStride();
+		vertexBufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopySrc;
+		vertexBufferDesc.mappedAtCreation = false;
+		mesh.vertexBuffer = Application::device->createBuffer(vertexBufferDesc);
+
+		compute.generate(noise, mesh, gridOrigin);
+
+		std::vector<float> heights;
+		bool done = false;
+		compute.readHeights(mesh, [&](std::vector<float> read) {
+			heights = std::move(read);
+			done = true;
+		});
+		auto deadline = std::chrono::steady_clock::now() + ReadbackTimeout;
+		while (!done && std::chrono::steady_clock::now() < deadline) {
+			poll();
+		}
+
+		mesh.vertexBuffer.destroy();
+		mesh.vertexBuffer.release();
+		return heights;
+	}
+}
+
+int main(int argc, char **argv) {
+	Settings settings;
+	if (!parse(argc, argv, settings)) {
+		return 1;
+	}
+
+	wgpu::Instance instance = wgpu::createInstance(wgpu::InstanceDescriptor{});
+	if (!instance || !initDevice(instance)) {
+		std::fprintf(stderr, "No fallback adapter, the compute pass can't be checked\n");
+		return 1;
+	}
+
+	bool deviceError = false;
+	auto errorCallbackHandle = Application::device->setUncapturedErrorCallback([&](wgpu::ErrorType type, char const *message) {
+		std::fprintf(stderr, "Device error: type %d (%s)\n", int(type), message ? message : "no message");
+		deviceError = true;
+	});
+
+	int chunkSize = settings.mesh - 1;
+	glm::vec2 gridOrigin = glm::vec2(settings.chunk * chunkSize - 1);
+	bool passed = true;
+	{
+		NoiseCompute compute;
+
+		std::printf("Noise compute check, %dx%d mesh at chunk (%d, %d), tolerance %g of the amplitude\n\n",
+				settings.mesh, settings.mesh, settings.chunk.x, settings.chunk.y, Tolerance);
+		std::printf("%-11s %-6s %-9s %-8s %12s %12s\n", "function", "fractal", "hash", "culling", "difference", "tolerance");
+
+		for (size_t f = 0; f < std::size(Functions); f++) {
+			for (size_t r = 0; r < std::size(Fractals); r++) {
+				for (size_t h = 0; h < std::size(Hashes); h++) {
+					for (bool culling : {false, true}) {
+						// Octave culling only changes the fractals
+						if (culling && Fractals[r] == Noise::Fractal::None) {
+							continue;
+						}
+
+						Noise::Descriptor desc;
+						desc.function = Functions[f];
+						desc.fractal = Fractals[r];
+						desc.hash = Hashes[h];
+						desc.octaves = 6;
+						desc.frequency = 0.05f;
+						desc.amplitude = 10.0f;
+						desc.detailCenter = glm::vec2(0.0f);
+						desc.featureSizeFalloff = culling ? Terrain::DefaultFeatureSizeFalloff : 0.0f;
+						Noise noise(desc);
+
+						std::vector<float> heights = generateHeights(compute, noise, settings.mesh, gridOrigin);
+						float tolerance = Tolerance * desc.amplitude;
+						bool read = heights.size() == static_cast<size_t>(settings.mesh) * settings.mesh;
+						float difference = read ? NoiseCompute::maxDifference(noise, heights, gridOrigin, settings.mesh) : 0.0f;
+						bool ok = read && difference <= tolerance;
+						passed = passed && ok;
+
+						std::printf("%-11s %-6s %-9s %-8s %12.7f %12.7f%s\n", FunctionNames[f], FractalNames[r], HashNames[h],
+								culling ? "on" : "off", difference, tolerance, read ? (ok ? "" : "  FAILED") : "  NO READBACK");
+					}
+				}
+			}
+		}
+	}
+
+	errorCallbackHandle.reset();
+	Application::queue.reset();
+	Application::device->release();
+	Application::device.reset();
+	instance.release();
+	return passed && !deviceError ? 0 : 1;
+}
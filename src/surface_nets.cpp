@@ -0,0 +1,186 @@
+#include "surface_nets.h"
+#include "noise/parallel_for.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+	constexpr int SlabLayers = 4; // Sample layers of quads per slab, the split doesn't depend on the thread count
+
+	// Corner pairs of the 12 cell edges, corner bit 0 is x, bit 1 is y and bit 2 is z
+	constexpr int CellEdges[12][2] = {
+			{0, 1}, {2, 3}, {4, 5}, {6, 7},
+			{0, 2}, {1, 3}, {4, 6}, {5, 7},
+			{0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+	// Vertices and quads of a run of cell layers, indices local to the slab
+	struct Slab {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		uint32_t warmUp = 0; // Leading vertices of the layer before the slab, the previous slab has them too
+		uint32_t lastLayerBegin = 0; // First vertex of the last cell layer, the next slab's warm-up
+	};
+
+	class Extractor {
+	public:
+
+		Extractor(std::span<const float> density, int size, glm::vec3 origin) :
+				density(density), size(size), samples(size + 2), cells(size + 1), origin(origin) {}
+
+		// Cell layers z0 - 1 to z1 - 1 and the quads of the edges starting on sample layers z0 to z1 - 1
+		Slab extract(int z0, int z1) const {
+			Slab slab;
+			std::vector<int32_t> layers[2] = {std::vector<int32_t>(cells * cells), std::vector<int32_t>(cells * cells)};
+
+			for (int z = z0 - 1; z < z1; z++) {
+				std::vector<int32_t> &current = layers[z & 1];
+				if (z == z1 - 1) {
+					slab.lastLayerBegin = static_cast<uint32_t>(slab.vertices.size());
+				}
+				for (int y = 0; y < cells; y++) {
+					for (int x = 0; x < cells; x++) {
+						current[y * cells + x] = cellVertex(x, y, z, slab.vertices);
+					}
+				}
+
+				if (z == z0 - 1) {
+					slab.warmUp = static_cast<uint32_t>(slab.vertices.size());
+					continue;
+				}
+				emitQuads(z, layers[(z - 1) & 1], current, slab.indices);
+			}
+			return slab;
+		}
+
+	private:
+
+		std::span<const float> density;
+		int size;
+		int samples;
+		int cells;
+		glm::vec3 origin;
+
+		float at(int x, int y, int z) const {
+			return density[(static_cast<size_t>(z) * samples + y) * samples + x];
+		}
+
+		// Appends the vertex of cell (x, y, z) if the surface crosses it, returns its index or -1
+		int32_t cellVertex(int x, int y, int z, std::vector<Vertex> &vertices) const {
+			float corners[8];
+			int solid = 0;
+			for (int i = 0; i < 8; i++) {
+				corners[i] = at(x + (i & 1), y + ((i >> 1) & 1), z + ((i >> 2) & 1));
+				solid += corners[i] > 0.0f;
+			}
+			if (solid == 0 || solid == 8) {
+				return -1;
+			}
+
+			// Mass point of the edge crossings
+			glm::vec3 sum(0.0f);
+			int crossings = 0;
+			for (const auto &[a, b] : CellEdges) {
+				if ((corners[a] > 0.0f) == (corners[b] > 0.0f)) {
+					continue;
+				}
+				float t = corners[a] / (corners[a] - corners[b]);
+				glm::vec3 pa(float(a & 1), float((a >> 1) & 1), float((a >> 2) & 1));
+				glm::vec3 pb(float(b & 1), float((b >> 1) & 1), float((b >> 2) & 1));
+				sum += pa + (pb - pa) * t;
+				crossings++;
+			}
+
+			// Density gradient from the differences along the four parallel edges, pointing into the solid
+			glm::vec3 gradient(
+					(corners[1] - corners[0]) + (corners[3] - corners[2]) + (corners[5] - corners[4]) + (corners[7] - corners[6]),
+					(corners[2] - corners[0]) + (corners[3] - corners[1]) + (corners[6] - corners[4]) + (corners[7] - corners[5]),
+					(corners[4] - corners[0]) + (corners[5] - corners[1]) + (corners[6] - corners[2]) + (corners[7] - corners[3]));
+			float length = glm::length(gradient);
+
+			glm::vec3 local = glm::vec3(float(x), float(y), float(z)) + sum / float(crossings);
+			Vertex vertex{};
+			vertex.position = origin + local;
+			vertex.normal = length > 0.0f ? -gradient / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+			// Same corner gradient as the height field chunks, over x and z
+			float r = glm::clamp((local.x - 1.0f) / float(size), 0.0f, 1.0f);
+			float g = glm::clamp((local.z - 1.0f) / float(size), 0.0f, 1.0f);
+			vertex.color = {r, g, (1 - g) * (1 - r)};
+
+			vertices.push_back(vertex);
+			return static_cast<int32_t>(vertices.size() - 1);
+		}
+
+		// Quads of the crossed edges starting on sample layer z inside the chunk. The four cells around an edge along
+		// axis a, walked s, s - b, s - b - c, s - c for the cyclic axes (a, b, c), face +a. The winding flips when
+		// the solid side is the far end so the front faces point out of the solid.
+		void emitQuads(int z, const std::vector<int32_t> &below, const std::vector<int32_t> &current, std::vector<uint32_t> &indices) const {
+			auto quad = [&](bool solidFirst, int32_t c0, int32_t c1, int32_t c2, int32_t c3) {
+				assert(c0 >= 0 && c1 >= 0 && c2 >= 0 && c3 >= 0);
+				if (!solidFirst) {
+					std::swap(c1, c3);
+				}
+				indices.insert(indices.end(), {uint32_t(c0), uint32_t(c1), uint32_t(c2), uint32_t(c0), uint32_t(c2), uint32_t(c3)});
+			};
+
+			for (int y = 1; y <= size; y++) {
+				for (int x = 1; x <= size; x++) {
+					bool solid = at(x, y, z) > 0.0f;
+					int cell = y * cells + x;
+
+					if (solid != (at(x + 1, y, z) > 0.0f)) {
+						quad(solid, current[cell], current[cell - cells], below[cell - cells], below[cell]);
+					}
+					if (solid != (at(x, y + 1, z) > 0.0f)) {
+						quad(solid, current[cell], below[cell], below[cell - 1], current[cell - 1]);
+					}
+					if (solid != (at(x, y, z + 1) > 0.0f)) {
+						quad(solid, current[cell], current[cell - 1], current[cell - 1 - cells], current[cell - cells]);
+					}
+				}
+			}
+		}
+	};
+}
+
+SurfaceNets::Surface SurfaceNets::extract(std::span<const float> density, int size, glm::vec3 origin, int threads) {
+	int samples = size + 2;
+	size_t count = static_cast<size_t>(samples) * samples * samples;
+	if (density.size() < count) {
+		throw std::runtime_error("SurfaceNets: density holds " + std::to_string(density.size()) + " samples, a size " + std::to_string(size) + " chunk needs " + std::to_string(count));
+	}
+
+	Extractor extractor(density, size, origin);
+	int slabCount = (size + SlabLayers - 1) / SlabLayers;
+	std::vector<Slab> slabs(slabCount);
+	Parallel::parallelFor(slabCount, Parallel::threadCount(threads), [&](int slab, int) {
+		int z0 = 1 + slab * SlabLayers;
+		slabs[slab] = extractor.extract(z0, std::min(z0 + SlabLayers, size + 1));
+	});
+
+	// Stitch the slabs in order, the warm-up vertices of a slab map onto the last layer of the previous one
+	Surface surface;
+	std::vector<uint32_t> previousLayer;
+	for (size_t k = 0; k < slabs.size(); k++) {
+		const Slab &slab = slabs[k];
+		uint32_t skip = k > 0 ? slab.warmUp : 0;
+		assert(k == 0 || skip == previousLayer.size());
+
+		auto base = static_cast<uint32_t>(surface.vertices.size());
+		auto global = [&](uint32_t i) { return i < skip ? previousLayer[i] : base + i - skip; };
+
+		surface.vertices.insert(surface.vertices.end(), slab.vertices.begin() + skip, slab.vertices.end());
+		for (uint32_t i : slab.indices) {
+			surface.indices.push_back(global(i));
+		}
+
+		previousLayer.clear();
+		for (auto i = slab.lastLayerBegin; i < slab.vertices.size(); i++) {
+			previousLayer.push_back(global(i));
+		}
+	}
+	return surface;
+}
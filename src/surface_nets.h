@@ -0,0 +1,35 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+ * Surface Nets isosurface extraction for density chunks.
+ *
+ * One vertex per cell with a sign change, at the mass point of the crossings on its edges, and one quad per crossed
+ * edge joining the four cells around it. The vertices of neighbouring cells are shared through their indices: the
+ * chunk is split into z slabs extracted in parallel, each keeping the vertex indices of only its current and previous
+ * cell layer, and the slabs are stitched where they meet.
+ */
+namespace SurfaceNets {
+
+	struct Surface {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices; // 32-bit as a surface can pass 65536 vertices, Mesh::indexFormat picks the uploaded width
+	};
+
+	/**
+	 * Extracts the surface where the density crosses 0, positive density is solid.
+	 *
+	 * The density grid overlaps the neighbouring chunks by one sample on each side. Only edges starting inside the
+	 * chunk emit quads, so every crossed edge belongs to exactly one chunk and neighbouring surfaces meet without
+	 * gaps or overlaps.
+	 * @param density (size + 2)^3 samples one world unit apart, density[(z * (size + 2) + y) * (size + 2) + x] at origin + (x, y, z)
+	 * @param origin World position of the first sample, one unit before the chunk corner
+	 * @param threads Worker count, 0 uses every hardware thread
+	 */
+	Surface extract(std::span<const float> density, int size, glm::vec3 origin, int threads = 0);
+}
@@ -8,9 +8,11 @@ Terrain::Terrain(Noise::Descriptor noiseDesc, glm::ivec2 centerChunkPos, int num
 		: center(centerChunkPos), numVisibleChunks(numVisibleChunks), chunkSize(chunkSize), wireFrame(wireFrame) {
 
 
+	checkChunkSize();
 	createRenderPipelines();
 
-	noise = Noise(noiseDesc);
+	noise = Noise(withDetail(noiseDesc));
+	largeCoordinates = needsLargeCoordinates(center);
 
 
 //	loadManager.addPointOfInterest(PointOfInterest{center, numVisibleChunks});
@@ -23,6 +25,102 @@ Terrain::Terrain(Noise::Descriptor noiseDesc, glm::ivec2 centerChunkPos, int num
 
 
 
+}
+
+Terrain::Terrain(NoiseGraph noiseGraph, glm::ivec2 centerChunkPos, int numVisibleChunks, int chunkSize, bool wireFrame)
+		: center(centerChunkPos), numVisibleChunks(numVisibleChunks), chunkSize(chunkSize), wireFrame(wireFrame) {
+
+	checkChunkSize();
+	createRenderPipelines();
+
+	if (!noiseGraph.isCompiled()) {
+		noiseGraph.compile();
+	}
+	graph = std::move(noiseGraph);
+}
+
+void Terrain::checkChunkSize() const {
+	// The largest buffer of a chunk is the Vertex buffer of its grid, the compute pass binds it as storage
+	uint64_t gridVertices = static_cast<uint64_t>(chunkSize + 1) * (chunkSize + 1);
+	uint64_t vertexBytes = gridVertices * sizeof(Vertex);
+	uint64_t maxBytes = std::min<uint64_t>(Application::limits.maxBufferSize, Application::limits.maxStorageBufferBindingSize);
+	if (chunkSize < 1 || chunkSize > UINT16_MAX || vertexBytes > maxBytes) {
+		throw std::runtime_error("Chunk size " + std::to_string(chunkSize) + " needs " + std::to_string(vertexBytes)
+				+ " byte vertex buffers, the device allows " + std::to_string(maxBytes));
+	}
+}
+
+Chunk Terrain::makeChunk(glm::ivec2 pos, Chunk::Cache cache) {
+	if (spectral) {
+		return Chunk(spectralTile, spectral->desc.size, pos, chunkSize, wireFrame);
+	}
+	if (graph) {
+		return Chunk(*graph, pos, chunkSize, wireFrame);
+	}
+	if (!octaveLayerCache) {
+		cache.octaveLayers.reset();
+	}
+	else if (!cache.octaveLayers) {
+		cache.octaveLayers.emplace();
+	}
+	return Chunk(noise, pos, chunkSize, wireFrame, std::move(cache), largeCoordinates);
+}
+
+bool Terrain::needsLargeCoordinates(glm::ivec2 centerChunkPos) const {
+	return Noise::needsLargeCoordinates(glm::i64vec2(centerChunkPos) * int64_t(chunkSize));
+}
+
+bool Terrain::usesCompute() const {
+	// The shader only has the float coordinate path
+	return compute && !spectral && !graph && !density && NoiseCompute::supports(noise.desc) && !largeCoordinates;
+}
+
+void Terrain::loadColumn(glm::ivec2 pos, Chunk::Cache cache) {
+	VertexFormat gridFormat = compactVertices ? VertexFormat::Compact : VertexFormat::Standard;
+
+	if (usesCompute()) {
+		Chunk &chunk = chunks.insert({pos, Chunk(pos, chunkSize)}).first->second;
+		chunk.mesh.format = gridFormat;
+		chunk.mesh.boundsMax = {float(chunkSize), noise.desc.amplitude, float(chunkSize)}; // The value kernels stay in [0, amplitude]
+		initMesh(chunk.mesh);
+		compute->generate(noise, chunk.mesh, chunk.gridOrigin(chunkSize));
+		return;
+	}
+
+	if (!density || graph || spectral) {
+		Chunk &chunk = chunks.insert({pos, makeChunk(pos, std::move(cache))}).first->second;
+		chunk.mesh.format = gridFormat;
+		initMesh(chunk.mesh);
+		return;
+	}
+
+	glm::ivec2 range = density->chunkRange(noise.desc.amplitude, chunkSize);
+	for (int y = range.x; y <= range.y; y++) {
+		glm::ivec3 chunkPos(pos.x, y, pos.y);
+		DensityChunk chunk(noise, chunkPos, *density, chunkSize);
+		if (chunk.empty()) {
+			continue;
+		}
+		densityChunks.insert({chunkPos, std::move(chunk)});
+		initMesh(densityChunks.at(chunkPos).mesh);
+	}
+}
+
+void Terrain::initMesh(Mesh& mesh) {
+	initChunkBuffers(mesh);
+	initChunkUniforms(mesh);
+	initChunkBindGroup(mesh);
+	mesh.validBuffers = true;
+
+	if (residency != Residency::Full) {
+		mesh.releaseGeometry(residency == Residency::GpuWithHeightField);
+	}
+}
+
+Noise::Descriptor Terrain::withDetail(Noise::Descriptor noiseDesc) const {
+	noiseDesc.detailCenter = (glm::vec2(center) + 0.5f) * float(chunkSize);
+	noiseDesc.featureSizeFalloff = featureSizeFalloff;
+	return noiseDesc;
 }
 
 void Terrain::load() {
@@ -46,11 +144,7 @@ void Terrain::load() {
 	loadManager.updateChunkLists();
 //
 	for (auto& pos : loadManager.chunksToLoad) {
-		chunks.insert({pos, Chunk(noise, pos, chunkSize, wireFrame)});
-		initChunkBuffers(chunks.at(pos));
-		initChunkUniforms(chunks.at(pos));
-		initChunkBindGroup(chunks.at(pos));
-		chunks.at(pos).mesh.validBuffers = true;
+		loadColumn(pos);
 	}
 
 	loadManager.chunksToLoad.clear();
@@ -61,6 +155,13 @@ void Terrain::update(glm::ivec2 centerChunkPos) {
 
 	if (centerChunkPos != this->center) {
 
+		// Every chunk takes the same coordinate path, moving across FloatPathRange regenerates them all
+		bool large = needsLargeCoordinates(centerChunkPos);
+		if (large != largeCoordinates) {
+			largeCoordinates = large;
+			regenerate = true;
+		}
+
 //		loadManager.removePointOfInterest(PointOfInterest(this->center, numVisibleChunks));
 //		loadManager.addPointOfInterest(PointOfInterest(centerChunkPos, numVisibleChunks));
 //
@@ -85,17 +186,24 @@ void Terrain::update(glm::ivec2 centerChunkPos) {
 	if (regenerate) {
 
 
+		// Keep the chunk caches, edits that don't touch the settings a cache depends on reuse it
+		std::map<glm::ivec2, Chunk::Cache, decltype(posCmp)> caches;
 		for (auto& [pos, chunk] : chunks) {
 			loadManager.chunksToLoad.insert(pos);
+			caches.insert({pos, std::move(chunk.cache)});
 		}
 		chunks.clear();
 
+		// Density columns are kept by their xz position
+		for (auto& [pos, chunk] : densityChunks) {
+			loadManager.chunksToLoad.insert({pos.x, pos.z});
+		}
+		densityChunks.clear();
+
 		for (auto& pos : loadManager.chunksToLoad) {
-			chunks.insert({pos, Chunk(noise, pos, chunkSize, wireFrame)});
-			initChunkBuffers(chunks.at(pos));
-			initChunkUniforms(chunks.at(pos));
-			initChunkBindGroup(chunks.at(pos));
-			chunks.at(pos).mesh.validBuffers = true;
+			auto cached = caches.find(pos);
+			Chunk::Cache cache = cached != caches.end() ? std::move(cached->second) : Chunk::Cache{};
+			loadColumn(pos, std::move(cache));
 			// Cant add to chunks to render until renderer creates buffers
 		}
 
@@ -109,34 +217,201 @@ void Terrain::update(glm::ivec2 centerChunkPos) {
 }
 
 void Terrain::setNoise(Noise::Descriptor noiseDesc) {
-	noise = Noise(noiseDesc);
+	noise.setDescriptor(withDetail(noiseDesc)); // Resolves the noise kernels once for every chunk that follows
+	graph.reset();
+	spectral.reset();
+	spectralTile = {};
+	regenerate = true;
+}
+
+void Terrain::setNoise(NoiseGraph noiseGraph) {
+	if (!noiseGraph.isCompiled()) {
+		noiseGraph.compile();
+	}
+	graph = std::move(noiseGraph);
+	spectral.reset();
+	spectralTile = {};
+	regenerate = true;
+}
+
+void Terrain::setNoise(SpectralNoise spectralNoise) {
+	spectralTile = spectralNoise.generate();
+	spectral = spectralNoise;
+	graph.reset();
 	regenerate = true;
 }
 
 void Terrain::setWireFrame(bool wire) {
-	if (wire == wireFrame) return;
+	// Only the shared grid indices change, the meshes are kept and density meshes have their edge indices uploaded
 	wireFrame = wire;
+}
+
+void Terrain::setOctaveLayerCache(bool enabled) {
+	octaveLayerCache = enabled;
+	if (!enabled) {
+		for (auto& [pos, chunk] : chunks) {
+			chunk.cache.octaveLayers.reset();
+		}
+	}
+}
+
+void Terrain::setFeatureSizeFalloff(float falloff) {
+	if (falloff == featureSizeFalloff) return;
+	featureSizeFalloff = falloff;
+	noise.setDescriptor(withDetail(noise.desc));
+	regenerate = !graph && !spectral;
+}
+
+void Terrain::setDensity(std::optional<DensityChunk::Settings> settings) {
+	density = settings;
+	regenerate = true;
+}
+
+void Terrain::setGpuGeneration(bool enabled) {
+	if (enabled == isGpuGeneration()) return;
+	if (enabled) {
+		compute = std::make_unique<NoiseCompute>();
+	}
+	else {
+		compute.reset();
+	}
+	regenerate = true;
+}
+
+void Terrain::setResidency(Residency mode) {
+	if (mode == residency) return;
+	residency = mode;
+	regenerate = true; // The released geometry has to be rebuilt to be kept
+}
+
+void Terrain::setCompactVertices(bool enabled) {
+	if (enabled == compactVertices) return;
+	compactVertices = enabled;
 	regenerate = true;
 }
 
+void Terrain::readChunkHeights(glm::ivec2 pos, std::function<void(std::vector<float>)> done) {
+	auto found = chunks.find(pos);
+	if (found == chunks.end()) {
+		done({});
+		return;
+	}
+
+	const Mesh &mesh = found->second.mesh;
+	if (!mesh.heightField.empty()) {
+		done(mesh.heightField);
+		return;
+	}
+	if (mesh.vertices.empty()) {
+		if (compute) {
+			compute->readHeights(mesh, std::move(done));
+		}
+		else {
+			done({}); // Nothing kept on the CPU and no readback without the GPU generation
+		}
+		return;
+	}
+
+	std::vector<float> heights;
+	heights.reserve(mesh.vertices.size());
+	for (const Vertex &vertex : mesh.vertices) {
+		heights.push_back(vertex.position.y);
+	}
+	done(std::move(heights));
+}
+
+void Terrain::setRenderOrigin(glm::dvec3 origin) {
+	renderOrigin = origin;
+	for (auto& [pos, chunk] : chunks) {
+		updateMeshUniforms(chunk.mesh);
+	}
+	for (auto& [pos, chunk] : densityChunks) {
+		updateMeshUniforms(chunk.mesh);
+	}
+}
+
+void Terrain::updateMeshUniforms(Mesh& mesh) const {
+	glm::vec3 translation(mesh.origin - renderOrigin);
+	glm::vec3 light(LightPosition - renderOrigin);
+	mesh.uniforms.modelMatrix = uniforms.modelMatrix * glm::translate(glm::mat4(1.0f), translation);
+	mesh.uniforms.lightPosition = {light.x, light.y, light.z, 1.0f};
+	if (mesh.validBuffers) {
+		Application::queue->writeBuffer(mesh.uniformBuffer, offsetof(ShaderUniforms, modelMatrix), &mesh.uniforms.modelMatrix, sizeof(ShaderUniforms::modelMatrix));
+		Application::queue->writeBuffer(mesh.uniformBuffer, offsetof(ShaderUniforms, lightPosition), &mesh.uniforms.lightPosition, sizeof(ShaderUniforms::lightPosition));
+	}
+}
+
 bool Terrain::isWireFrame() {
 	return wireFrame;
 }
 
-void Terrain::render(wgpu::RenderPassEncoder &renderPass) {
+bool Terrain::isDensity() const {
+	return density.has_value();
+}
+
+bool Terrain::isSpectral() const {
+	return spectral.has_value();
+}
+
+bool Terrain::isGpuGeneration() const {
+	return compute != nullptr;
+}
+
+bool Terrain::isOctaveLayerCache() const {
+	return octaveLayerCache;
+}
+
+float Terrain::getFeatureSizeFalloff() const {
+	return featureSizeFalloff;
+}
+
+bool Terrain::isCompactVertices() const {
+	return compactVertices;
+}
 
-	if (wireFrame) {
-		renderPass.setPipeline(m_wireframePipeline);
+Terrain::Residency Terrain::getResidency() const {
+	return residency;
+}
+
+wgpu::RenderPipeline Terrain::pipeline(VertexFormat format) const {
+	if (format == VertexFormat::Compact) {
+		return wireFrame ? m_compactWireframePipeline : m_compactPipeline;
 	}
-	else {
-		renderPass.setPipeline(m_pipeline);
+	return wireFrame ? m_wireframePipeline : m_pipeline;
+}
+
+void Terrain::render(wgpu::RenderPassEncoder &renderPass) {
+
+	// Every height field chunk has the same grid, its indices are bound once
+	if (!chunks.empty()) {
+		Mesh::GridTopology topology = wireFrame ? Mesh::GridTopology::Lines : Mesh::GridTopology::Triangles;
+		const GridIndexBuffer &grid = gridIndexBuffer({chunkSize, 0, topology});
+		renderPass.setIndexBuffer(grid.buffer, grid.format, 0, grid.size);
+
+		// The chunks only mix formats until a format switch regenerates them
+		std::optional<VertexFormat> bound;
+		for (auto& [key, chunk] : chunks) {
+			if (bound != chunk.mesh.format) {
+				renderPass.setPipeline(pipeline(chunk.mesh.format));
+				bound = chunk.mesh.format;
+			}
+			renderPass.setVertexBuffer(0, chunk.mesh.vertexBuffer, 0, chunk.mesh.vertexCount * chunk.mesh.vertexStride());
+			renderPass.setBindGroup(0, chunk.mesh.bindGroup, 0, nullptr);
+			renderPass.drawIndexed(grid.count, 1, 0, 0, 0);
+		}
 	}
 
-	for (auto& [key, chunk] : chunks) {
-		renderPass.setVertexBuffer(0, chunk.mesh.vertexBuffer, 0, chunk.mesh.vertices.size() * sizeof(Vertex));
-		renderPass.setIndexBuffer(chunk.mesh.indexBuffer, wgpu::IndexFormat::Uint16, 0, chunk.mesh.indices.size() * sizeof(uint16_t));
+	// The wire frame pipeline is a line list, density meshes switch to their edge indices for it
+	renderPass.setPipeline(pipeline(VertexFormat::Standard));
+	for (auto& [key, chunk] : densityChunks) {
+		wgpu::IndexFormat indexFormat = Mesh::indexFormat(chunk.mesh.vertexCount);
+		size_t indexSize = indexFormat == wgpu::IndexFormat::Uint32 ? sizeof(uint32_t) : sizeof(uint16_t);
+		wgpu::Buffer indexBuffer = wireFrame ? chunk.mesh.lineIndexBuffer : chunk.mesh.indexBuffer;
+		uint32_t indexCount = wireFrame ? chunk.mesh.lineIndexCount : chunk.mesh.indexCount;
+		renderPass.setVertexBuffer(0, chunk.mesh.vertexBuffer, 0, chunk.mesh.vertexCount * sizeof(Vertex));
+		renderPass.setIndexBuffer(indexBuffer, indexFormat, 0, indexCount * indexSize);
 		renderPass.setBindGroup(0, chunk.mesh.bindGroup, 0, nullptr);
-		renderPass.drawIndexed(chunk.mesh.indices.size(), 1, 0, 0, 0);
+		renderPass.drawIndexed(indexCount, 1, 0, 0, 0);
 	}
 
 }
@@ -280,20 +555,49 @@ void Terrain::createRenderPipelines() {
 	}
 	std::cout << "Wireframe Render pipeline: " << m_wireframePipeline << std::endl;
 
+	// Compact vertices: 16-bit grid index at @location(0), half float height and octahedral normal packed in @location(1)
+	std::vector<wgpu::VertexAttribute> compactAttribs(2);
+	compactAttribs[0].shaderLocation = 0;
+	compactAttribs[0].format = wgpu::VertexFormat::Uint16x2;
+	compactAttribs[0].offset = offsetof(CompactVertex, col);
+
+	compactAttribs[1].shaderLocation = 1;
+	compactAttribs[1].format = wgpu::VertexFormat::Uint32; // Unpacked in the shader
+	compactAttribs[1].offset = offsetof(CompactVertex, height);
+
+	wgpu::VertexBufferLayout compactBufferLayout{};
+	compactBufferLayout.attributeCount = 2;
+	compactBufferLayout.attributes = compactAttribs.data();
+	compactBufferLayout.arrayStride = sizeof(CompactVertex);
+	compactBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
+
+	wgpu::RenderPipelineDescriptor compactPipelineDesc = pipelineDesc;
+	compactPipelineDesc.vertex.buffers = &compactBufferLayout;
+	compactPipelineDesc.vertex.entryPoint = "vs_compact";
+	m_compactPipeline = Application::device->createRenderPipeline(compactPipelineDesc);
+
+	compactPipelineDesc.primitive.topology = wgpu::PrimitiveTopology::LineList;
+	m_compactWireframePipeline = Application::device->createRenderPipeline(compactPipelineDesc);
+	if (!m_compactPipeline || !m_compactWireframePipeline) {
+		throw std::runtime_error("Could not create compact vertex render pipelines!");
+	}
+
 
 }
 
 void Terrain::terminateRenderPipeline() {
 	m_pipeline.release();
 	m_wireframePipeline.release();
+	m_compactPipeline.release();
+	m_compactWireframePipeline.release();
 	m_shaderModule.release();
 	m_bindGroupLayout.release();
 }
 
-void Terrain::initChunkBuffers(Chunk& chunk) {
+void Terrain::initChunkBuffers(Mesh& mesh) {
 	// Create vertex buffer
 	wgpu::BufferDescriptor vertexBufferDesc{};
-	vertexBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex;
+	vertexBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopySrc; // Read back once released
 	vertexBufferDesc.mappedAtCreation = false;
 
 	wgpu::BufferDescriptor indexBufferDesc{};
@@ -301,38 +605,103 @@ void Terrain::initChunkBuffers(Chunk& chunk) {
 	indexBufferDesc.mappedAtCreation = false;
 
 	// Create vertex buffer
-	vertexBufferDesc.size = chunk.mesh.vertices.size() * sizeof(Vertex);
-	chunk.mesh.vertexBuffer = Application::device->createBuffer(vertexBufferDesc);
-	// Upload vertex data to vertex buffer
-	Application::queue->writeBuffer(chunk.mesh.vertexBuffer, 0, chunk.mesh.vertices.data(), vertexBufferDesc.size);
-	std::cout << "Vertex Buffer: " << chunk.mesh.vertexBuffer << std::endl;
+	vertexBufferDesc.size = mesh.vertexCount * mesh.vertexStride();
+	if (mesh.vertices.empty()) {
+		// Generated on the GPU: written as storage by the compute pass and copied out for readbacks
+		vertexBufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopySrc;
+		mesh.vertexBuffer = Application::device->createBuffer(vertexBufferDesc);
+	}
+	else if (mesh.format == VertexFormat::Compact) {
+		std::vector<CompactVertex> compact = mesh.compactVertices();
+		mesh.vertexBuffer = Application::device->createBuffer(vertexBufferDesc);
+		Application::queue->writeBuffer(mesh.vertexBuffer, 0, compact.data(), vertexBufferDesc.size);
+	}
+	else {
+		mesh.vertexBuffer = Application::device->createBuffer(vertexBufferDesc);
+		// Upload vertex data to vertex buffer
+		Application::queue->writeBuffer(mesh.vertexBuffer, 0, mesh.vertices.data(), vertexBufferDesc.size);
+	}
+	std::cout << "Vertex Buffer: " << mesh.vertexBuffer << std::endl;
+
+	// Grid meshes draw with the shared grid indices
+	if (mesh.indices.empty()) {
+		return;
+	}
+
+	// Create index buffers, 16-bit unless the mesh has more vertices than that reaches. The wire frame pipeline draws
+	// line lists, so the surface's edges get a buffer of their own
+	auto upload = [&](const auto &indices) {
+		indexBufferDesc.size = indices.size() * sizeof(indices[0]);
+		wgpu::Buffer buffer = Application::device->createBuffer(indexBufferDesc);
+		// Upload index data to index buffer
+		Application::queue->writeBuffer(buffer, 0, indices.data(), indexBufferDesc.size);
+		return buffer;
+	};
+	std::vector<uint32_t> lines = Mesh::edgeIndices<uint32_t>(mesh.indices);
+	mesh.lineIndexCount = static_cast<uint32_t>(lines.size());
+	if (Mesh::indexFormat(mesh.vertexCount) == wgpu::IndexFormat::Uint32) {
+		mesh.indexBuffer = upload(mesh.indices);
+		mesh.lineIndexBuffer = upload(lines);
+	}
+	else {
+		mesh.indexBuffer = upload(std::vector<uint16_t>(mesh.indices.begin(), mesh.indices.end()));
+		mesh.lineIndexBuffer = upload(std::vector<uint16_t>(lines.begin(), lines.end()));
+	}
+	std::cout << "Index Buffer: " << mesh.indexBuffer << std::endl;
+}
+
+const GridIndexBuffer &Terrain::gridIndexBuffer(GridIndexBuffer::Key key) {
+	return gridIndexBuffers.try_emplace(key, key).first->second;
+}
+
+GridIndexBuffer::GridIndexBuffer(Key key) {
+	int gridSize = (key.chunkSize >> key.lod) + 1;
+	format = Mesh::indexFormat(static_cast<size_t>(gridSize) * gridSize);
+
+	auto upload = [&](const auto &indices) {
+		wgpu::BufferDescriptor indexBufferDesc{};
+		indexBufferDesc.size = indices.size() * sizeof(indices[0]);
+		indexBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Index;
+		indexBufferDesc.mappedAtCreation = false;
+		buffer = Application::device->createBuffer(indexBufferDesc);
+		size = indexBufferDesc.size;
+
+		Application::queue->writeBuffer(buffer, 0, indices.data(), indexBufferDesc.size);
+	};
+
+	if (format == wgpu::IndexFormat::Uint32) {
+		upload(Mesh::gridIndices<uint32_t>(gridSize, key.topology, count));
+	}
+	else {
+		upload(Mesh::gridIndices<uint16_t>(gridSize, key.topology, count));
+	}
+}
 
-	// Create index buffer
-	indexBufferDesc.size = chunk.mesh.indices.size() * sizeof(uint16_t);
-	chunk.mesh.indexBuffer = Application::device->createBuffer(indexBufferDesc);
-	// Upload index data to index buffer
-	Application::queue->writeBuffer(chunk.mesh.indexBuffer, 0, chunk.mesh.indices.data(), indexBufferDesc.size);
-	std::cout << "Index Buffer: " << chunk.mesh.indexBuffer << std::endl;
+GridIndexBuffer::~GridIndexBuffer() {
+	buffer.destroy();
+	buffer.release();
 }
 
-void Terrain::initChunkUniforms(Chunk& chunk) {
+void Terrain::initChunkUniforms(Mesh& mesh) {
 
 	bufferDesc.size = sizeof(ShaderUniforms);
 	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
 	bufferDesc.mappedAtCreation = false;
 
-	chunk.mesh.uniformBuffer = Application::device->createBuffer(bufferDesc);
+	mesh.uniformBuffer = Application::device->createBuffer(bufferDesc);
 
-	chunk.mesh.uniforms = uniforms;
+	mesh.uniforms = uniforms;
+	mesh.uniforms.grid = {float(mesh.meshSize), 0.0f, 0.0f, 0.0f};
+	updateMeshUniforms(mesh);
 
-	Application::queue->writeBuffer(chunk.mesh.uniformBuffer, 0, &chunk.mesh.uniforms, sizeof(ShaderUniforms));
+	Application::queue->writeBuffer(mesh.uniformBuffer, 0, &mesh.uniforms, sizeof(ShaderUniforms));
 }
 
-void Terrain::initChunkBindGroup(Chunk& chunk) {
+void Terrain::initChunkBindGroup(Mesh& mesh) {
 	// Create a binding
 	wgpu::BindGroupEntry binding{};
 	binding.binding = 0;
-	binding.buffer = chunk.mesh.uniformBuffer;
+	binding.buffer = mesh.uniformBuffer;
 	binding.offset = 0;
 	binding.size = sizeof(ShaderUniforms);
 
@@ -341,5 +710,5 @@ void Terrain::initChunkBindGroup(Chunk& chunk) {
 	bindGroupDesc.layout = m_bindGroupLayout;
 	bindGroupDesc.entryCount = 1;
 	bindGroupDesc.entries = &binding;
-	chunk.mesh.bindGroup = Application::device->createBindGroup(bindGroupDesc);
+	mesh.bindGroup = Application::device->createBindGroup(bindGroupDesc);
 }
\ No newline at end of file
@@ -8,11 +8,21 @@
 #include <webgpu/webgpu.hpp>
 #include <stb_image_write.h>
 #include "noise/noise.h"
+#include "noise/noise_graph.h"
+#include "noise/spectral.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include <queue>
 #include <set>
+#include <optional>
 #include "types.h"
+#include "surface_nets.h"
+#include "vertex_cache.h"
+#include "noise_compute.h"
+#include "noise/parallel_for.h"
+#include <functional>
+#include <memory>
 
 class World;
 
@@ -28,38 +38,54 @@ inline glm::ivec2 unKey(uint64_t k) {return {k >> 32, k & 0xFFFFFFFF};}
 class Mesh {
 public:
 
-	std::vector<Vertex> vertices;
-	std::vector<uint16_t> indices; // Keep as uint16_t, b/c WebGPU requires multiple of 4, and need to pad.
+	std::vector<Vertex> vertices; // Empty once uploaded unless Terrain::Residency::Full, see releaseGeometry
+	std::vector<uint32_t> indices; // Padded to a multiple of 4, uploaded as indexFormat(vertexCount). Empty for grid meshes, see gridIndices
+	std::vector<float> heightField; // Row-major grid heights kept by releaseGeometry for CPU queries
 
 	wgpu::Buffer vertexBuffer = nullptr;
 	wgpu::Buffer indexBuffer = nullptr;
+	wgpu::Buffer lineIndexBuffer = nullptr; // Edges of the indices triangles for the wire frame pipeline, surface meshes only
 	wgpu::Buffer uniformBuffer = nullptr;
 	wgpu::BindGroup bindGroup = nullptr;
 
 	ShaderUniforms uniforms{};
 
+	// World position the vertex positions are relative to, kept in double so far chunks don't lose precision
+	glm::dvec3 origin{};
+
 	int borderedSize = 0;
 	int meshSize = 0;
+	size_t vertexCount = 0; // vertices.size(), or the vertices generated straight into vertexBuffer
+	uint32_t indexCount = 0; // indices.size() with the padding, kept after releaseGeometry
+	uint32_t lineIndexCount = 0; // Of lineIndexBuffer, with the padding
+	glm::vec3 boundsMin{}; // Of the vertex positions, relative to origin
+	glm::vec3 boundsMax{};
+	VertexFormat format = VertexFormat::Standard; // Of vertexBuffer, vertices stay Vertex
 
 //	int numSides = 0;
 //	int vertsPerSide = 0;
 	bool validBuffers = false;
 
+	// Index topologies of the grid meshes
+	enum class GridTopology {
+		Triangles,
+		Lines // Every cell's edges and diagonal, for the wire frame pipeline
+	};
+
 	Mesh() = default;
 
 	/**
 	 *
-	 * @param heightMap 2D height map, where the y value is the height and x and z are world positions
+	 * @param heightMap 2D height map, where the y value is the height and x and z are positions relative to the chunk origin
 	 * @param borderedSize Number of vertices per side including the border
 	 * @param wireFrame
 	 */
 	Mesh(const std::vector<glm::vec3> &heightMap, const std::vector<int> &borderIndicesMap, int borderedSize, int meshSize, bool wireFrame = false) {
-		meshSize = meshSize;
-		borderedSize = borderedSize;
+		this->meshSize = meshSize;
+		this->borderedSize = borderedSize;
 //		vertsPerSide = numSides + 1;
 //		borderedSize = numSides + 2;
 		vertices.reserve(meshSize * meshSize);
-		indices.reserve((meshSize-1) * (meshSize-1) * 6);
 
 
 		for (int i = 0; i < borderedSize * borderedSize; i++) {
@@ -87,9 +113,6 @@ public:
 				normal = glm::normalize(normal);
 				vertex.normal = normal;
 
-				// Indices
-				Mesh::addTriangleIndices(indices, meshSize, meshRow, meshCol);
-
 				// Color
 				// ----------
 				float r = (float) meshCol / (float) meshSize;
@@ -182,99 +205,220 @@ public:
 
 
 		if (!wireFrame) {
-			std::cout << "Triangle Count: " << indices.size() / 3 << std::endl;
 			std::cout << "Vertex Count: " << vertices.size() << std::endl;
 			assert(meshSize * meshSize == vertices.size());
-			assert((meshSize-1) * (meshSize-1) * 2 == indices.size() / 3);
 
 		}
-		else {
-//			std::cout << "Line Count: " << indices.size() / 2 << std::endl;
-//			std::cout << "Vertex Count: " << vertices.size() << std::endl;
-//			assert(vertsPerSide * vertsPerSide == vertices.size());
-//			assert(numSides * numSides * 4 == indices.size() / 2);
+		vertexCount = vertices.size();
+		computeBounds();
+
+	}
+
+	/**
+	 * Mesh with normals from the analytic height gradient, so no border samples are needed.
+	 * @param heightMap meshSize^2 positions, where the y value is the height and x and z are relative to the chunk origin
+	 * @param gradients Height derivative along world x and z for every position
+	 */
+	Mesh(const std::vector<glm::vec3> &heightMap, const std::vector<glm::vec2> &gradients, int meshSize) {
+		this->meshSize = meshSize;
+		this->borderedSize = meshSize;
+		vertices.reserve(meshSize * meshSize);
+
+		for (int row = 0; row < meshSize; row++) {
+			for (int col = 0; col < meshSize; col++) {
+				int i = row * meshSize + col;
+
+				Vertex vertex{};
+				vertex.position = heightMap[i];
+				vertex.normal = glm::normalize(glm::vec3(-gradients[i].x, 1.0f, -gradients[i].y));
+
+				float r = (float) col / (float) meshSize;
+				float g = (float) row / (float) meshSize;
+				float b = (1 - g) * (1 - r);
+				vertex.color = {r, g, b};
+
+				vertices.push_back(vertex);
+			}
 		}
+		vertexCount = vertices.size();
+		computeBounds();
+	}
+
+	// Mesh of a meshSize^2 grid whose vertices are generated on the GPU straight into the vertex buffer, see NoiseCompute
+	explicit Mesh(int meshSize) {
+		this->meshSize = meshSize;
+		this->borderedSize = meshSize + 2;
+		vertexCount = static_cast<size_t>(meshSize) * meshSize;
+	}
+
+	// Mesh of an extracted surface, such as the Surface Nets output of a density chunk
+	Mesh(std::vector<Vertex> surfaceVertices, std::vector<uint32_t> surfaceIndices) :
+			vertices(std::move(surfaceVertices)), indices(std::move(surfaceIndices))
+	{
+		vertexCount = vertices.size();
+		indices = VertexCache::optimize<uint32_t>(indices, vertexCount);
+
 		// Adjust index data to be a multiple of 4 (required by WebGPU)
 		while (indices.size() % 4 != 0) {
 			indices.push_back(0);
 		}
-
+		indexCount = static_cast<uint32_t>(indices.size());
+		computeBounds();
 	}
 
 	~Mesh() {
 		if (validBuffers) {
 			vertexBuffer.destroy();
-			indexBuffer.destroy();
 			uniformBuffer.destroy();
 			vertexBuffer.release();
-			indexBuffer.release();
 			uniformBuffer.release();
 			bindGroup.release();
+			if (indexBuffer) {
+				indexBuffer.destroy();
+				indexBuffer.release();
+			}
+			if (lineIndexBuffer) {
+				lineIndexBuffer.destroy();
+				lineIndexBuffer.release();
+			}
 		}
 	}
 
-private:
+	// Sets the bounds from vertices
+	void computeBounds() {
+		if (vertices.empty()) {
+			return;
+		}
+		boundsMin = boundsMax = vertices.front().position;
+		for (const Vertex &vertex : vertices) {
+			boundsMin = glm::min(boundsMin, vertex.position);
+			boundsMax = glm::max(boundsMax, vertex.position);
+		}
+	}
 
-	// Add the two triangles of indices associated with the given row and column to the indices vector
-	static void addTriangleIndices(std::vector<uint16_t>& indices, int meshSize, int row, int col) {
+	/**
+	 * Frees the CPU copies of the vertices and indices once the buffers hold them, the counts and bounds stay.
+	 * @param keepHeightField Keeps the heights of a grid mesh in heightField first
+	 */
+	void releaseGeometry(bool keepHeightField) {
+		if (keepHeightField && indices.empty()) {
+			heightField.reserve(vertices.size());
+			for (const Vertex &vertex : vertices) {
+				heightField.push_back(vertex.position.y);
+			}
+		}
+		std::vector<Vertex>().swap(vertices);
+		std::vector<uint32_t>().swap(indices);
+	}
 
-		// Don't do for last column and row since triangles are made from the left and bottom
-		if (row < meshSize - 1 && col < meshSize - 1) {
-			// Indices
-			// --------------
-			uint16_t bottomLeft = row * meshSize + col;
-			uint16_t bottomRight = bottomLeft + 1;
-			uint16_t topLeft = (row + 1) * meshSize + col;
-			uint16_t topRight = topLeft + 1;
-			// These go from left to right, bottom to top
-			//  _________________________________
-			//  | \   2 | \   4 | \     | \     |
-			//  |   \   |   \   |   \   |   \   |
-			//  |  1  \ |  3  \ | ... \ |     \ |
-			//  ---------------------------------
-			// (Diagonal from top-left to bottom-right)
-
-			// First triangle
-			indices.push_back(bottomLeft);
-			indices.push_back(bottomRight);
-			indices.push_back(topLeft);
+	// Bytes per vertex in vertexBuffer
+	size_t vertexStride() const {
+		return format == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+	}
 
-			// Second triangle
-			indices.push_back(topLeft);
-			indices.push_back(bottomRight);
-			indices.push_back(topRight);
+	// vertices packed for a compact vertex buffer
+	std::vector<CompactVertex> compactVertices() const {
+		std::vector<CompactVertex> compact;
+		compact.reserve(vertices.size());
+		for (const Vertex &vertex : vertices) {
+			compact.push_back(CompactVertex::pack(vertex));
 		}
+		return compact;
+	}
 
+	// Smallest index format that reaches every one of vertexCount vertices
+	static wgpu::IndexFormat indexFormat(size_t vertexCount) {
+		return vertexCount <= size_t(UINT16_MAX) + 1 ? wgpu::IndexFormat::Uint16 : wgpu::IndexFormat::Uint32;
 	}
 
-	static void addLineIndices(std::vector<uint16_t>& indices, int vertsPerSide, int row, int col) {
+	/**
+	 * Indices of a grid of gridSize^2 row-major vertices, padded to a multiple of 4 bytes. The same for every chunk of
+	 * that size, so the grid meshes leave indices empty and draw with the buffer Terrain shares between them.
+	 * Index is uint16_t or uint32_t, see indexFormat.
+	 * @param count Set to the number of indices to draw, without the padding
+	 */
+	template<class Index>
+	static std::vector<Index> gridIndices(int gridSize, GridTopology topology, uint32_t &count) {
+		std::vector<Index> grid;
+		if (topology == GridTopology::Lines) {
+			grid.reserve((gridSize-1) * (gridSize-1) * 6);
+			for (int row = 0; row < gridSize; row++) {
+				for (int col = 0; col < gridSize; col++) {
+					Mesh::addLineIndices(grid, gridSize, row, col);
+				}
+			}
+		}
+		else {
+			// Strips instead of rows, so the vertices shared with the next row are still in the vertex cache
+			VertexCache::gridTriangles(grid, gridSize, VertexCache::gridStripWidth(VertexCache::DefaultCacheSize));
+		}
+		count = static_cast<uint32_t>(grid.size());
 
-		uint16_t bottomLeft = 0;
-		uint16_t bottomRight = 0;
-		uint16_t topLeft = 0;
-		uint16_t topRight = 0;
+		// Adjust index data to be a multiple of 4 (required by WebGPU)
+		while ((grid.size() * sizeof(Index)) % 4 != 0) {
+			grid.push_back(0);
+		}
+		return grid;
+	}
 
-		// Will always add a bottom line
-		indices.push_back(bottomLeft);
-		indices.push_back(bottomRight);
+	/**
+	 * Every edge of a triangle list once, as line list indices padded to a multiple of 4, for drawing a surface mesh
+	 * with the wire frame pipeline. Degenerate triangles, like the padding of indices, add no edges.
+	 */
+	template<class Index>
+	static std::vector<Index> edgeIndices(std::span<const Index> triangles) {
+		std::vector<Index> lines;
+		lines.reserve(triangles.size());
+		std::unordered_set<uint64_t> seen;
+		seen.reserve(triangles.size());
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				Index a = triangles[i + corner];
+				Index b = triangles[i + (corner + 1) % 3];
+				if (a != b && seen.insert(uint64_t(std::min(a, b)) << 32 | std::max(a, b)).second) {
+					lines.push_back(a);
+					lines.push_back(b);
+				}
+			}
+		}
+
+		// Adjust index data to be a multiple of 4 (required by WebGPU)
+		while (lines.size() % 4 != 0) {
+			lines.push_back(0);
+		}
+		return lines;
+	}
+
+private:
+
+	// Add the bottom, left and diagonal edge of the cell at the given row and column, and its right and top edge
+	// on the last column and row, matching the triangles of VertexCache::gridTriangles
+	template<class Index>
+	static void addLineIndices(std::vector<Index>& indices, int meshSize, int row, int col) {
+
+		if (row < meshSize - 1 && col < meshSize - 1) {
+			Index bottomLeft = row * meshSize + col;
+			Index bottomRight = bottomLeft + 1;
+			Index topLeft = (row + 1) * meshSize + col;
+			Index topRight = topLeft + 1;
 
-		// Only add left and center line if not last row
-		if (row < vertsPerSide - 1) {
-			// Left Line
-			indices.push_back(topLeft);
 			indices.push_back(bottomLeft);
+			indices.push_back(bottomRight);
+
+			indices.push_back(bottomLeft);
+			indices.push_back(topLeft);
 
-			// Center line
 			indices.push_back(bottomRight);
 			indices.push_back(topLeft);
 
-			// Only add right line at the end of the row, but not at the last row
-			if (col == vertsPerSide - 1) {
-				// Right Line
-				indices.push_back(topRight);
+			if (col == meshSize - 2) {
 				indices.push_back(bottomRight);
+				indices.push_back(topRight);
+			}
+			if (row == meshSize - 2) {
+				indices.push_back(topLeft);
+				indices.push_back(topRight);
 			}
-
 		}
 
 	}
@@ -285,52 +429,101 @@ private:
 class Chunk {
 public:
 
+	// Noise state a chunk regenerated at the same position reuses when the settings it depends on still match
+	struct Cache {
+		Noise::WarpField warpField; // Coarse domain warp offsets over the bordered grid, empty without domain warping
+		std::optional<Noise::OctaveLayers> octaveLayers; // Unweighted octave values, only kept when set
+	};
+
 	Chunk() = default;
 
-	Chunk(Noise noise, glm::ivec2 worldPosition, int chunkSize = DefaultChunkSize, bool wireFrame = false) :
-			worldPos(worldPosition)
+	/**
+	 * The target feature size comes from the noise detail settings: octaves with a wavelength below
+	 * featureSizeFalloff times the distance to detailCenter are faded out and culled.
+	 * @param cachedState Cache of a previous chunk at this position. With octave layers, edits of the gain, weighted
+	 * strength or amplitude only re-sum them.
+	 * @param large Takes the large coordinate path, chosen for the whole terrain as the two paths don't match bit for
+	 * bit and neighbouring chunks on different paths would leave cracks
+	 */
+	Chunk(Noise noise, glm::ivec2 worldPosition, int chunkSize = DefaultChunkSize, bool wireFrame = false, Cache cachedState = {}, bool large = false) :
+			worldPos(worldPosition), cache(std::move(cachedState))
 	{
 		chunkSeed = noise.desc.seed * worldPos.x + worldPos.y;
 
-		int borderedSize = chunkSize + 3; // Create an additional border around the chunk for normal calculations
+		// Far from the origin float world coordinates lose the lattice precision, the noise takes the chunk's integer origin instead
+		glm::i64vec2 chunkOrigin = glm::i64vec2(worldPos) * int64_t(chunkSize);
 
-		std::vector<glm::vec3> heightMap;
-		heightMap.reserve(borderedSize * borderedSize); // +1 to include the last row and column
+		// Normals straight from the noise gradient, without the border
+		if (noise.hasAnalyticDerivative() && !large) {
+			buildMesh(noise, chunkSize);
+			return;
+		}
 
-		std::vector<int> borderedIndices = generateIndicesWithBorder(borderedSize);
+		int borderedSize = chunkSize + 3; // Create an additional border around the chunk for normal calculations
 
-		// Fill heightmap with noise values using the world position accounting for the border
-		for (int row = 0; row < borderedSize; row++) {
+		// Evaluate the whole bordered grid in one batch, starting one sample before the chunk origin
+		std::vector<float> heights(borderedSize * borderedSize);
+		glm::vec2 gridOrigin = glm::vec2(worldPos * chunkSize - 1);
+		if (large) {
+			noise.fillGrid(heights, chunkOrigin, {-1.0f, -1.0f}, {1.0f, 1.0f}, borderedSize, borderedSize);
+		}
+		else if (cache.octaveLayers && noise.desc.fractal != Noise::Fractal::DomainWarp) {
+			noise.fillGrid(heights, gridOrigin, {1.0f, 1.0f}, borderedSize, borderedSize, *cache.octaveLayers);
+		}
+		else {
+			noise.updateWarpField(cache.warpField, gridOrigin, glm::vec2(float(borderedSize - 1)));
+			noise.fillGrid(heights, gridOrigin, {1.0f, 1.0f}, borderedSize, borderedSize, cache.warpField);
+		}
 
-			int worldPosY = (row-1) + (worldPos.y * chunkSize);
+		buildMesh(heights, chunkSize, wireFrame);
+	}
 
-			for (int col = 0; col < borderedSize; col++) {
+	// Chunk with the heights of a compiled noise graph
+	Chunk(const NoiseGraph &graph, glm::ivec2 worldPosition, int chunkSize = DefaultChunkSize, bool wireFrame = false) :
+			worldPos(worldPosition)
+	{
+		int borderedSize = chunkSize + 3;
 
-				int worldPosX = (col-1) + (worldPos.x * chunkSize);
+		std::vector<float> heights(borderedSize * borderedSize);
+		glm::vec2 gridOrigin = glm::vec2(worldPos * chunkSize - 1);
+		graph.fillGrid(heights, gridOrigin, {1.0f, 1.0f}, borderedSize, borderedSize);
 
-				float h = noise.eval({worldPosX, worldPosY});
-				heightMap.emplace_back(worldPosX, h, worldPosY);
+		buildMesh(heights, chunkSize, wireFrame);
+	}
 
+	/**
+	 * Chunk cut out of a tileable height map, such as SpectralNoise output, wrapping around its edges.
+	 * @param tile Row major tileSize^2 heights, one sample per world unit
+	 */
+	Chunk(std::span<const float> tile, int tileSize, glm::ivec2 worldPosition, int chunkSize = DefaultChunkSize, bool wireFrame = false) :
+			worldPos(worldPosition)
+	{
+		int borderedSize = chunkSize + 3;
+
+		std::vector<float> heights(borderedSize * borderedSize);
+		glm::ivec2 gridOrigin = worldPos * chunkSize - 1;
+		for (int row = 0; row < borderedSize; row++) {
+			int tileRow = ((gridOrigin.y + row) % tileSize + tileSize) % tileSize;
+			for (int col = 0; col < borderedSize; col++) {
+				int tileCol = ((gridOrigin.x + col) % tileSize + tileSize) % tileSize;
+				heights[row * borderedSize + col] = tile[static_cast<size_t>(tileRow) * tileSize + tileCol];
 			}
 		}
 
+		buildMesh(heights, chunkSize, wireFrame);
+	}
 
+	// Chunk whose heights NoiseCompute generates on the GPU, only the grid topology is built here
+	Chunk(glm::ivec2 worldPosition, int chunkSize) :
+			worldPos(worldPosition)
+	{
+		mesh = Mesh(chunkSize + 1);
+		mesh.origin = worldOrigin(chunkSize);
+	}
 
-//		for (int row = 0; row <= chunkSize; row++) {
-//
-//			int worldPosY = row + (worldPos.y * chunkSize);
-//
-//			for (int col = 0; col <= chunkSize; col++) {
-//
-//				int worldPosX = col + (worldPos.x * chunkSize);
-//
-//				float h = noise.eval({worldPosX, worldPosY});
-//				heightMap.emplace_back(worldPosX, h, worldPosY);
-//
-//			}
-//		}
-
-		mesh = Mesh(heightMap, borderedIndices, borderedSize, chunkSize + 1, wireFrame);
+	// World position of the first sample of the bordered grid, one before the chunk corner
+	glm::vec2 gridOrigin(int chunkSize) const {
+		return glm::vec2(worldPos * chunkSize - 1);
 	}
 
 	/**
@@ -377,8 +570,128 @@ public:
 	static constexpr int DefaultChunkSize = 32;
 	int chunkSeed = 0;
 	glm::ivec2 worldPos{};
+	Cache cache;
 	Mesh mesh;
 
+private:
+
+	// Builds the mesh from the bordered (chunkSize + 3)^2 grid of heights
+	void buildMesh(const std::vector<float> &heights, int chunkSize, bool wireFrame) {
+		int borderedSize = chunkSize + 3;
+
+		std::vector<glm::vec3> heightMap;
+		heightMap.reserve(borderedSize * borderedSize); // +1 to include the last row and column
+
+		std::vector<int> borderedIndices = generateIndicesWithBorder(borderedSize);
+
+		// Fill heightmap with noise values relative to the chunk origin accounting for the border
+		for (int row = 0; row < borderedSize; row++) {
+			for (int col = 0; col < borderedSize; col++) {
+				float h = heights[row * borderedSize + col];
+				heightMap.emplace_back(col - 1, h, row - 1);
+			}
+		}
+
+		mesh = Mesh(heightMap, borderedIndices, borderedSize, chunkSize + 1, wireFrame);
+		mesh.origin = worldOrigin(chunkSize);
+	}
+
+	// World position of the chunk corner
+	glm::dvec3 worldOrigin(int chunkSize) const {
+		return glm::dvec3(worldPos.x, 0.0, worldPos.y) * double(chunkSize);
+	}
+
+	// Builds the mesh from the (chunkSize + 1)^2 grid of heights and gradients
+	void buildMesh(const Noise &noise, int chunkSize) {
+		int meshSize = chunkSize + 1;
+
+		std::vector<glm::vec3> samples(meshSize * meshSize);
+		glm::vec2 gridOrigin = glm::vec2(worldPos * chunkSize);
+		if (cache.octaveLayers) {
+			noise.fillGridWithDerivative(samples, gridOrigin, {1.0f, 1.0f}, meshSize, meshSize, *cache.octaveLayers);
+		}
+		else {
+			noise.fillGridWithDerivative(samples, gridOrigin, {1.0f, 1.0f}, meshSize, meshSize);
+		}
+
+		std::vector<glm::vec3> heightMap;
+		std::vector<glm::vec2> gradients;
+		heightMap.reserve(samples.size());
+		gradients.reserve(samples.size());
+
+		for (int row = 0; row < meshSize; row++) {
+			for (int col = 0; col < meshSize; col++) {
+				glm::vec3 sample = samples[row * meshSize + col];
+				heightMap.emplace_back(col, sample.x, row);
+				gradients.emplace_back(sample.y, sample.z);
+			}
+		}
+
+		mesh = Mesh(heightMap, gradients, meshSize);
+		mesh.origin = worldOrigin(chunkSize);
+	}
+
+};
+
+
+/**
+ * Chunk of a 3D density field, for the overhangs and caves a height field can't hold. The density is the 3D noise
+ * less half its amplitude plus a falloff with height, solid where positive, so the surface stays within
+ * amplitude / (2 * heightGradient) of the ground height. Chunks stack vertically over a column of Chunk positions.
+ */
+class DensityChunk {
+public:
+
+	struct Settings {
+		float groundHeight = 0.0f; // Height of the surface where the noise sits at half its amplitude
+		float heightGradient = 0.5f; // Density lost per world unit of height, lower values carve deeper overhangs
+		int threads = 0; // Workers over the z slabs, 0 uses every hardware thread
+
+		// First and last vertical chunk index the surface can reach
+		glm::ivec2 chunkRange(float amplitude, int chunkSize) const {
+			float reach = 0.5f * amplitude / heightGradient;
+			return {int(glm::floor((groundHeight - reach) / float(chunkSize))), int(glm::floor((groundHeight + reach) / float(chunkSize)))};
+		}
+	};
+
+	DensityChunk() = default;
+
+	/**
+	 * Samples the density over the chunk and a one sample border, one z layer per task, and extracts the surface.
+	 * The border makes the surfaces of neighbouring chunks meet without seams.
+	 */
+	DensityChunk(const Noise &noise, glm::ivec3 worldPosition, Settings settings, int chunkSize = Chunk::DefaultChunkSize) :
+			worldPos(worldPosition)
+	{
+		int samples = chunkSize + 2;
+		size_t layerSize = static_cast<size_t>(samples) * samples;
+		std::vector<float> density(layerSize * samples);
+		glm::vec3 origin = glm::vec3(worldPos * chunkSize - 1);
+		float offset = 0.5f * noise.desc.amplitude;
+
+		Parallel::parallelFor(samples, Parallel::threadCount(settings.threads), [&](int z, int) {
+			std::span<float> layer(density.data() + z * layerSize, layerSize);
+			noise.fillGrid(layer, origin + glm::vec3(0.0f, 0.0f, float(z)), glm::vec3(1.0f), samples, samples, 1);
+			for (int y = 0; y < samples; y++) {
+				float bias = (settings.groundHeight - (origin.y + float(y))) * settings.heightGradient - offset;
+				for (int x = 0; x < samples; x++) {
+					layer[y * samples + x] += bias;
+				}
+			}
+		});
+
+		// Vertices relative to the chunk corner, one sample past the grid origin
+		SurfaceNets::Surface surface = SurfaceNets::extract(density, chunkSize, glm::vec3(-1.0f), settings.threads);
+		mesh = Mesh(std::move(surface.vertices), std::move(surface.indices));
+		mesh.origin = glm::dvec3(worldPos) * double(chunkSize);
+	}
+
+	bool empty() const {
+		return mesh.vertexCount == 0;
+	}
+
+	glm::ivec3 worldPos{};
+	Mesh mesh;
 };
 
 
@@ -405,6 +718,16 @@ const auto posCmp = [](const glm::ivec2& a, const glm::ivec2& b) {
 	}
 };
 
+const auto posCmp3 = [](const glm::ivec3& a, const glm::ivec3& b) {
+	if (a.x != b.x) {
+		return a.x < b.x;
+	}
+	if (a.y != b.y) {
+		return a.y < b.y;
+	}
+	return a.z < b.z;
+};
+
 const auto poiCmp = [](PointOfInterest a, PointOfInterest b) {
 	if (a.center != b.center) {
 		return posCmp(a.center, b.center);
@@ -483,6 +806,35 @@ public:
 
 
 
+/**
+ * Index buffer shared by every chunk mesh with the same grid, built once and never written again.
+ * Only the grid meshes use it, surface meshes keep their own indices.
+ */
+class GridIndexBuffer {
+public:
+
+	// Identifies a grid: chunkSize / 2^lod + 1 vertices per side, drawn as topology
+	struct Key {
+		int chunkSize;
+		int lod; // Halvings of the vertex resolution
+		Mesh::GridTopology topology;
+
+		auto operator<=>(const Key &) const = default;
+	};
+
+	wgpu::Buffer buffer = nullptr;
+	wgpu::IndexFormat format = wgpu::IndexFormat::Uint16; // Uint32 once the grid has more vertices than 16 bits reach
+	uint32_t count = 0; // Indices drawn, the buffer holds up to 3 more for the padding
+	uint64_t size = 0; // Bytes
+
+	explicit GridIndexBuffer(Key key);
+	~GridIndexBuffer();
+
+	GridIndexBuffer(const GridIndexBuffer &) = delete;
+	GridIndexBuffer &operator=(const GridIndexBuffer &) = delete;
+};
+
+
 class Terrain {
 
 public:
@@ -501,20 +853,42 @@ public:
 	// Total number of chunks = (2 * numVisibleChunks + 1)^2
 	static constexpr int DefaultLoadDistance = 0;
 	static constexpr glm::ivec2 DefaultCenter = {0, 0};
+	static constexpr float DefaultFeatureSizeFalloff = 1.0f / 256.0f; // Features below about a quarter degree are culled
+	static constexpr glm::dvec3 LightPosition = {50.0, 30.0, 0.0}; // World position of the point light
+
+	// What the chunk meshes keep on the CPU once their buffers are uploaded
+	enum class Residency {
+		Full, // The vertices and indices
+		GpuOnly, // The counts and bounds
+		GpuWithHeightField // The counts, bounds and the heights of the height field chunks for readChunkHeights
+	};
 	ChunkLoadStateManager loadManager;
 	bool regenerate = false;
 
 	std::map<glm::ivec2, Chunk, decltype(posCmp)> chunks;
+	std::map<glm::ivec3, DensityChunk, decltype(posCmp3)> densityChunks; // Replace chunks in density mode, empty ones are skipped
 
 
 	glm::ivec2 center{};
-	ShaderUniforms uniforms{};
+	ShaderUniforms uniforms{}; // Shared by every chunk, each chunk adds its translation from renderOrigin to the model matrix
+	glm::dvec3 renderOrigin{};
 //	Chunk chunk;
 private:
 
 
 	Noise noise;
+	std::optional<NoiseGraph> graph; // Replaces noise for the chunk heights when set
+	std::optional<SpectralNoise> spectral; // Replaces noise and graph for the chunk heights when set, see spectralTile
+	std::vector<float> spectralTile; // Map of spectral the chunks are cut out of, wrapping around its edges
+	std::optional<DensityChunk::Settings> density; // Columns of 3D density chunks instead of height fields when set, noise only
+	std::unique_ptr<NoiseCompute> compute; // Generates the supported noise chunks on the GPU when set
+	std::map<GridIndexBuffer::Key, GridIndexBuffer> gridIndexBuffers; // Shared by the chunks, see gridIndexBuffer
+	bool octaveLayerCache = true;
+	float featureSizeFalloff = DefaultFeatureSizeFalloff;
 	bool wireFrame{};
+	bool compactVertices = false; // Height field chunks get CompactVertex buffers
+	bool largeCoordinates = false; // Every noise chunk takes the large coordinate path, see needsLargeCoordinates
+	Residency residency = Residency::GpuWithHeightField;
 	int chunkSize{};
 	int numVisibleChunks{};
 
@@ -524,6 +898,8 @@ private:
 	wgpu::BindGroupLayout m_bindGroupLayout = nullptr;
 	wgpu::RenderPipeline m_pipeline = nullptr;
 	wgpu::RenderPipeline m_wireframePipeline = nullptr;
+	wgpu::RenderPipeline m_compactPipeline = nullptr; // Same as above for the CompactVertex layout
+	wgpu::RenderPipeline m_compactWireframePipeline = nullptr;
 
 	wgpu::BufferDescriptor bufferDesc{};
 
@@ -537,15 +913,53 @@ public:
 
 	explicit Terrain(Noise::Descriptor noiseDesc, glm::ivec2 centerChunkPos = DefaultCenter, int numVisibleChunks = DefaultLoadDistance, int chunkSize = Chunk::DefaultChunkSize, bool wireFrame = false);
 
+	explicit Terrain(NoiseGraph noiseGraph, glm::ivec2 centerChunkPos = DefaultCenter, int numVisibleChunks = DefaultLoadDistance, int chunkSize = Chunk::DefaultChunkSize, bool wireFrame = false);
+
 	void load();
 
 	// Updates the visible chunks list based on center position
 	void update(glm::ivec2 centerChunkPos);
 
 	void setNoise(Noise::Descriptor noiseDesc);
+	void setNoise(NoiseGraph noiseGraph); // Compiles the graph if needed
+	void setNoise(SpectralNoise spectralNoise); // Generates the tileable map the chunks are cut out of
 	void setWireFrame(bool wire);
 
+	// Keeps the unweighted octave values of every chunk, so gain, weighted strength and amplitude edits only re-sum them
+	void setOctaveLayerCache(bool enabled);
+
+	// Smallest kept noise wavelength per world unit of distance to the center chunk, 0 keeps every octave
+	void setFeatureSizeFalloff(float falloff);
+
+	// Switches the chunks to 3D density columns with overhangs and caves, std::nullopt goes back to height fields
+	void setDensity(std::optional<DensityChunk::Settings> settings);
+
+	// Generates the height field chunks on the GPU when the noise is supported, see NoiseCompute
+	void setGpuGeneration(bool enabled);
+
+	// Stores the height field chunks as CompactVertex instead of Vertex, density chunks keep Vertex
+	void setCompactVertices(bool enabled);
+
+	void setResidency(Residency mode);
+
+	/**
+	 * Heights of the chunk at pos for CPU consumers such as collision, row-major over the chunk's mesh. GPU generated
+	 * chunks are read back, done runs on a later device tick. Empty when no height field chunk is loaded at pos, or
+	 * when Residency::GpuOnly dropped the heights of a CPU chunk and there is no NoiseCompute to read them back.
+	 */
+	void readChunkHeights(glm::ivec2 pos, std::function<void(std::vector<float>)> done);
+
+	// Rebases the chunk model matrices and the light onto a new render origin, see Camera::rebase
+	void setRenderOrigin(glm::dvec3 origin);
+
 	bool isWireFrame();
+	bool isDensity() const;
+	bool isSpectral() const;
+	bool isGpuGeneration() const;
+	bool isOctaveLayerCache() const;
+	float getFeatureSizeFalloff() const;
+	bool isCompactVertices() const;
+	Residency getResidency() const;
 
 	void createRenderPipelines();
 	void terminateRenderPipeline();
@@ -553,11 +967,44 @@ public:
 	void render(wgpu::RenderPassEncoder &renderPass);
 
 
-	void initChunkBuffers(Chunk& chunk);
+	void initChunkBuffers(Mesh& mesh);
+
+	void initChunkUniforms(Mesh& mesh);
+
+	void initChunkBindGroup(Mesh& mesh);
+
+private:
+
+	// Throws when the chunk size is out of the grid index range or the device limits, see Application::limits
+	void checkChunkSize() const;
+
+	// Chunk at pos from the spectral tile or the graph if one is set, otherwise from noise
+	Chunk makeChunk(glm::ivec2 pos, Chunk::Cache cache = {});
+
+	// True when the height field chunks are generated by compute
+	bool usesCompute() const;
+
+	// True when chunks around centerChunkPos are past Noise::FloatPathRange, the path every chunk of the terrain takes
+	bool needsLargeCoordinates(glm::ivec2 centerChunkPos) const;
+
+	// Loads the chunk column at pos, the height field or the density chunks of the surface's vertical range
+	void loadColumn(glm::ivec2 pos, Chunk::Cache cache = {});
+
+	// Render pipeline of meshes with format, for the current wire frame setting
+	wgpu::RenderPipeline pipeline(VertexFormat format) const;
+
+	// The shared index buffer of key, built on first use
+	const GridIndexBuffer &gridIndexBuffer(GridIndexBuffer::Key key);
+
+	// Creates the GPU buffers and bind group of a freshly built mesh
+	void initMesh(Mesh& mesh);
+
+	// Model matrix and light position of mesh relative to renderOrigin, computed in double precision
+	void updateMeshUniforms(Mesh& mesh) const;
 
-	void initChunkUniforms(Chunk& chunk);
+	// Descriptor with the octave culling centered on the center chunk
+	Noise::Descriptor withDetail(Noise::Descriptor noiseDesc) const;
 
-	void initChunkBindGroup(Chunk& chunk);
 
 
 
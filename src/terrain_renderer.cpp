@@ -59,7 +59,7 @@ void TerrainRenderer::initChunkBuffers(Chunk& chunk) {
 	std::cout << "Vertex Buffer: " << chunk.mesh.vertexBuffer << std::endl;
 
 	// Create index buffer
-	indexBufferDesc.size = chunk.mesh.indices.size() * sizeof(uint16_t);
+	indexBufferDesc.size = chunk.mesh.indices.size() * sizeof(uint32_t);
 	chunk.mesh.indexBuffer = Application::device->createBuffer(indexBufferDesc);
 	// Upload index data to index buffer
 	Application::queue->writeBuffer(chunk.mesh.indexBuffer, 0, chunk.mesh.indices.data(), indexBufferDesc.size);
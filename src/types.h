@@ -8,6 +8,7 @@
 #include <webgpu/webgpu.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <array>
 
 
@@ -19,6 +20,47 @@ struct Vertex {
 //	glm::vec2 uv;
 };
 
+/*
+ * Height field vertex in 8 bytes instead of the 36 of Vertex, see Terrain::setCompactVertices. The position is the
+ * local grid index and a half float height, the normal is octahedral encoded around +y and the color is derived from
+ * the grid index in static_triangle.wgsl.
+ */
+struct CompactVertex {
+	uint16_t col; // Local x
+	uint16_t row; // Local z
+	uint16_t height; // IEEE half float
+	std::array<int8_t, 2> normal; // Octahedral, snorm
+
+	static CompactVertex pack(const Vertex &vertex) {
+		glm::vec3 n = vertex.normal / (glm::abs(vertex.normal.x) + glm::abs(vertex.normal.y) + glm::abs(vertex.normal.z));
+		glm::vec2 octahedral(n.x, n.z);
+		// The lower hemisphere folds over the diagonals
+		if (n.y < 0.0f) {
+			glm::vec2 sign(octahedral.x >= 0.0f ? 1.0f : -1.0f, octahedral.y >= 0.0f ? 1.0f : -1.0f);
+			octahedral = (1.0f - glm::abs(glm::vec2(octahedral.y, octahedral.x))) * sign;
+		}
+
+		CompactVertex compact{};
+		compact.col = static_cast<uint16_t>(vertex.position.x);
+		compact.row = static_cast<uint16_t>(vertex.position.z);
+		compact.height = static_cast<uint16_t>(glm::packHalf1x16(vertex.position.y));
+		compact.normal[0] = static_cast<int8_t>(glm::round(glm::clamp(octahedral.x, -1.0f, 1.0f) * 127.0f));
+		compact.normal[1] = static_cast<int8_t>(glm::round(glm::clamp(octahedral.y, -1.0f, 1.0f) * 127.0f));
+		return compact;
+	}
+
+	float unpackHeight() const {
+		return glm::unpackHalf1x16(height);
+	}
+};
+static_assert(sizeof(CompactVertex) == 8, "CompactVertex must match the compact vertex buffer layout");
+
+// Layout of a mesh's vertex buffer
+enum class VertexFormat {
+	Standard, // Vertex
+	Compact // CompactVertex, height field grids only
+};
+
 ///*
 // * A structure that describes the data layout in the vertex buffer,
 // * used by loadGeometryFromObj and used it in `sizeof` and `offsetof`
@@ -40,6 +82,8 @@ struct ShaderUniforms {
 	glm::mat4x4 viewMatrix;
 	glm::mat4x4 modelMatrix;
 	std::array<float, 4> color;
+	std::array<float, 4> lightPosition; // Relative to the render origin like the model translation
+	std::array<float, 4> grid; // x: vertices per side of the mesh, for the colors of compact vertices
 };
 
 
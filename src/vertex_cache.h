@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+ * Triangle orders for the post-transform vertex cache, and a simulator to measure them.
+ *
+ * A grid drawn row by row needs a whole row of vertices cached to reuse them on the next row, so with 65 vertices per
+ * row nearly every vertex is transformed twice. gridTriangles walks the grid in vertical strips narrow enough for two
+ * strip rows to stay cached, optimize reorders any other triangle list with Tom Forsyth's linear speed algorithm.
+ * A strip too wide for the cache is worse than the row order, as its two rows evict each other, while a narrower one
+ * only loses a little, so the strips are sized for the smallest cache in use. On a 65 x 65 grid strips for 8 entries
+ * have an ACMR of 0.68 under any larger cache, strips for 16 reach 0.59 there but 1.14 under 8, against 1.02 for rows.
+ * See vertex_cache_report for the numbers.
+ *
+ * ACMR is the average cache misses per triangle, 0.5 at best on a grid, ATVR the misses per vertex, 1 at best.
+ */
+namespace VertexCache {
+
+	// The cache size the meshes are ordered for, the smallest of the GPUs in use so the strips never outgrow the cache
+	static constexpr int DefaultCacheSize = 8;
+
+	enum class Policy {
+		FIFO, // Hits don't move a vertex, like most hardware caches
+		LRU
+	};
+
+	struct Stats {
+		uint64_t triangles = 0;
+		uint64_t vertices = 0; // Distinct vertices referenced
+		uint64_t misses = 0; // Vertex shader invocations
+
+		double acmr() const { return triangles ? double(misses) / double(triangles) : 0.0; }
+		double atvr() const { return vertices ? double(misses) / double(vertices) : 0.0; }
+	};
+
+	// Replays indices through a cache of cacheSize vertices
+	template<class Index>
+	Stats simulate(std::span<const Index> indices, size_t vertexCount, int cacheSize, Policy policy) {
+		Stats stats;
+		stats.triangles = indices.size() / 3;
+
+		std::vector<bool> seen(vertexCount);
+		std::vector<uint32_t> cache; // Most recent first
+		cache.reserve(cacheSize + 1);
+
+		for (size_t i = 0; i < stats.triangles * 3; i++) {
+			uint32_t vertex = indices[i];
+			if (!seen[vertex]) {
+				seen[vertex] = true;
+				stats.vertices++;
+			}
+
+			auto cached = std::find(cache.begin(), cache.end(), vertex);
+			if (cached != cache.end()) {
+				if (policy == Policy::LRU) {
+					std::rotate(cache.begin(), cached, cached + 1);
+				}
+				continue;
+			}
+
+			stats.misses++;
+			cache.insert(cache.begin(), vertex);
+			if (cache.size() > static_cast<size_t>(cacheSize)) {
+				cache.pop_back();
+			}
+		}
+		return stats;
+	}
+
+	// Columns per strip of gridTriangles, the W + 1 vertices of a strip row and of the row above it have to fit
+	inline int gridStripWidth(int cacheSize) {
+		return std::max(1, cacheSize / 2 - 1);
+	}
+
+	/**
+	 * Two triangles per cell of a grid of gridSize^2 row-major vertices, bottom to top through vertical strips of
+	 * stripWidth columns. A stripWidth of gridSize - 1 or more is the plain row order.
+	 */
+	template<class Index>
+	void gridTriangles(std::vector<Index> &indices, int gridSize, int stripWidth) {
+		indices.reserve(indices.size() + static_cast<size_t>(gridSize - 1) * (gridSize - 1) * 6);
+		for (int stripBegin = 0; stripBegin < gridSize - 1; stripBegin += stripWidth) {
+			int stripEnd = std::min(stripBegin + stripWidth, gridSize - 1);
+			for (int row = 0; row < gridSize - 1; row++) {
+				for (int col = stripBegin; col < stripEnd; col++) {
+					Index bottomLeft = row * gridSize + col;
+					Index bottomRight = bottomLeft + 1;
+					Index topLeft = (row + 1) * gridSize + col;
+					Index topRight = topLeft + 1;
+					// These go from left to right, bottom to top
+					//  _________________________________
+					//  | \   2 | \   4 | \     | \     |
+					//  |   \   |   \   |   \   |   \   |
+					//  |  1  \ |  3  \ | ... \ |     \ |
+					//  ---------------------------------
+					// (Diagonal from top-left to bottom-right)
+
+					// First triangle
+					indices.push_back(bottomLeft);
+					indices.push_back(bottomRight);
+					indices.push_back(topLeft);
+
+					// Second triangle
+					indices.push_back(topLeft);
+					indices.push_back(bottomRight);
+					indices.push_back(topRight);
+				}
+			}
+		}
+	}
+
+	namespace Forsyth {
+		static constexpr float CacheDecayPower = 1.5f;
+		static constexpr float LastTriangleScore = 0.75f;
+		static constexpr float ValenceBoostScale = 2.0f;
+		static constexpr float ValenceBoostPower = 0.5f;
+
+		// Higher is emitted sooner: recently used vertices, and vertices with few triangles left to finish them off
+		inline float vertexScore(int cachePosition, int remaining, int cacheSize) {
+			if (remaining == 0) {
+				return -1.0f;
+			}
+			float score = 0.0f;
+			if (cachePosition >= 0) {
+				if (cachePosition < 3) {
+					score = LastTriangleScore; // In the last triangle, which avoids favouring one of its vertices
+				}
+				else {
+					float scaler = 1.0f / float(cacheSize - 3);
+					score = std::pow(1.0f - float(cachePosition - 3) * scaler, CacheDecayPower);
+				}
+			}
+			return score + ValenceBoostScale * std::pow(float(remaining), -ValenceBoostPower);
+		}
+	}
+
+	/**
+	 * Reorders the triangles of indices for a LRU cache of cacheSize vertices with Tom Forsyth's algorithm, "Linear-Speed
+	 * Vertex Cache Optimisation". The triangles keep their winding, trailing indices short of a triangle are dropped.
+	 */
+	template<class Index>
+	std::vector<Index> optimize(std::span<const Index> indices, size_t vertexCount, int cacheSize = DefaultCacheSize) {
+		size_t triangleCount = indices.size() / 3;
+		cacheSize = std::max(cacheSize, 4);
+
+		// Triangles of every vertex, packed by vertex
+		std::vector<uint32_t> remaining(vertexCount);
+		for (size_t i = 0; i < triangleCount * 3; i++) {
+			remaining[indices[i]]++;
+		}
+		std::vector<uint32_t> firstTriangle(vertexCount + 1);
+		for (size_t v = 0; v < vertexCount; v++) {
+			firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+		}
+		std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+		std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++) {
+			vertexTriangles[filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++) {
+			vertexScores[v] = Forsyth::vertexScore(-1, int(remaining[v]), cacheSize);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++) {
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		}
+
+		std::vector<Index> out;
+		out.reserve(triangleCount * 3);
+		std::vector<uint32_t> cache; // Most recent first, 3 past cacheSize while a triangle is added
+		cache.reserve(cacheSize + 3);
+		size_t scan = 0; // Every triangle before it is emitted
+
+		int64_t best = -1;
+		for (size_t n = 0; n < triangleCount; n++) {
+			// Nothing in the cache scores, start again from the first triangle not emitted
+			if (best < 0) {
+				while (emitted[scan]) {
+					scan++;
+				}
+				best = static_cast<int64_t>(scan);
+				for (size_t t = scan; t < triangleCount; t++) {
+					if (!emitted[t] && triangleScores[t] > triangleScores[best]) {
+						best = static_cast<int64_t>(t);
+					}
+				}
+			}
+
+			emitted[best] = true;
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[best * 3 + corner];
+				out.push_back(static_cast<Index>(vertex));
+
+				// Drop the triangle from the vertex's remaining ones
+				uint32_t *begin = vertexTriangles.data() + firstTriangle[vertex];
+				uint32_t *end = begin + remaining[vertex];
+				std::iter_swap(std::find(begin, end, uint32_t(best)), end - 1);
+				remaining[vertex]--;
+
+				auto cached = std::find(cache.begin(), cache.end(), vertex);
+				if (cached != cache.end()) {
+					cache.erase(cached);
+				}
+				cache.insert(cache.begin(), vertex);
+			}
+
+			// Rescore the cached vertices and their triangles, and pick the best of those
+			for (size_t i = 0; i < cache.size(); i++) {
+				uint32_t vertex = cache[i];
+				cachePosition[vertex] = i < static_cast<size_t>(cacheSize) ? int(i) : -1;
+				float score = Forsyth::vertexScore(cachePosition[vertex], int(remaining[vertex]), cacheSize);
+				float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+				for (uint32_t j = 0; j < remaining[vertex]; j++) {
+					triangleScores[vertexTriangles[firstTriangle[vertex] + j]] += delta;
+				}
+			}
+			while (cache.size() > static_cast<size_t>(cacheSize)) {
+				cache.pop_back();
+			}
+
+			best = -1;
+			float bestScore = -1.0f;
+			for (uint32_t vertex : cache) {
+				for (uint32_t j = 0; j < remaining[vertex]; j++) {
+					uint32_t t = vertexTriangles[firstTriangle[vertex] + j];
+					if (triangleScores[t] > bestScore) {
+						bestScore = triangleScores[t];
+						best = t;
+					}
+				}
+			}
+		}
+		return out;
+	}
+}
@@ -0,0 +1,105 @@
+#include "vertex_cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * ACMR and ATVR of the chunk grid triangle orders under simulated post-transform vertex caches.
+ *
+ *   rows     the plain row order
+ *   strips   the order the terrain draws, strips for VertexCache::DefaultCacheSize
+ *   forsyth  the row order run through VertexCache::optimize for the simulated cache size
+ *
+ * Usage: vertex_cache_report [--grid N] [--cache N]... [--policy fifo|lru|both]
+ * --grid is the vertices per side, chunk size + 1. --cache can repeat, the default is 8, 16 and 32.
+ */
+
+namespace {
+
+	struct Settings {
+		int grid = 65;
+		std::vector<int> caches;
+		bool fifo = true;
+		bool lru = true;
+	};
+
+	struct Order {
+		const char *name;
+		std::vector<uint32_t> indices;
+	};
+
+	bool parse(int argc, char **argv, Settings &settings) {
+		for (int i = 1; i < argc; i++) {
+			bool hasValue = i + 1 < argc;
+			if (std::strcmp(argv[i], "--grid") == 0 && hasValue) {
+				settings.grid = std::max(2, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--cache") == 0 && hasValue) {
+				settings.caches.push_back(std::max(4, std::atoi(argv[++i])));
+			}
+			else if (std::strcmp(argv[i], "--policy") == 0 && hasValue) {
+				std::string policy = argv[++i];
+				settings.fifo = policy == "fifo" || policy == "both";
+				settings.lru = policy == "lru" || policy == "both";
+				if (!settings.fifo && !settings.lru) {
+					std::fprintf(stderr, "Unknown policy %s\n", policy.c_str());
+					return false;
+				}
+			}
+			else {
+				std::fprintf(stderr, "Usage: %s [--grid N] [--cache N]... [--policy fifo|lru|both]\n", argv[0]);
+				return false;
+			}
+		}
+		if (settings.caches.empty()) {
+			settings.caches = {8, 16, 32};
+		}
+		return true;
+	}
+}
+
+int main(int argc, char **argv) {
+	Settings settings;
+	if (!parse(argc, argv, settings)) {
+		return 1;
+	}
+
+	size_t vertexCount = static_cast<size_t>(settings.grid) * settings.grid;
+	std::vector<uint32_t> rows;
+	VertexCache::gridTriangles(rows, settings.grid, settings.grid - 1);
+	std::vector<uint32_t> strips;
+	VertexCache::gridTriangles(strips, settings.grid, VertexCache::gridStripWidth(VertexCache::DefaultCacheSize));
+
+	std::printf("Vertex cache report, %dx%d grid, %zu triangles, %zu vertices\n\n", settings.grid, settings.grid, rows.size() / 3, vertexCount);
+	std::printf("%-8s %6s %-8s %8s %8s %10s %12s\n", "policy", "cache", "order", "ACMR", "ATVR", "misses", "vs rows");
+
+	for (VertexCache::Policy policy : {VertexCache::Policy::FIFO, VertexCache::Policy::LRU}) {
+		bool fifo = policy == VertexCache::Policy::FIFO;
+		if ((fifo && !settings.fifo) || (!fifo && !settings.lru)) {
+			continue;
+		}
+
+		for (int cacheSize : settings.caches) {
+			Order orders[] = {
+					{"rows", rows},
+					{"strips", strips},
+					{"forsyth", VertexCache::optimize<uint32_t>(rows, vertexCount, cacheSize)},
+			};
+
+			uint64_t rowMisses = 0;
+			for (const Order &order : orders) {
+				VertexCache::Stats stats = VertexCache::simulate<uint32_t>(order.indices, vertexCount, cacheSize, policy);
+				if (rowMisses == 0) {
+					rowMisses = stats.misses;
+				}
+				double change = 100.0 * (double(stats.misses) / double(rowMisses) - 1.0);
+				std::printf("%-8s %6d %-8s %8.3f %8.3f %10llu %+11.1f%%\n", fifo ? "FIFO" : "LRU", cacheSize, order.name,
+						stats.acmr(), stats.atvr(), static_cast<unsigned long long>(stats.misses), change);
+			}
+		}
+	}
+	return 0;
+}